@@ -3,6 +3,19 @@ REM Build Everything
 
 ECHO "Building everything..."
 
+REM Scalar kernel check
+REM Checks the scalar path against the same hash as the SIMD path. The batch transforms are in the engine, so it is built with SIMD disabled too, then both are cleaned for the normal build.
+make -f "makefile.library.windows.mak" all ASSEMBLY="engine" ADDL_INC_FLAGS="-Iengine\include -DSIREN_SIMD_DISABLE" ADDL_LINK_FLAGS="-luser32 -lSDL2 -lSDL2_ttf -Lengine/lib/windows"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+make -f "makefile.executable.windows.mak" all ASSEMBLY="math-bench" ADDL_INC_FLAGS="-Iengine/src -Iengine/include -DSIREN_SIMD_DISABLE" ADDL_LINK_FLAGS=""
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+bin\math-bench.exe --check-kernels
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+make -f "makefile.executable.windows.mak" clean ASSEMBLY="math-bench"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+make -f "makefile.library.windows.mak" clean ASSEMBLY="engine"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
 REM Engine
 make -f "makefile.library.windows.mak" all ASSEMBLY="engine" ADDL_INC_FLAGS="-Iengine\include" ADDL_LINK_FLAGS="-luser32 -lSDL2 -lSDL2_ttf -Lengine/lib/windows"
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
@@ -11,4 +24,26 @@ REM Sandbox
 make -f "makefile.executable.windows.mak" all ASSEMBLY="sandbox" ADDL_INC_FLAGS="-Iengine/src" ADDL_LINK_FLAGS=""
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
 
+REM Benchmark
+make -f "makefile.executable.windows.mak" all ASSEMBLY="sandbox-bench" ADDL_INC_FLAGS="-Iengine/src -Iengine/include" ADDL_LINK_FLAGS="-lSDL2 -Lengine/lib/windows"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Math benchmark
+make -f "makefile.executable.windows.mak" all ASSEMBLY="math-bench" ADDL_INC_FLAGS="-Iengine/src -Iengine/include" ADDL_LINK_FLAGS=""
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+bin\math-bench.exe --check-kernels
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Log decoder
+make -f "makefile.executable.windows.mak" all ASSEMBLY="log-decoder" ADDL_INC_FLAGS="-Iengine/src" ADDL_LINK_FLAGS=""
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Resource packer
+make -f "makefile.executable.windows.mak" all ASSEMBLY="siren-pack" ADDL_INC_FLAGS="-Iengine/src" ADDL_LINK_FLAGS=""
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Asset cooker
+make -f "makefile.executable.windows.mak" all ASSEMBLY="siren-cook" ADDL_INC_FLAGS="-Iengine/src" ADDL_LINK_FLAGS=""
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
 ECHO "All assemblies built successfully."
\ No newline at end of file
@@ -11,4 +11,24 @@ REM Testbed
 make -f "makefile.executable.windows.mak" clean ASSEMBLY="sandbox"
 IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
 
+REM Benchmark
+make -f "makefile.executable.windows.mak" clean ASSEMBLY="sandbox-bench"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Math benchmark
+make -f "makefile.executable.windows.mak" clean ASSEMBLY="math-bench"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Log decoder
+make -f "makefile.executable.windows.mak" clean ASSEMBLY="log-decoder"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Resource packer
+make -f "makefile.executable.windows.mak" clean ASSEMBLY="siren-pack"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
+REM Asset cooker
+make -f "makefile.executable.windows.mak" clean ASSEMBLY="siren-cook"
+IF %ERRORLEVEL% NEQ 0 (echo Error:%ERRORLEVEL% && exit)
+
 ECHO "All assemblies cleaned successfully."
\ No newline at end of file
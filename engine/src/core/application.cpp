@@ -3,6 +3,11 @@
 #include "core/logger.h"
 #include "core/input.h"
 #include "core/resource.h"
+#include "core/profiler.h"
+#include "core/job.h"
+#include "core/arena.h"
+#include "core/memory.h"
+#include "core/asset.h"
 #include "renderer/renderer.h"
 #include "renderer/font.h"
 
@@ -11,22 +16,49 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cmath>
 
-static const uint64_t FRAME_TIME = (uint64_t)(1000.0 / 60.0);
+static const uint32_t DEFAULT_TARGET_FPS = 60;
+static const uint32_t DEFAULT_MAX_UPDATES_PER_FRAME = 5;
 
 struct Application {
     uint32_t fps;
     siren::MouseMode mouse_mode;
 
+    siren::FramePacing frame_pacing;
+    uint32_t target_fps;
+    uint32_t background_fps;
+    bool is_minimized;
+    bool is_focused;
+
+    float fixed_timestep;
+    uint32_t max_updates_per_frame;
+
+    bool headless;
+    uint32_t frame_limit;
+    float fixed_delta;
+
+    float memory_report_interval;
+
     bool (*init)();
     bool (*update)(float delta);
-    bool (*render)();
+    bool (*render)(float alpha);
+};
+
+// Tracks how long a 1ms sleep actually takes so that the pacer knows when to stop sleeping and start spinning
+struct SleepEstimate {
+    double estimate;
+    double mean;
+    double m2;
+    uint64_t count;
 };
 
 static bool initialized = false;
 static Application app;
+static SleepEstimate sleep_estimate;
 
 siren::Key input_sdlk_to_key(SDL_Keycode key);
+void application_wait_until(uint64_t target_time);
 
 SIREN_API bool siren::application_create(siren::ApplicationConfig config) {
     if (initialized) {
@@ -34,12 +66,25 @@ SIREN_API bool siren::application_create(siren::ApplicationConfig config) {
         return false;
     }
 
-    logger_init();
+    logger_init(config.binary_log);
+    profiler_init();
+    SIREN_PROFILE_SCOPE("application_create");
 
     // Get info out of config
     app.init = config.init;
     app.update = config.update;
     app.render = config.render;
+    app.frame_pacing = config.frame_pacing;
+    app.target_fps = config.target_fps == 0 ? DEFAULT_TARGET_FPS : config.target_fps;
+    app.background_fps = config.background_fps;
+    app.is_minimized = false;
+    app.is_focused = true;
+    app.fixed_timestep = config.fixed_timestep;
+    app.max_updates_per_frame = config.max_updates_per_frame == 0 ? DEFAULT_MAX_UPDATES_PER_FRAME : config.max_updates_per_frame;
+    app.headless = config.headless;
+    app.frame_limit = config.frame_limit;
+    app.fixed_delta = config.fixed_delta;
+    app.memory_report_interval = config.memory_report_interval;
 
     // Check to make sure app config was valid
     if (!app.init || !app.update || !app.render) {
@@ -48,8 +93,18 @@ SIREN_API bool siren::application_create(siren::ApplicationConfig config) {
     }
 
     // Init SDL
+    if (app.headless) {
+        // Prefer a driver that never touches the display. The renderer falls back to a hidden window if this can't make a GL context.
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+    }
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        SIREN_ERROR("SDL failed to initialize: %s", SDL_GetError());
+        if (app.headless) {
+            SIREN_WARN("Offscreen video driver unavailable (%s). Falling back to the default driver.", SDL_GetError());
+            SDL_SetHint(SDL_HINT_VIDEODRIVER, "");
+        }
+        if (!app.headless || SDL_Init(SDL_INIT_VIDEO) < 0) {
+            SIREN_ERROR("SDL failed to initialize: %s", SDL_GetError());
+        }
     }
 
     if (TTF_Init() == -1) {
@@ -57,12 +112,30 @@ SIREN_API bool siren::application_create(siren::ApplicationConfig config) {
     }
 
     // Init subsystems
+    job_system_init(config.job_worker_count);
     resource_set_base_path(config.resource_path);
+    if (config.resource_archive != NULL && !resource_mount_archive(config.resource_archive)) {
+        return false;
+    }
+    resource_set_cache_path(config.cache_path);
     input_init();
+    asset_system_init((uint64_t)config.vram_budget_mb << 20, (uint64_t)config.ram_budget_mb << 20);
+
+    // Headless runs never swap, so they always use 0
+    int swap_interval = 0;
+    if (!app.headless && app.frame_pacing == FRAME_PACING_VSYNC) {
+        swap_interval = 1;
+    } else if (!app.headless && app.frame_pacing == FRAME_PACING_ADAPTIVE_VSYNC) {
+        swap_interval = -1;
+    }
     if(!renderer_init((RendererConfig) {
         .window_name = config.name,
         .screen_size = config.screen_size,
-        .window_size = config.window_size
+        .window_size = config.window_size,
+        .swap_interval = swap_interval,
+        .headless = app.headless,
+        .threaded = config.threaded_renderer,
+        .upload_budget = config.asset_upload_budget
     })) {
         return false;
     }
@@ -74,6 +147,13 @@ SIREN_API bool siren::application_create(siren::ApplicationConfig config) {
 
     app.mouse_mode = MOUSE_MODE_VISIBLE;
 
+    sleep_estimate = (SleepEstimate) {
+        .estimate = 5e-3,
+        .mean = 5e-3,
+        .m2 = 0.0,
+        .count = 1
+    };
+
     initialized = true;
 
     return true;
@@ -81,76 +161,200 @@ SIREN_API bool siren::application_create(siren::ApplicationConfig config) {
 
 SIREN_API bool siren::application_run() {
     bool is_running = true;
-    uint64_t last_time = SDL_GetTicks();
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t last_time = SDL_GetPerformanceCounter();
+    uint64_t next_frame_time = last_time;
     uint64_t last_second = last_time;
+    uint64_t last_memory_report = last_time;
     uint32_t frames = 0;
+    uint32_t total_frames = 0;
     float delta = 0.0f;
+    float accumulator = 0.0f;
+    float alpha = 1.0f;
+    bool input_consumed = true;
 
     while (is_running) {
         // Timekeep
-        uint64_t current_time = SDL_GetTicks();
-        while (current_time - last_time < FRAME_TIME) {
-            current_time = SDL_GetTicks();
+        bool is_throttled = app.background_fps != 0 && (app.is_minimized || !app.is_focused);
+        uint32_t paced_fps = 0;
+        if (app.headless) {
+            // Headless runs go as fast as possible
+        } else if (is_throttled) {
+            paced_fps = app.background_fps;
+        } else if (app.frame_pacing == FRAME_PACING_FIXED) {
+            paced_fps = app.target_fps;
+        }
+
+        if (paced_fps != 0) {
+            uint64_t frame_period = frequency / paced_fps;
+            next_frame_time += frame_period;
+            uint64_t now = SDL_GetPerformanceCounter();
+            // If we've fallen more than a frame behind, don't try to catch up by rushing frames
+            if (now > next_frame_time + frame_period) {
+                next_frame_time = now;
+            }
+            application_wait_until(next_frame_time);
+        }
+
+        uint64_t current_time = SDL_GetPerformanceCounter();
+        if (paced_fps == 0) {
+            next_frame_time = current_time;
         }
 
-        delta = (float)(current_time - last_time) / 1000.0f;
+        float frame_time = (float)((double)(current_time - last_time) / (double)frequency);
         last_time = current_time;
+        // The profiler always sees the real frame time, even when the game is given a fixed one
+        delta = app.fixed_delta > 0.0f ? app.fixed_delta : frame_time;
 
-        if (current_time - last_second >= 1000) {
+        if (current_time - last_second >= frequency) {
             app.fps = frames;
             frames = 0;
-            last_second += 1000;
+            last_second += frequency;
+            if (current_time - last_second >= frequency) {
+                last_second = current_time;
+            }
+        }
+
+        if (app.memory_report_interval > 0.0f && current_time - last_memory_report >= (uint64_t)(app.memory_report_interval * (double)frequency)) {
+            memory_log_report();
+            last_memory_report = current_time;
         }
 
         frames++;
+        profiler_frame_end(frame_time);
+        SIREN_PROFILE_SCOPE("application_frame");
+        arena_frame_reset();
 
         // Poll events
-        input_update();
-        SDL_Event e;
-        while (SDL_PollEvent(&e)) {
-            switch (e.type) {
-                case SDL_QUIT:
-                    is_running = false;
-                    break;
-                case SDL_KEYDOWN:
-                case SDL_KEYUP:
-                    input_process_key(input_sdlk_to_key(e.key.keysym.sym), e.type == SDL_KEYDOWN);
-                    break;
-                case SDL_MOUSEBUTTONDOWN:
-                case SDL_MOUSEBUTTONUP:
-                    // SDL mousebuttons range from 1 to 3
-                    input_process_mouse_button((MouseButton)(e.button.button - 1), e.type == SDL_MOUSEBUTTONDOWN);
-                    break;
-                case SDL_MOUSEMOTION:
-                    input_process_mouse_motion(ivec2(e.motion.x, e.motion.y), ivec2(e.motion.xrel, e.motion.yrel));
+        {
+            SIREN_PROFILE_SCOPE("poll_events");
+            // If no update ran last frame, keep the input state around so that presses aren't missed
+            if (input_consumed) {
+                input_update();
+            }
+            SDL_Event e;
+            while (SDL_PollEvent(&e)) {
+                switch (e.type) {
+                    case SDL_QUIT:
+                        is_running = false;
+                        break;
+                    case SDL_WINDOWEVENT:
+                        switch (e.window.event) {
+                            case SDL_WINDOWEVENT_MINIMIZED:
+                                app.is_minimized = true;
+                                break;
+                            case SDL_WINDOWEVENT_RESTORED:
+                            case SDL_WINDOWEVENT_MAXIMIZED:
+                            case SDL_WINDOWEVENT_SHOWN:
+                                app.is_minimized = false;
+                                break;
+                            case SDL_WINDOWEVENT_FOCUS_GAINED:
+                                app.is_focused = true;
+                                break;
+                            case SDL_WINDOWEVENT_FOCUS_LOST:
+                                app.is_focused = false;
+                                break;
+                        }
+                        break;
+                    case SDL_KEYDOWN:
+                    case SDL_KEYUP:
+                        input_process_key(input_sdlk_to_key(e.key.keysym.sym), e.type == SDL_KEYDOWN, e.key.timestamp);
+                        break;
+                    case SDL_MOUSEBUTTONDOWN:
+                    case SDL_MOUSEBUTTONUP:
+                        // SDL mousebuttons range from 1 to 3
+                        input_process_mouse_button((MouseButton)(e.button.button - 1), e.type == SDL_MOUSEBUTTONDOWN, e.button.timestamp);
+                        break;
+                    case SDL_MOUSEMOTION:
+                        input_process_mouse_motion(ivec2(e.motion.x, e.motion.y), ivec2(e.motion.xrel, e.motion.yrel), e.motion.timestamp);
+                        break;
+                    case SDL_MOUSEWHEEL:
+                        input_process_mouse_wheel(e.wheel.y, e.wheel.timestamp);
+                        break;
+                }
+            }
+        }
+
+        // Update
+        {
+            SIREN_PROFILE_SCOPE("update");
+            if (app.fixed_timestep > 0.0f) {
+                accumulator += delta;
+                // Drop any backlog we can't work through this frame so that a slow frame can't snowball
+                float max_accumulator = app.fixed_timestep * (float)app.max_updates_per_frame;
+                if (accumulator > max_accumulator) {
+                    accumulator = max_accumulator;
+                }
+
+                uint32_t update_count = 0;
+                while (accumulator >= app.fixed_timestep) {
+                    // Input edges and mouse motion belong to the first update of the frame only
+                    if (update_count != 0) {
+                        input_update();
+                    }
+                    if (!app.update(app.fixed_timestep)) {
+                        SIREN_ERROR("Game update failed. Shutting down.");
+                        is_running = false;
+                        break;
+                    }
+                    accumulator -= app.fixed_timestep;
+                    update_count++;
+                }
+                if (!is_running) {
                     break;
-                case SDL_MOUSEWHEEL:
-                    input_process_mouse_wheel(e.motion.y);
+                }
+
+                input_consumed = update_count != 0;
+                alpha = accumulator / app.fixed_timestep;
+            } else {
+                if (!app.update(delta)) {
+                    SIREN_ERROR("Game update failed. Shutting down.");
+                    is_running = false;
                     break;
+                }
+                alpha = 1.0f;
+            }
+            if (input_consumed) {
+                input_mark_consumed();
             }
         }
 
-        if (!app.update(delta)) {
-            SIREN_ERROR("Game update failed. Shutting down.");
-            is_running = false;
-            break;
+        // Render
+        {
+            SIREN_PROFILE_SCOPE("render");
+            renderer_prepare_frame();
+            if (!app.render(alpha)) {
+                SIREN_ERROR("Game render failed. Shutting down.");
+                is_running = false;
+                break;
+            }
+        }
+        {
+            SIREN_PROFILE_SCOPE("present");
+            renderer_present_frame();
         }
 
-        renderer_prepare_frame();
-        if (!app.render()) {
-            SIREN_ERROR("Game render failed. Shutting down.");
+        total_frames++;
+        if (app.frame_limit != 0 && total_frames >= app.frame_limit) {
             is_running = false;
-            break;
         }
-        renderer_present_frame();
     }
 
     is_running = false;
 
+    if (app.memory_report_interval > 0.0f) {
+        memory_log_report();
+    }
+
     // Application quit
+    job_system_quit();
+    profiler_quit();
     input_quit();
-    logger_quit();
+    asset_system_quit();
     renderer_quit();
+    resource_unmount_all();
+    arena_system_quit();
+    logger_quit();
 
     TTF_Quit();
     SDL_Quit();
@@ -158,10 +362,47 @@ SIREN_API bool siren::application_run() {
     return true;
 }
 
+void application_wait_until(uint64_t target_time) {
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+
+    // Sleep in 1ms steps while we are confident the OS won't oversleep past the target
+    uint64_t now = SDL_GetPerformanceCounter();
+    while (now < target_time && (double)(target_time - now) / frequency > sleep_estimate.estimate) {
+        SDL_Delay(1);
+        uint64_t after_sleep = SDL_GetPerformanceCounter();
+
+        // Update the running mean and deviation of how long a sleep takes (Welford's algorithm)
+        double observed = (double)(after_sleep - now) / frequency;
+        sleep_estimate.count++;
+        double delta = observed - sleep_estimate.mean;
+        sleep_estimate.mean += delta / (double)sleep_estimate.count;
+        sleep_estimate.m2 += delta * (observed - sleep_estimate.mean);
+        double stddev = sqrt(sleep_estimate.m2 / (double)(sleep_estimate.count - 1));
+        sleep_estimate.estimate = sleep_estimate.mean + stddev;
+
+        // Keep the estimate responsive to changes in scheduler behaviour
+        if (sleep_estimate.count > 1000) {
+            sleep_estimate.count = 1;
+            sleep_estimate.m2 = 0.0;
+        }
+
+        now = after_sleep;
+    }
+
+    // Spin for whatever remains
+    while (SDL_GetPerformanceCounter() < target_time) {
+        SDL_CPUPauseInstruction();
+    }
+}
+
 uint32_t siren::application_get_fps() {
     return app.fps;
 }
 
+siren::GpuTimings siren::application_get_gpu_timings() {
+    return renderer_get_gpu_timings();
+}
+
 siren::MouseMode siren::application_get_mouse_mode() {
     return app.mouse_mode;
 }
@@ -3,18 +3,69 @@
 #include "defines.h"
 
 #include "math/vector2.h"
+#include "renderer/gpu_timer.h"
 
 namespace siren {
+    enum FramePacing {
+        // Sleep until the next frame is due at target_fps
+        FRAME_PACING_FIXED,
+        // Render frames as fast as possible
+        FRAME_PACING_UNCAPPED,
+        // Let the driver wait for the display refresh on swap
+        FRAME_PACING_VSYNC,
+        // Like vsync, but late frames are presented immediately instead of waiting another refresh
+        FRAME_PACING_ADAPTIVE_VSYNC
+    };
+
     struct ApplicationConfig {
         const char* name;
         siren::ivec2 screen_size;
         siren::ivec2 window_size;
 
         const char* resource_path;
+        // Optional archive built by siren-pack. It's searched before resource_path, which is still mounted for loose files.
+        const char* resource_archive;
+        // Writable directory that cooked assets are cached in, created if it doesn't exist. NULL disables the cache.
+        const char* cache_path;
 
         bool (*init)();
         bool (*update)(float delta);
-        bool (*render)();
+        // alpha is how far the current frame is between the last two updates, from 0 to 1. Always 1 when fixed_timestep is not used.
+        bool (*render)(float alpha);
+
+        FramePacing frame_pacing;
+        // Only used by FRAME_PACING_FIXED. Defaults to 60 if left as 0.
+        uint32_t target_fps;
+        // Frame rate cap while the window is minimized or unfocused. 0 disables throttling.
+        uint32_t background_fps;
+
+        // Length of a simulation step in seconds. If non-zero, update is called at this fixed rate
+        // (zero or more times per frame) instead of once per frame with a variable delta.
+        float fixed_timestep;
+        // Limit on update calls in a single frame. Any further backlog is dropped. Defaults to 5 if left as 0.
+        uint32_t max_updates_per_frame;
+
+        // Number of job system worker threads. 0 uses one per hardware thread, minus one for the main thread.
+        uint32_t job_worker_count;
+        // Replay draws on a dedicated render thread so that the next frame's update overlaps this frame's GL submission
+        bool threaded_renderer;
+        // Seconds per frame spent uploading assets that were loaded with the *_acquire_async functions. Defaults to 2ms if left as 0.
+        float asset_upload_budget;
+        // Megabytes of VRAM and RAM that loaded assets may hold before unreferenced ones are evicted, least recently used first. 0 is unlimited.
+        uint32_t vram_budget_mb;
+        uint32_t ram_budget_mb;
+
+        // Run without showing a window or presenting frames, and without any frame pacing. Useful for benchmarks and CI.
+        bool headless;
+        // Quit after this many frames. 0 runs until the application quits itself.
+        uint32_t frame_limit;
+        // If non-zero, every frame reports this delta in seconds instead of the measured time, so runs are repeatable
+        float fixed_delta;
+
+        // Log a memory report every this many seconds, and once more at shutdown. 0 disables it.
+        float memory_report_interval;
+        // Save log records to console.bin unformatted instead of writing console.log. Decode it with log-decoder.
+        bool binary_log;
     };
 
     enum MouseMode {
@@ -25,6 +76,8 @@ namespace siren {
     SIREN_API bool application_create(ApplicationConfig config);
     SIREN_API bool application_run();
     SIREN_API uint32_t application_get_fps();
+    // Per stage GPU times from the previous frame. All zero if the GL driver doesn't support timer queries.
+    SIREN_API GpuTimings application_get_gpu_timings();
 
     SIREN_API MouseMode application_get_mouse_mode();
     SIREN_API void application_set_mouse_mode(MouseMode mouse_mode);
@@ -1,3 +1,5 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_INPUT
+
 #include "application.h"
 
 #include "core/input.h"
@@ -0,0 +1,183 @@
+#include "arena.h"
+
+#include "core/memory.h"
+
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+
+static const size_t ARENA_FRAME_BLOCK_SIZE = 1024 * 1024;
+static const size_t ARENA_SCRATCH_BLOCK_SIZE = 256 * 1024;
+
+namespace siren {
+    struct ArenaBlock {
+        ArenaBlock* previous;
+        size_t capacity;
+        size_t offset;
+        uint8_t* data;
+    };
+}
+
+struct ThreadArenas {
+    siren::Arena frame;
+    siren::Arena scratch;
+};
+
+struct ArenaSystemState {
+    std::mutex thread_arenas_mutex;
+    std::vector<ThreadArenas*> thread_arenas;
+};
+
+static ArenaSystemState state;
+static thread_local ThreadArenas* thread_arenas = NULL;
+
+siren::ArenaBlock* arena_block_create(size_t capacity, siren::ArenaBlock* previous) {
+    siren::ArenaBlock* block = (siren::ArenaBlock*)malloc(sizeof(siren::ArenaBlock) + capacity);
+    block->previous = previous;
+    block->capacity = capacity;
+    block->offset = 0;
+    block->data = (uint8_t*)(block + 1);
+    siren::memory_track_alloc(siren::MEMORY_TAG_ARENA, siren::MEMORY_KIND_CPU, NULL, sizeof(siren::ArenaBlock) + capacity);
+    return block;
+}
+
+void arena_block_destroy(siren::ArenaBlock* block) {
+    siren::memory_track_free(siren::MEMORY_TAG_ARENA, siren::MEMORY_KIND_CPU, NULL, sizeof(siren::ArenaBlock) + block->capacity);
+    free(block);
+}
+
+// Returns the offset into the block that an allocation would start at, or SIZE_MAX if it doesn't fit
+size_t arena_block_fit(const siren::ArenaBlock* block, size_t size, size_t alignment) {
+    uintptr_t base = (uintptr_t)block->data;
+    uintptr_t aligned = (base + block->offset + (alignment - 1)) & ~((uintptr_t)alignment - 1);
+    size_t offset = (size_t)(aligned - base);
+    if (offset + size > block->capacity) {
+        return SIZE_MAX;
+    }
+    return offset;
+}
+
+siren::Arena siren::arena_create(size_t block_size) {
+    return (Arena) {
+        .current = arena_block_create(block_size, NULL),
+        .block_size = block_size,
+        .used = 0,
+        .peak = 0
+    };
+}
+
+void siren::arena_destroy(siren::Arena* arena) {
+    while (arena->current != NULL) {
+        ArenaBlock* previous = arena->current->previous;
+        arena_block_destroy(arena->current);
+        arena->current = previous;
+    }
+    arena->used = 0;
+}
+
+void* siren::arena_push(siren::Arena* arena, size_t size, size_t alignment) {
+    size_t offset = arena->current != NULL ? arena_block_fit(arena->current, size, alignment) : SIZE_MAX;
+    if (offset == SIZE_MAX) {
+        // Chain on a new block. The padding guarantees the aligned allocation fits.
+        size_t capacity = size + alignment > arena->block_size ? size + alignment : arena->block_size;
+        arena->current = arena_block_create(capacity, arena->current);
+        offset = arena_block_fit(arena->current, size, alignment);
+    }
+
+    ArenaBlock* block = arena->current;
+    arena->used += (offset + size) - block->offset;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    block->offset = offset + size;
+
+    return block->data + offset;
+}
+
+void siren::arena_reset(siren::Arena* arena) {
+    if (arena->current == NULL) {
+        return;
+    }
+
+    if (arena->current->previous != NULL) {
+        // This arena outgrew its block, so swap the chain for one block that can hold all of it next time
+        size_t capacity = 0;
+        while (arena->current != NULL) {
+            ArenaBlock* previous = arena->current->previous;
+            capacity += arena->current->capacity;
+            arena_block_destroy(arena->current);
+            arena->current = previous;
+        }
+        arena->current = arena_block_create(capacity, NULL);
+    }
+
+    arena->current->offset = 0;
+    arena->used = 0;
+}
+
+siren::ArenaMark siren::arena_get_mark(const siren::Arena* arena) {
+    return (ArenaMark) {
+        .block = arena->current,
+        .offset = arena->current != NULL ? arena->current->offset : 0,
+        .used = arena->used
+    };
+}
+
+void siren::arena_pop_to_mark(siren::Arena* arena, siren::ArenaMark mark) {
+    // Popping everything is a reset, which also gets the chance to merge blocks
+    if (mark.used == 0) {
+        arena_reset(arena);
+        return;
+    }
+
+    while (arena->current != mark.block) {
+        ArenaBlock* previous = arena->current->previous;
+        arena_block_destroy(arena->current);
+        arena->current = previous;
+    }
+    arena->current->offset = mark.offset;
+    arena->used = mark.used;
+}
+
+ThreadArenas* arena_get_thread_arenas() {
+    if (thread_arenas != NULL) {
+        return thread_arenas;
+    }
+
+    thread_arenas = new ThreadArenas();
+    thread_arenas->frame = siren::arena_create(ARENA_FRAME_BLOCK_SIZE);
+    thread_arenas->scratch = siren::arena_create(ARENA_SCRATCH_BLOCK_SIZE);
+
+    std::lock_guard<std::mutex> lock(state.thread_arenas_mutex);
+    state.thread_arenas.push_back(thread_arenas);
+
+    return thread_arenas;
+}
+
+void siren::arena_system_quit() {
+    std::lock_guard<std::mutex> lock(state.thread_arenas_mutex);
+    for (ThreadArenas* arenas : state.thread_arenas) {
+        arena_destroy(&arenas->frame);
+        arena_destroy(&arenas->scratch);
+        delete arenas;
+    }
+    state.thread_arenas.clear();
+    // Any other thread that owned arenas has exited by now
+    thread_arenas = NULL;
+}
+
+void siren::arena_frame_reset() {
+    std::lock_guard<std::mutex> lock(state.thread_arenas_mutex);
+    for (ThreadArenas* arenas : state.thread_arenas) {
+        arena_reset(&arenas->frame);
+    }
+}
+
+siren::Arena* siren::arena_get_frame() {
+    return &arena_get_thread_arenas()->frame;
+}
+
+siren::Arena* siren::arena_get_scratch() {
+    return &arena_get_thread_arenas()->scratch;
+}
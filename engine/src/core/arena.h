@@ -0,0 +1,75 @@
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+
+namespace siren {
+    struct ArenaBlock;
+
+    /*
+     * A linear allocator. Pushes bump an offset, and memory is only ever freed all at once with a reset or by popping back to a mark.
+     * When a block fills up another is chained on, and on reset the chain is replaced with a single block big enough for all of it,
+     * so an arena stops allocating once it has seen its high water mark.
+     */
+    struct Arena {
+        ArenaBlock* current;
+        size_t block_size;
+        // Bytes used across the whole chain and the most that has ever been used at once
+        size_t used;
+        size_t peak;
+    };
+
+    struct ArenaMark {
+        ArenaBlock* block;
+        size_t offset;
+        size_t used;
+    };
+
+    SIREN_API Arena arena_create(size_t block_size);
+    SIREN_API void arena_destroy(Arena* arena);
+    // Returns uninitialized memory
+    SIREN_API void* arena_push(Arena* arena, size_t size, size_t alignment = 16);
+    SIREN_API void arena_reset(Arena* arena);
+    SIREN_API ArenaMark arena_get_mark(const Arena* arena);
+    SIREN_API void arena_pop_to_mark(Arena* arena, ArenaMark mark);
+
+    template <typename T>
+    T* arena_push_array(Arena* arena, size_t count) {
+        return (T*)arena_push(arena, sizeof(T) * count, alignof(T) > 16 ? alignof(T) : 16);
+    }
+
+    void arena_system_quit();
+    // Resets every thread's frame arena. Called by the application at the start of each frame, while no jobs are running.
+    void arena_frame_reset();
+
+    /*
+     * The calling thread's frame arena. Memory pushed here lives until the start of the next frame.
+     * Each thread has its own, so jobs can push to it without locking.
+     */
+    SIREN_API Arena* arena_get_frame();
+    // The calling thread's scratch arena. Use a ScratchScope rather than pushing to it directly.
+    SIREN_API Arena* arena_get_scratch();
+
+    // Hands out scratch memory that is released when the scope ends
+    class ScratchScope {
+        public:
+            SIREN_INLINE ScratchScope() {
+                arena = arena_get_scratch();
+                mark = arena_get_mark(arena);
+            }
+
+            SIREN_INLINE ~ScratchScope() {
+                arena_pop_to_mark(arena, mark);
+            }
+
+            template <typename T>
+            T* push_array(size_t count) {
+                return arena_push_array<T>(arena, count);
+            }
+
+            Arena* arena;
+        private:
+            ArenaMark mark;
+    };
+}
@@ -0,0 +1,200 @@
+#include "asset.h"
+
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "renderer/renderer.h"
+#include "renderer/model.h"
+#include "renderer/texture.h"
+#include "renderer/font.h"
+
+#include <unordered_map>
+#include <vector>
+
+struct AssetEntry {
+    siren::AssetType type;
+    uint32_t handle;
+    uint32_t ref_count;
+    bool is_resident;
+    // Frame the asset was last acquired or released on
+    uint64_t last_used;
+    uint64_t vram_bytes;
+    uint64_t ram_bytes;
+};
+
+struct AssetState {
+    // Keyed by asset_get_key
+    std::unordered_map<uint64_t, AssetEntry> entries;
+    siren::AssetEvictFunction evict_functions[siren::ASSET_TYPE_COUNT];
+    uint64_t vram_budget;
+    uint64_t ram_budget;
+    uint64_t vram_bytes;
+    uint64_t ram_bytes;
+    uint64_t frame;
+    uint64_t eviction_count;
+    // Set while everything over budget is still referenced, so that's only warned about once
+    bool is_over_budget;
+};
+
+static AssetState state;
+
+uint64_t asset_get_key(siren::AssetType type, uint32_t handle) {
+    return ((uint64_t)type << 32) | handle;
+}
+
+AssetEntry& asset_get_entry(siren::AssetType type, uint32_t handle) {
+    auto it = state.entries.find(asset_get_key(type, handle));
+    if (it != state.entries.end()) {
+        return it->second;
+    }
+    AssetEntry& entry = state.entries[asset_get_key(type, handle)];
+    entry = (AssetEntry) {
+        .type = type,
+        .handle = handle,
+        .ref_count = 0,
+        .is_resident = false,
+        .last_used = state.frame,
+        .vram_bytes = 0,
+        .ram_bytes = 0
+    };
+    return entry;
+}
+
+bool asset_is_over_budget() {
+    return (state.vram_budget != 0 && state.vram_bytes > state.vram_budget) || (state.ram_budget != 0 && state.ram_bytes > state.ram_budget);
+}
+
+void asset_evict(const AssetEntry& entry) {
+    state.evict_functions[entry.type](entry.handle);
+    state.vram_bytes -= entry.vram_bytes;
+    state.ram_bytes -= entry.ram_bytes;
+    state.eviction_count++;
+    state.entries.erase(asset_get_key(entry.type, entry.handle));
+}
+
+void siren::asset_system_init(uint64_t vram_budget, uint64_t ram_budget) {
+    state.evict_functions[ASSET_TYPE_MODEL] = model_evict;
+    state.evict_functions[ASSET_TYPE_TEXTURE] = texture_evict;
+    state.evict_functions[ASSET_TYPE_FONT] = font_evict;
+    state.vram_budget = vram_budget;
+    state.ram_budget = ram_budget;
+    state.is_over_budget = false;
+}
+
+void siren::asset_system_quit() {
+    RendererContextScope context_scope;
+    std::vector<AssetEntry> resident_entries;
+    for (const auto& it : state.entries) {
+        if (it.second.is_resident) {
+            resident_entries.push_back(it.second);
+        }
+    }
+    for (const AssetEntry& entry : resident_entries) {
+        asset_evict(entry);
+    }
+    state.entries.clear();
+}
+
+void siren::asset_reference(siren::AssetType type, uint32_t handle) {
+    AssetEntry& entry = asset_get_entry(type, handle);
+    entry.ref_count++;
+    entry.last_used = state.frame;
+}
+
+void siren::asset_unreference(siren::AssetType type, uint32_t handle) {
+    auto it = state.entries.find(asset_get_key(type, handle));
+    if (it == state.entries.end() || it->second.ref_count == 0) {
+        SIREN_WARN("Asset %u was released more times than it was acquired.", handle);
+        return;
+    }
+    it->second.ref_count--;
+    it->second.last_used = state.frame;
+}
+
+void siren::asset_set_resident(siren::AssetType type, uint32_t handle, uint64_t vram_bytes, uint64_t ram_bytes) {
+    AssetEntry& entry = asset_get_entry(type, handle);
+    if (entry.is_resident) {
+        state.vram_bytes -= entry.vram_bytes;
+        state.ram_bytes -= entry.ram_bytes;
+    }
+    entry.is_resident = true;
+    entry.vram_bytes = vram_bytes;
+    entry.ram_bytes = ram_bytes;
+    state.vram_bytes += vram_bytes;
+    state.ram_bytes += ram_bytes;
+}
+
+void siren::asset_forget(siren::AssetType type, uint32_t handle) {
+    auto it = state.entries.find(asset_get_key(type, handle));
+    if (it == state.entries.end()) {
+        return;
+    }
+    if (it->second.is_resident) {
+        state.vram_bytes -= it->second.vram_bytes;
+        state.ram_bytes -= it->second.ram_bytes;
+    }
+    state.entries.erase(it);
+}
+
+void siren::asset_evict_unused() {
+    state.frame++;
+    if (!asset_is_over_budget()) {
+        state.is_over_budget = false;
+        return;
+    }
+
+    SIREN_PROFILE_SCOPE("asset_evict_unused");
+    RendererContextScope context_scope;
+    while (asset_is_over_budget()) {
+        /*
+         * Assets still loading aren't resident, so they're never picked. Neither is anything used during the frame that's
+         * about to be submitted, since its commands can still hold the asset's GL objects until the render thread runs them.
+         */
+        const AssetEntry* least_recent = NULL;
+        bool has_in_flight = false;
+        for (const auto& it : state.entries) {
+            const AssetEntry& entry = it.second;
+            if (entry.ref_count != 0 || !entry.is_resident) {
+                continue;
+            }
+            if (entry.last_used + 1 >= state.frame) {
+                has_in_flight = true;
+            } else if (least_recent == NULL || entry.last_used < least_recent->last_used) {
+                least_recent = &entry;
+            }
+        }
+        // Anything in flight can go next frame, so it's only a problem if nothing can
+        if (least_recent == NULL && has_in_flight) {
+            return;
+        }
+        if (least_recent == NULL) {
+            if (!state.is_over_budget) {
+                SIREN_WARN("Referenced assets need %llu MB of VRAM and %llu MB of RAM, which is over budget.",
+                    (unsigned long long)(state.vram_bytes >> 20), (unsigned long long)(state.ram_bytes >> 20));
+                state.is_over_budget = true;
+            }
+            return;
+        }
+        SIREN_TRACE("Evicting asset %u, unused for %llu frames.", least_recent->handle, (unsigned long long)(state.frame - least_recent->last_used));
+        asset_evict(*least_recent);
+    }
+    state.is_over_budget = false;
+}
+
+siren::AssetStats siren::asset_get_stats() {
+    AssetStats stats = (AssetStats) {
+        .vram_bytes = state.vram_bytes,
+        .ram_bytes = state.ram_bytes,
+        .vram_budget = state.vram_budget,
+        .ram_budget = state.ram_budget,
+        .resident_count = 0,
+        .unreferenced_count = 0,
+        .eviction_count = state.eviction_count
+    };
+    for (const auto& it : state.entries) {
+        if (it.second.is_resident) {
+            stats.resident_count++;
+            stats.unreferenced_count += it.second.ref_count == 0 ? 1 : 0;
+        }
+    }
+    return stats;
+}
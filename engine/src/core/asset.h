@@ -0,0 +1,53 @@
+#pragma once
+
+#include "defines.h"
+
+namespace siren {
+    enum AssetType {
+        ASSET_TYPE_MODEL,
+        ASSET_TYPE_TEXTURE,
+        ASSET_TYPE_FONT,
+        ASSET_TYPE_COUNT
+    };
+
+    // Frees everything a loaded asset holds. The manager reloads it the next time it's acquired.
+    typedef void (*AssetEvictFunction)(uint32_t handle);
+
+    struct AssetStats {
+        uint64_t vram_bytes;
+        uint64_t ram_bytes;
+        // 0 when unlimited
+        uint64_t vram_budget;
+        uint64_t ram_budget;
+        uint32_t resident_count;
+        // Resident assets that nothing holds a reference to, which are evicted first when over budget
+        uint32_t unreferenced_count;
+        uint64_t eviction_count;
+    };
+
+    /*
+     * Every *_acquire adds a reference to an asset and every *_release removes one. Loaded assets stay cached with no
+     * references until the resident total goes over a budget, then the least recently used of them are evicted until
+     * it's back under. A budget of 0 is unlimited. Assets that are still referenced are never evicted, even over budget.
+     * Everything here is main thread only.
+     */
+    void asset_system_init(uint64_t vram_budget, uint64_t ram_budget);
+    // Evicts every loaded asset, referenced or not
+    void asset_system_quit();
+
+    // Used by the resource managers
+    void asset_reference(AssetType type, uint32_t handle);
+    void asset_unreference(AssetType type, uint32_t handle);
+    // Marks an asset as loaded and holding this much memory, which makes it a candidate for eviction
+    void asset_set_resident(AssetType type, uint32_t handle, uint64_t vram_bytes, uint64_t ram_bytes);
+    // Drops an asset that failed to load along with its references, since its handle no longer resolves
+    void asset_forget(AssetType type, uint32_t handle);
+    /*
+     * Evicts unreferenced assets until everything fits in the budgets. The renderer calls this once a frame, at a
+     * point where the render thread isn't drawing anything. Assets released during the frame being submitted are kept
+     * until the next call, once that frame has been drawn.
+     */
+    void asset_evict_unused();
+
+    SIREN_API AssetStats asset_get_stats();
+}
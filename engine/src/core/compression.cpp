@@ -0,0 +1,188 @@
+#include "compression.h"
+
+#include <vector>
+#include <cstring>
+
+static const size_t LZ4_MIN_MATCH = 4;
+// The format requires the last 5 bytes to be literals, and the last match to start at least 12 bytes from the end
+static const size_t LZ4_LAST_LITERALS = 5;
+static const size_t LZ4_MATCH_FIND_LIMIT = 12;
+static const size_t LZ4_MAX_OFFSET = 65535;
+static const uint32_t LZ4_HASH_BITS = 16;
+
+struct Lz4Writer {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+};
+
+uint32_t lz4_read32(const uint8_t* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+bool lz4_write_byte(Lz4Writer* writer, uint8_t value) {
+    if (writer->size == writer->capacity) {
+        return false;
+    }
+    writer->data[writer->size] = value;
+    writer->size++;
+    return true;
+}
+
+// Lengths of 15 or more spill into extra bytes of 255 followed by the remainder
+bool lz4_write_length(Lz4Writer* writer, size_t length) {
+    while (length >= 255) {
+        if (!lz4_write_byte(writer, 255)) {
+            return false;
+        }
+        length -= 255;
+    }
+    return lz4_write_byte(writer, (uint8_t)length);
+}
+
+bool lz4_write_sequence(Lz4Writer* writer, const uint8_t* literals, size_t literal_length, size_t offset, size_t match_length) {
+    size_t token_match = match_length == 0 ? 0 : match_length - LZ4_MIN_MATCH;
+    uint8_t token = (uint8_t)(((literal_length < 15 ? literal_length : 15) << 4) | (token_match < 15 ? token_match : 15));
+    if (!lz4_write_byte(writer, token)) {
+        return false;
+    }
+    if (literal_length >= 15 && !lz4_write_length(writer, literal_length - 15)) {
+        return false;
+    }
+    if (writer->size + literal_length > writer->capacity) {
+        return false;
+    }
+    memcpy(writer->data + writer->size, literals, literal_length);
+    writer->size += literal_length;
+
+    // The last sequence is literals only
+    if (match_length == 0) {
+        return true;
+    }
+    if (!lz4_write_byte(writer, (uint8_t)(offset & 0xFF)) || !lz4_write_byte(writer, (uint8_t)(offset >> 8))) {
+        return false;
+    }
+    if (token_match >= 15 && !lz4_write_length(writer, token_match - 15)) {
+        return false;
+    }
+    return true;
+}
+
+size_t siren::compression_lz4_bound(size_t size) {
+    return size + (size / 255) + 16;
+}
+
+size_t siren::compression_lz4_compress(const uint8_t* source, size_t source_size, uint8_t* destination, size_t destination_capacity) {
+    Lz4Writer writer = (Lz4Writer) {
+        .data = destination,
+        .size = 0,
+        .capacity = destination_capacity
+    };
+
+    // Greedy single-probe matching. Table entries are positions + 1 so that 0 means empty.
+    std::vector<uint32_t> table(1 << LZ4_HASH_BITS, 0);
+    size_t anchor = 0;
+    size_t position = 0;
+    if (source_size > LZ4_MATCH_FIND_LIMIT) {
+        size_t match_limit = source_size - LZ4_MATCH_FIND_LIMIT;
+        while (position < match_limit) {
+            uint32_t sequence = lz4_read32(source + position);
+            uint32_t hash = lz4_hash(sequence);
+            size_t candidate = table[hash];
+            table[hash] = (uint32_t)(position + 1);
+            if (candidate == 0 || position - (candidate - 1) > LZ4_MAX_OFFSET || lz4_read32(source + candidate - 1) != sequence) {
+                position++;
+                continue;
+            }
+
+            size_t match = candidate - 1;
+            size_t match_length = LZ4_MIN_MATCH;
+            size_t max_match_length = source_size - LZ4_LAST_LITERALS - position;
+            while (match_length < max_match_length && source[match + match_length] == source[position + match_length]) {
+                match_length++;
+            }
+
+            if (!lz4_write_sequence(&writer, source + anchor, position - anchor, position - match, match_length)) {
+                return 0;
+            }
+            position += match_length;
+            anchor = position;
+        }
+    }
+
+    if (!lz4_write_sequence(&writer, source + anchor, source_size - anchor, 0, 0)) {
+        return 0;
+    }
+    return writer.size;
+}
+
+// Reads the extra bytes of a length that was 15 in the token. Returns false if the input ends first.
+bool lz4_read_length(const uint8_t* source, size_t source_size, size_t* position, size_t* length) {
+    uint8_t value;
+    do {
+        if (*position >= source_size) {
+            return false;
+        }
+        value = source[*position];
+        (*position)++;
+        *length += value;
+    } while (value == 255);
+    return true;
+}
+
+bool siren::compression_lz4_decompress(const uint8_t* source, size_t source_size, uint8_t* destination, size_t destination_size) {
+    size_t source_position = 0;
+    size_t destination_position = 0;
+    while (source_position < source_size) {
+        uint8_t token = source[source_position];
+        source_position++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !lz4_read_length(source, source_size, &source_position, &literal_length)) {
+            return false;
+        }
+        if (literal_length > source_size - source_position || literal_length > destination_size - destination_position) {
+            return false;
+        }
+        memcpy(destination + destination_position, source + source_position, literal_length);
+        source_position += literal_length;
+        destination_position += literal_length;
+
+        if (source_position == source_size) {
+            break;
+        }
+
+        if (source_size - source_position < 2) {
+            return false;
+        }
+        size_t offset = source[source_position] | (source[source_position + 1] << 8);
+        source_position += 2;
+        if (offset == 0 || offset > destination_position) {
+            return false;
+        }
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !lz4_read_length(source, source_size, &source_position, &match_length)) {
+            return false;
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (match_length > destination_size - destination_position) {
+            return false;
+        }
+
+        // Matches can overlap the bytes they produce, so copy forwards a byte at a time
+        const uint8_t* match = destination + destination_position - offset;
+        for (size_t index = 0; index < match_length; index++) {
+            destination[destination_position + index] = match[index];
+        }
+        destination_position += match_length;
+    }
+
+    return destination_position == destination_size;
+}
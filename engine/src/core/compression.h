@@ -0,0 +1,19 @@
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+
+namespace siren {
+    /*
+     * LZ4 block format compression, used for resource archive entries.
+     * There is no frame or header, so the caller has to store the uncompressed size alongside the block.
+     */
+
+    // The largest compressed size an input of this size can produce
+    SIREN_API size_t compression_lz4_bound(size_t size);
+    // Returns the compressed size, or 0 if it didn't fit in destination_capacity
+    SIREN_API size_t compression_lz4_compress(const uint8_t* source, size_t source_size, uint8_t* destination, size_t destination_capacity);
+    // Returns false unless the block decodes to exactly destination_size bytes. Malformed input is rejected rather than read past.
+    SIREN_API bool compression_lz4_decompress(const uint8_t* source, size_t source_size, uint8_t* destination, size_t destination_size);
+}
@@ -0,0 +1,63 @@
+#include "cook.h"
+
+#include "core/logger.h"
+#include "core/resource.h"
+#include "core/job.h"
+#include "core/arena.h"
+
+#include <SDL2/SDL_ttf.h>
+
+#include <cstring>
+#include <cctype>
+
+bool siren::cook_init(const char* resource_path, const char* cache_path, uint32_t worker_count) {
+    if (!logger_init(false)) {
+        return false;
+    }
+    if (TTF_Init() == -1) {
+        SIREN_ERROR("SDL_ttf failed to initialize: %s", TTF_GetError());
+        return false;
+    }
+    job_system_init(worker_count);
+    resource_set_base_path(resource_path);
+    resource_set_cache_path(cache_path);
+    if (resource_get_cache_path() == NULL) {
+        SIREN_ERROR("Cooking needs a cache path to write to");
+        return false;
+    }
+    return true;
+}
+
+void siren::cook_quit() {
+    job_system_quit();
+    resource_unmount_all();
+    TTF_Quit();
+    arena_system_quit();
+    logger_quit();
+}
+
+bool cook_has_extension(const char* path, const char* extension) {
+    const char* dot = strrchr(path, '.');
+    if (dot == NULL || strlen(dot + 1) != strlen(extension)) {
+        return false;
+    }
+    for (size_t index = 0; extension[index] != '\0'; index++) {
+        if (tolower((unsigned char)dot[1 + index]) != extension[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+siren::CookAssetType siren::cook_get_asset_type(const char* path) {
+    if (cook_has_extension(path, "glb")) {
+        return COOK_ASSET_MODEL;
+    }
+    if (cook_has_extension(path, "png") || cook_has_extension(path, "jpg") || cook_has_extension(path, "jpeg")) {
+        return COOK_ASSET_TEXTURE;
+    }
+    if (cook_has_extension(path, "ttf")) {
+        return COOK_ASSET_FONT;
+    }
+    return COOK_ASSET_NONE;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "defines.h"
+
+namespace siren {
+    /*
+     * Cooking turns a source asset into the runtime format that its loader reads first, and writes it to the cache path.
+     * Cooked files are named after a hash of the source contents, so an asset whose cooked file exists is up to date.
+     * Loaders cook on the fly when they miss the cache, and siren-cook cooks everything ahead of time.
+     */
+    enum CookResult {
+        COOK_FAILED,
+        COOK_UP_TO_DATE,
+        COOK_WRITTEN
+    };
+
+    enum CookAssetType {
+        COOK_ASSET_NONE,
+        COOK_ASSET_MODEL,
+        COOK_ASSET_TEXTURE,
+        COOK_ASSET_FONT
+    };
+
+    // Starts the subsystems that cooking needs without a window or GL context, for tools like siren-cook
+    SIREN_API bool cook_init(const char* resource_path, const char* cache_path, uint32_t worker_count);
+    SIREN_API void cook_quit();
+    // Decides by file extension
+    SIREN_API CookAssetType cook_get_asset_type(const char* path);
+}
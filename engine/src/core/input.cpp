@@ -1,3 +1,5 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_INPUT
+
 #include "input.h"
 
 #include "core/logger.h"
@@ -6,15 +8,24 @@
 
 #include <cstring>
 
+static const uint32_t INPUT_EVENT_CAPACITY = 1024;
+
 struct InputState {
     siren::ivec2 mouse_position;
     siren::ivec2 mouse_relative_position;
+    // Set once an update has read mouse_relative_position. Until then it's still pending.
+    bool is_mouse_motion_consumed;
     int mouse_delta_z;
 
     bool key_pressed_current[256];
     bool key_pressed_previous[256];
     bool mouse_button_pressed_current[siren::MOUSE_BUTTON_MAX_BUTTONS];
     bool mouse_button_pressed_previous[siren::MOUSE_BUTTON_MAX_BUTTONS];
+
+    // A ring of events. event_head counts every event ever pushed, and event_frame_start is where the head was at the last update.
+    siren::InputEvent events[INPUT_EVENT_CAPACITY];
+    uint32_t event_head;
+    uint32_t event_frame_start;
 };
 
 static bool initialized = false;
@@ -41,43 +52,74 @@ void siren::input_update() {
     }
 
     input_state.mouse_relative_position = ivec2();
+    input_state.is_mouse_motion_consumed = false;
     input_state.mouse_delta_z = 0;
+    input_state.event_frame_start = input_state.event_head;
 
     memcpy(&input_state.key_pressed_previous, &input_state.key_pressed_current, sizeof(bool) * 256);
     memcpy(&input_state.mouse_button_pressed_previous, &input_state.mouse_button_pressed_current, sizeof(bool) * siren::MOUSE_BUTTON_MAX_BUTTONS);
 }
 
-void siren::input_process_key(Key key, bool pressed) {
+void input_push_event(const siren::InputEvent& event) {
+    input_state.events[input_state.event_head % INPUT_EVENT_CAPACITY] = event;
+    input_state.event_head++;
+}
+
+void siren::input_process_key(Key key, bool pressed, uint32_t timestamp) {
     if (!initialized) {
         return;
     }
 
     input_state.key_pressed_current[key] = pressed;
+    InputEvent event = (InputEvent) { };
+    event.type = INPUT_EVENT_KEY;
+    event.timestamp = timestamp;
+    event.key = key;
+    event.pressed = pressed;
+    input_push_event(event);
 }
 
-void siren::input_process_mouse_button(MouseButton button, bool pressed) {
+void siren::input_process_mouse_button(MouseButton button, bool pressed, uint32_t timestamp) {
     if (!initialized) {
         return;
     }
 
     input_state.mouse_button_pressed_current[button] = pressed;
+    InputEvent event = (InputEvent) { };
+    event.type = INPUT_EVENT_MOUSE_BUTTON;
+    event.timestamp = timestamp;
+    event.button = button;
+    event.pressed = pressed;
+    input_push_event(event);
 }
 
-void siren::input_process_mouse_motion(ivec2 mouse_position, ivec2 mouse_relative_position) {
+void siren::input_process_mouse_motion(ivec2 mouse_position, ivec2 mouse_relative_position, uint32_t timestamp) {
     if (!initialized) {
         return;
     }
 
     input_state.mouse_position = mouse_position;
-    input_state.mouse_relative_position = mouse_relative_position;
+    // High polling rate mice send several motion events a frame, so add them all up rather than keeping the last
+    input_state.mouse_relative_position = input_state.mouse_relative_position + mouse_relative_position;
+    InputEvent event = (InputEvent) { };
+    event.type = INPUT_EVENT_MOUSE_MOTION;
+    event.timestamp = timestamp;
+    event.mouse_position = mouse_position;
+    event.mouse_relative_position = mouse_relative_position;
+    input_push_event(event);
 }
 
-void siren::input_process_mouse_wheel(int delta_z) {
+void siren::input_process_mouse_wheel(int delta_z, uint32_t timestamp) {
     if (!initialized) {
         return;
     }
 
-    input_state.mouse_delta_z = delta_z;
+    input_state.mouse_delta_z += delta_z;
+    InputEvent event = (InputEvent) { };
+    event.type = INPUT_EVENT_MOUSE_WHEEL;
+    event.timestamp = timestamp;
+    event.delta_z = delta_z;
+    input_push_event(event);
 }
 
 bool siren::input_is_key_pressed(Key key) {
@@ -144,10 +186,41 @@ siren::ivec2 siren::input_get_mouse_relative_position() {
     return input_state.mouse_relative_position;
 }
 
+void siren::input_mark_consumed() {
+    input_state.is_mouse_motion_consumed = true;
+}
+
+siren::ivec2 siren::input_get_pending_mouse_relative_position() {
+    if (!initialized || input_state.is_mouse_motion_consumed) {
+        return ivec2();
+    }
+
+    return input_state.mouse_relative_position;
+}
+
 int siren::input_get_mouse_wheel_relative_position() {
     if (!initialized) {
         return 0;
     }
 
     return input_state.mouse_delta_z;
-}
\ No newline at end of file
+}
+
+uint32_t siren::input_get_event_count() {
+    if (!initialized) {
+        return 0;
+    }
+
+    uint32_t count = input_state.event_head - input_state.event_frame_start;
+    return count < INPUT_EVENT_CAPACITY ? count : INPUT_EVENT_CAPACITY;
+}
+
+siren::InputEvent siren::input_get_event(uint32_t index) {
+    uint32_t count = input_get_event_count();
+    if (index >= count) {
+        return (InputEvent) { };
+    }
+
+    uint32_t first = input_state.event_head - count;
+    return input_state.events[(first + index) % INPUT_EVENT_CAPACITY];
+}
@@ -13,15 +13,41 @@ namespace siren {
         MOUSE_BUTTON_MAX_BUTTONS
     };
 
+    enum InputEventType {
+        INPUT_EVENT_KEY,
+        INPUT_EVENT_MOUSE_BUTTON,
+        INPUT_EVENT_MOUSE_MOTION,
+        INPUT_EVENT_MOUSE_WHEEL
+    };
+
+    struct InputEvent {
+        InputEventType type;
+        // SDL event timestamp in milliseconds
+        uint32_t timestamp;
+        // Key and mouse button events
+        Key key;
+        MouseButton button;
+        bool pressed;
+        // Mouse motion events
+        ivec2 mouse_position;
+        ivec2 mouse_relative_position;
+        // Mouse wheel events
+        int delta_z;
+    };
+
     void input_init();
     void input_quit();
     void input_update();
 
-    void input_process_key(Key key, bool pressed);
+    void input_process_key(Key key, bool pressed, uint32_t timestamp);
 
-    void input_process_mouse_button(MouseButton button, bool pressed);
-    void input_process_mouse_motion(ivec2 mouse_position, ivec2 mouse_relative_position);
-    void input_process_mouse_wheel(int delta_z);
+    void input_process_mouse_button(MouseButton button, bool pressed, uint32_t timestamp);
+    void input_process_mouse_motion(ivec2 mouse_position, ivec2 mouse_relative_position, uint32_t timestamp);
+    void input_process_mouse_wheel(int delta_z, uint32_t timestamp);
+    // Called once a frame's updates have run. Frames without an update leave the polled input pending for the next one.
+    void input_mark_consumed();
+    // Relative mouse motion that has been polled but not yet seen by an update, for late latching
+    ivec2 input_get_pending_mouse_relative_position();
 
     SIREN_API bool input_is_key_pressed(Key key);
     SIREN_API bool input_is_key_just_pressed(Key key);
@@ -32,6 +58,14 @@ namespace siren {
     SIREN_API bool input_is_mouse_button_just_released(MouseButton button);
 
     SIREN_API ivec2 input_get_mouse_position();
+    // Sum of all relative mouse motion since the last update
     SIREN_API ivec2 input_get_mouse_relative_position();
     SIREN_API int input_get_mouse_wheel_relative_position();
+
+    /*
+     * Every input event received since the last update, oldest first, for games that need sub-frame ordering or timing.
+     * If more events arrive in one update than the queue holds, the oldest are dropped.
+     */
+    SIREN_API uint32_t input_get_event_count();
+    SIREN_API InputEvent input_get_event(uint32_t index);
 }
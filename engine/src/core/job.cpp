@@ -0,0 +1,336 @@
+#include "job.h"
+
+#include "core/logger.h"
+#include "core/profiler.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstdio>
+
+static const uint32_t JOB_DEQUE_CAPACITY = 4096;
+static const uint32_t JOB_THREAD_INDEX_NONE = UINT32_MAX;
+
+struct QueuedJob {
+    siren::JobFunction function;
+    void* data;
+    siren::JobCounter* counter;
+};
+
+/*
+ * Each thread owns one deque. The owner pushes and pops at the bottom, so it works through its
+ * most recent (cache-warm) jobs first, while idle threads steal the oldest jobs from the top.
+ * The lock is only ever contended when a steal races the owner.
+ */
+struct JobDeque {
+    std::atomic_flag lock;
+    QueuedJob jobs[JOB_DEQUE_CAPACITY];
+    uint32_t top;
+    uint32_t bottom;
+};
+
+struct JobSystemState {
+    uint32_t worker_count;
+    std::vector<std::thread> workers;
+    // Index 0 belongs to the main thread, the rest to workers
+    std::vector<JobDeque*> deques;
+
+    // Jobs queued from threads that aren't part of the pool
+    std::mutex external_queue_mutex;
+    std::deque<QueuedJob> external_queue;
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+    std::atomic<uint32_t> queued_job_count;
+    std::atomic<uint32_t> sleeping_worker_count;
+    std::atomic<bool> is_quitting;
+};
+
+static bool initialized = false;
+static JobSystemState state;
+static thread_local uint32_t thread_index = JOB_THREAD_INDEX_NONE;
+static thread_local uint32_t steal_seed = 0;
+
+void job_deque_lock(JobDeque* deque) {
+    while (deque->lock.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void job_deque_unlock(JobDeque* deque) {
+    deque->lock.clear(std::memory_order_release);
+}
+
+bool job_deque_push(JobDeque* deque, QueuedJob job) {
+    job_deque_lock(deque);
+    if (deque->bottom - deque->top == JOB_DEQUE_CAPACITY) {
+        job_deque_unlock(deque);
+        return false;
+    }
+    deque->jobs[deque->bottom % JOB_DEQUE_CAPACITY] = job;
+    deque->bottom++;
+    job_deque_unlock(deque);
+    return true;
+}
+
+bool job_deque_pop(JobDeque* deque, QueuedJob* job) {
+    job_deque_lock(deque);
+    if (deque->bottom == deque->top) {
+        job_deque_unlock(deque);
+        return false;
+    }
+    deque->bottom--;
+    *job = deque->jobs[deque->bottom % JOB_DEQUE_CAPACITY];
+    job_deque_unlock(deque);
+    return true;
+}
+
+bool job_deque_steal(JobDeque* deque, QueuedJob* job) {
+    job_deque_lock(deque);
+    if (deque->bottom == deque->top) {
+        job_deque_unlock(deque);
+        return false;
+    }
+    *job = deque->jobs[deque->top % JOB_DEQUE_CAPACITY];
+    deque->top++;
+    job_deque_unlock(deque);
+    return true;
+}
+
+void job_execute(const QueuedJob& job) {
+    job.function(job.data);
+    if (job.counter != NULL) {
+        job.counter->value.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+// Finds a job from this thread's deque, then from other threads, then from the external queue
+bool job_find(QueuedJob* job) {
+    uint32_t deque_count = (uint32_t)state.deques.size();
+    if (thread_index != JOB_THREAD_INDEX_NONE && job_deque_pop(state.deques[thread_index], job)) {
+        state.queued_job_count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Start stealing at a different deque each time so that thieves spread out
+    steal_seed = steal_seed * 1664525 + 1013904223;
+    uint32_t start = steal_seed % deque_count;
+    for (uint32_t offset = 0; offset < deque_count; offset++) {
+        uint32_t victim = (start + offset) % deque_count;
+        if (victim == thread_index) {
+            continue;
+        }
+        if (job_deque_steal(state.deques[victim], job)) {
+            state.queued_job_count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(state.external_queue_mutex);
+    if (!state.external_queue.empty()) {
+        *job = state.external_queue.front();
+        state.external_queue.pop_front();
+        state.queued_job_count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+void job_worker_main(uint32_t index) {
+    thread_index = index;
+    steal_seed = index;
+
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "worker %u", index);
+    siren::profiler_set_thread_name(thread_name);
+
+    while (!state.is_quitting.load(std::memory_order_acquire)) {
+        QueuedJob job;
+        if (job_find(&job)) {
+            job_execute(job);
+            continue;
+        }
+
+        // Nothing to do, so sleep until more jobs are queued
+        std::unique_lock<std::mutex> lock(state.sleep_mutex);
+        // Sequentially consistent so that either we see the new job or job_run sees us sleeping
+        state.sleeping_worker_count.fetch_add(1);
+        state.sleep_condition.wait(lock, []() {
+            return state.queued_job_count.load() != 0 || state.is_quitting.load();
+        });
+        state.sleeping_worker_count.fetch_sub(1);
+    }
+}
+
+bool siren::job_system_init(uint32_t worker_count) {
+    if (initialized) {
+        return true;
+    }
+
+    if (worker_count == 0) {
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+
+    state.worker_count = worker_count;
+    state.queued_job_count = 0;
+    state.sleeping_worker_count = 0;
+    state.is_quitting = false;
+    for (uint32_t index = 0; index < worker_count + 1; index++) {
+        JobDeque* deque = new JobDeque();
+        deque->lock.clear();
+        deque->top = 0;
+        deque->bottom = 0;
+        state.deques.push_back(deque);
+    }
+
+    thread_index = 0;
+    initialized = true;
+
+    for (uint32_t index = 1; index < worker_count + 1; index++) {
+        state.workers.push_back(std::thread(job_worker_main, index));
+    }
+
+    SIREN_INFO("Job system initialized with %u workers.", worker_count);
+    return true;
+}
+
+void siren::job_system_quit() {
+    if (!initialized) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state.sleep_mutex);
+        state.is_quitting = true;
+    }
+    state.sleep_condition.notify_all();
+    for (std::thread& worker : state.workers) {
+        worker.join();
+    }
+    state.workers.clear();
+
+    for (JobDeque* deque : state.deques) {
+        delete deque;
+    }
+    state.deques.clear();
+    state.external_queue.clear();
+
+    thread_index = JOB_THREAD_INDEX_NONE;
+    initialized = false;
+}
+
+void siren::job_run(const siren::Job* jobs, uint32_t job_count, siren::JobCounter* counter) {
+    if (counter != NULL) {
+        counter->value.fetch_add((int32_t)job_count, std::memory_order_relaxed);
+    }
+
+    // Without a pool just run everything inline
+    if (!initialized) {
+        for (uint32_t index = 0; index < job_count; index++) {
+            job_execute((QueuedJob) {
+                .function = jobs[index].function,
+                .data = jobs[index].data,
+                .counter = counter
+            });
+        }
+        return;
+    }
+
+    for (uint32_t index = 0; index < job_count; index++) {
+        QueuedJob job = (QueuedJob) {
+            .function = jobs[index].function,
+            .data = jobs[index].data,
+            .counter = counter
+        };
+
+        if (thread_index == JOB_THREAD_INDEX_NONE) {
+            std::lock_guard<std::mutex> lock(state.external_queue_mutex);
+            state.external_queue.push_back(job);
+        } else if (!job_deque_push(state.deques[thread_index], job)) {
+            // Our deque is full, so do the work now rather than dropping it
+            job_execute(job);
+            continue;
+        }
+        state.queued_job_count.fetch_add(1);
+    }
+
+    if (state.sleeping_worker_count.load() != 0) {
+        std::lock_guard<std::mutex> lock(state.sleep_mutex);
+        state.sleep_condition.notify_all();
+    }
+}
+
+void siren::job_wait(siren::JobCounter* counter) {
+    while (counter->value.load(std::memory_order_acquire) > 0) {
+        QueuedJob job;
+        if (initialized && job_find(&job)) {
+            job_execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool siren::job_is_done(const siren::JobCounter* counter) {
+    return counter->value.load(std::memory_order_acquire) <= 0;
+}
+
+struct ParallelForBatch {
+    siren::ParallelForFunction function;
+    void* data;
+    uint32_t start;
+    uint32_t end;
+};
+
+void job_parallel_for_batch(void* data) {
+    ParallelForBatch* batch = (ParallelForBatch*)data;
+    batch->function(batch->start, batch->end, batch->data);
+}
+
+void siren::job_parallel_for(uint32_t count, uint32_t batch_size, siren::ParallelForFunction function, void* data) {
+    if (count == 0) {
+        return;
+    }
+
+    if (batch_size == 0) {
+        // A few batches per thread gives stealing room to even out uneven work
+        uint32_t thread_count = initialized ? state.worker_count + 1 : 1;
+        batch_size = (count + (thread_count * 4) - 1) / (thread_count * 4);
+        if (batch_size == 0) {
+            batch_size = 1;
+        }
+    }
+
+    uint32_t batch_count = (count + batch_size - 1) / batch_size;
+    std::vector<ParallelForBatch> batches(batch_count);
+    std::vector<Job> jobs(batch_count);
+    for (uint32_t index = 0; index < batch_count; index++) {
+        batches[index] = (ParallelForBatch) {
+            .function = function,
+            .data = data,
+            .start = index * batch_size,
+            .end = std::min(count, (index + 1) * batch_size)
+        };
+        jobs[index] = (Job) {
+            .function = job_parallel_for_batch,
+            .data = &batches[index]
+        };
+    }
+
+    JobCounter counter;
+    job_run(&jobs[0], batch_count, &counter);
+    job_wait(&counter);
+}
+
+uint32_t siren::job_get_worker_count() {
+    return initialized ? state.worker_count : 0;
+}
+
+uint32_t siren::job_get_thread_index() {
+    return thread_index;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+
+namespace siren {
+    typedef void (*JobFunction)(void* data);
+    typedef void (*ParallelForFunction)(uint32_t start, uint32_t end, void* data);
+
+    struct Job {
+        JobFunction function;
+        void* data;
+    };
+
+    // Counts the jobs still running in a batch. Wait on it to know when they are all done.
+    struct JobCounter {
+        std::atomic<int32_t> value;
+
+        JobCounter() : value(0) { }
+    };
+
+    // A worker_count of 0 uses one worker per hardware thread, minus one for the main thread
+    bool job_system_init(uint32_t worker_count);
+    void job_system_quit();
+
+    /*
+     * Queues jobs to run on the worker pool. counter is incremented by job_count and decremented as each job finishes.
+     * Jobs may be queued from inside other jobs.
+     */
+    SIREN_API void job_run(const Job* jobs, uint32_t job_count, JobCounter* counter);
+    /*
+     * Blocks until the counter reaches zero.
+     * While waiting, the calling thread runs queued jobs itself instead of sleeping.
+     */
+    SIREN_API void job_wait(JobCounter* counter);
+    SIREN_API bool job_is_done(const JobCounter* counter);
+
+    /*
+     * Calls function over [0, count) split into ranges of batch_size and waits for all of them to finish.
+     * A batch_size of 0 picks one based on the number of workers.
+     */
+    SIREN_API void job_parallel_for(uint32_t count, uint32_t batch_size, ParallelForFunction function, void* data);
+
+    SIREN_API uint32_t job_get_worker_count();
+    // Returns 0 on the main thread, 1 to worker_count on workers, and UINT32_MAX on any other thread
+    SIREN_API uint32_t job_get_thread_index();
+}
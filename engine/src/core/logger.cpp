@@ -8,25 +8,121 @@
 #include "math/matrix.h"
 #include "math/quaternion.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <unordered_set>
 #include <cstdarg>
+#include <cstdlib>
 #include <cstring>
 #include <cstdio>
 
 void logger_console_write(const char* message, uint8_t color);
 void logger_console_write_error(const char* message, uint8_t color);
 
-static FILE* logfile;
+// Longer messages are truncated
+static const uint32_t LOGGER_MESSAGE_LENGTH = 512;
+// Space for a record's captured arguments. Strings are cut short to fit.
+static const uint32_t LOGGER_ARGS_SIZE = 480;
+// Must be a power of two
+static const uint32_t LOGGER_RING_CAPACITY = 1024;
+static const uint32_t LOGGER_FILE_BUFFER_SIZE = 64 * 1024;
+static const std::chrono::milliseconds LOGGER_WRITE_INTERVAL(10);
+static const std::chrono::milliseconds LOGGER_FLUSH_INTERVAL(100);
+
+static const char* LOGGER_LEVEL_NAMES[4] = { "ERROR", "WARN", "INFO", "TRACE" };
+static const char* LOGGER_CATEGORY_NAMES[siren::LOG_CATEGORY_COUNT] = {
+    "engine",
+    "renderer",
+    "model",
+    "texture",
+    "font",
+    "input",
+    "game"
+};
+
+/*
+ * A slot in the ring. sequence equals the slot's ring position while it is free, and that position + 1
+ * once a producer has filled it. The writer hands it back by moving sequence on to position + capacity.
+ */
+struct LogRecord {
+    std::atomic<uint32_t> sequence;
+    const char* message;
+    uint16_t args_size;
+    uint8_t level;
+    uint8_t category;
+    uint8_t args[LOGGER_ARGS_SIZE];
+};
+
+struct LoggerState {
+    FILE* logfile;
+    bool is_binary;
+    std::atomic<uint32_t> masks[siren::LOG_CATEGORY_COUNT];
+    // Masks set before logger_init are kept by it
+    std::atomic<bool> is_mask_set[siren::LOG_CATEGORY_COUNT];
+
+    // Producers claim positions with a CAS, only the writer thread consumes them
+    LogRecord records[LOGGER_RING_CAPACITY];
+    alignas(64) std::atomic<uint32_t> enqueue_position;
+    alignas(64) std::atomic<uint32_t> dequeue_position;
+    std::atomic<uint32_t> flushed_position;
+
+    std::thread writer;
+    std::mutex writer_mutex;
+    std::condition_variable writer_condition;
+    std::condition_variable flushed_condition;
+    std::atomic<bool> is_writer_sleeping;
+    std::atomic<bool> is_flush_requested;
+    std::atomic<bool> is_quitting;
+
+    // Messages whose text has already been written to the binary log. Only touched by the writer.
+    std::unordered_set<const char*> written_messages;
+};
+
+static LoggerState state;
 static bool initialized = false;
+// Arguments are captured into a per-thread buffer and then copied into the ring
+static thread_local uint8_t log_args[LOGGER_ARGS_SIZE];
+
+void logger_writer_main();
 
-bool siren::logger_init() {
+bool siren::logger_init(bool is_binary) {
     if (initialized) {
         return true;
     }
 
-    logfile = fopen("console.log", "w");
-    if (logfile == NULL) {
+    for (uint32_t category = 0; category < LOG_CATEGORY_COUNT; category++) {
+        if (!state.is_mask_set[category].load(std::memory_order_relaxed)) {
+            state.masks[category].store(LOG_MASK_ALL, std::memory_order_relaxed);
+        }
+    }
+
+    state.is_binary = is_binary;
+    state.logfile = fopen(is_binary ? "console.bin" : "console.log", is_binary ? "wb" : "w");
+    if (state.logfile == NULL) {
         SIREN_ERROR("Unable to open log file for writing");
+    } else {
+        // The writer thread batches records, so give the file a buffer large enough to hold a batch
+        setvbuf(state.logfile, NULL, _IOFBF, LOGGER_FILE_BUFFER_SIZE);
+        if (is_binary) {
+            fwrite(LOG_BINARY_MAGIC, 1, sizeof(LOG_BINARY_MAGIC), state.logfile);
+            fwrite(&LOG_BINARY_VERSION, sizeof(LOG_BINARY_VERSION), 1, state.logfile);
+        }
+    }
+
+    for (uint32_t index = 0; index < LOGGER_RING_CAPACITY; index++) {
+        state.records[index].sequence.store(index, std::memory_order_relaxed);
     }
+    state.enqueue_position.store(0, std::memory_order_relaxed);
+    state.dequeue_position.store(0, std::memory_order_relaxed);
+    state.flushed_position.store(0, std::memory_order_relaxed);
+    state.is_writer_sleeping.store(false, std::memory_order_relaxed);
+    state.is_flush_requested.store(false, std::memory_order_relaxed);
+    state.is_quitting.store(false, std::memory_order_relaxed);
+    state.written_messages.clear();
+    state.writer = std::thread(logger_writer_main);
 
     initialized = true;
 
@@ -38,131 +134,685 @@ void siren::logger_quit() {
         return;
     }
 
-    fclose(logfile);
+    // The writer drains everything that was queued before it exits
+    {
+        std::lock_guard<std::mutex> lock(state.writer_mutex);
+        state.is_quitting.store(true, std::memory_order_release);
+    }
+    state.writer_condition.notify_one();
+    state.writer.join();
+
+    if (state.logfile != NULL) {
+        fclose(state.logfile);
+        state.logfile = NULL;
+    }
     initialized = false;
 }
 
-void siren::logger_output(siren::LogLevel level, const char* message, ...) {
-    const char* level_prefix[4] = {"[ERROR]: ", "[WARN]: ", "[INFO]: ", "[TRACE]: "};
-    bool is_error = level == LOG_LEVEL_ERROR;
+void siren::logger_set_mask(siren::LogCategory category, uint32_t level_mask) {
+    state.masks[category].store(level_mask, std::memory_order_relaxed);
+    state.is_mask_set[category].store(true, std::memory_order_relaxed);
+}
 
-    const int MESSAGE_LENGTH = 32000;
-    char out_message[MESSAGE_LENGTH];
-    memset(out_message, 0, sizeof(out_message));
+uint32_t siren::logger_get_mask(siren::LogCategory category) {
+    return state.masks[category].load(std::memory_order_relaxed);
+}
+
+bool siren::logger_is_enabled(siren::LogLevel level, siren::LogCategory category) {
+    // Before logger_init masks that weren't set are still zero, but those messages should still reach the console
+    if (!initialized && !state.is_mask_set[category].load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return (state.masks[category].load(std::memory_order_relaxed) & (1u << level)) != 0;
+}
+
+const char* siren::logger_category_name(siren::LogCategory category) {
+    return LOGGER_CATEGORY_NAMES[category];
+}
+
+void logger_wake_writer() {
+    {
+        std::lock_guard<std::mutex> lock(state.writer_mutex);
+    }
+    state.writer_condition.notify_one();
+}
+
+void siren::logger_flush() {
+    if (!initialized) {
+        return;
+    }
+
+    uint32_t target = state.enqueue_position.load(std::memory_order_acquire);
+    state.is_flush_requested.store(true, std::memory_order_release);
+    logger_wake_writer();
+
+    std::unique_lock<std::mutex> lock(state.writer_mutex);
+    while ((int32_t)(state.flushed_position.load(std::memory_order_acquire) - target) < 0) {
+        state.flushed_condition.wait_for(lock, LOGGER_WRITE_INTERVAL);
+    }
+}
+
+// Returns false if the ring is full
+bool logger_ring_push(siren::LogLevel level, siren::LogCategory category, const char* message, const uint8_t* args, uint32_t args_size) {
+    uint32_t position = state.enqueue_position.load(std::memory_order_relaxed);
+    LogRecord* record;
+    while (true) {
+        record = &state.records[position & (LOGGER_RING_CAPACITY - 1)];
+        uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+        int32_t difference = (int32_t)(sequence - position);
+        if (difference == 0) {
+            if (state.enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = state.enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->message = message;
+    record->args_size = (uint16_t)args_size;
+    record->level = (uint8_t)level;
+    record->category = (uint8_t)category;
+    memcpy(record->args, args, args_size);
+    record->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+// Returns the next filled record, or NULL if the writer has caught up. Only called by the writer thread.
+LogRecord* logger_ring_peek() {
+    uint32_t position = state.dequeue_position.load(std::memory_order_relaxed);
+    LogRecord* record = &state.records[position & (LOGGER_RING_CAPACITY - 1)];
+    uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+    if (sequence != position + 1) {
+        return NULL;
+    }
+    return record;
+}
+
+void logger_ring_pop(LogRecord* record) {
+    uint32_t position = state.dequeue_position.load(std::memory_order_relaxed);
+    record->sequence.store(position + LOGGER_RING_CAPACITY, std::memory_order_release);
+    state.dequeue_position.store(position + 1, std::memory_order_relaxed);
+}
+
+// Argument capture and formatting
+
+enum LogSizeModifier {
+    LOG_SIZE_DEFAULT,
+    LOG_SIZE_LONG,
+    LOG_SIZE_LONG_LONG,
+    LOG_SIZE_SIZE_T
+};
+
+// A standard printf conversion such as %s, %-10s, %.2f or %llu
+struct LogSpec {
+    char text[16];
+    char conversion;
+    LogSizeModifier size;
+};
+
+/*
+ * Parses the conversion that starts after a '%'. Returns a pointer to the conversion character, which is left in
+ * spec->conversion, or '\0' if the conversion is malformed.
+ */
+const char* logger_parse_spec(const char* message, LogSpec* spec) {
+    const char* spec_start = message - 1;
+    spec->conversion = '\0';
+    spec->size = LOG_SIZE_DEFAULT;
+
+    while (*message != '\0' && strchr("-+ #0", *message) != NULL) {
+        message++;
+    }
+    while (*message >= '0' && *message <= '9') {
+        message++;
+    }
+    if (*message == '.') {
+        message++;
+        while (*message >= '0' && *message <= '9') {
+            message++;
+        }
+    }
+    const char* size_start = message;
+    while (*message != '\0' && strchr("hlzjtL", *message) != NULL) {
+        message++;
+    }
+    if (*message == '\0') {
+        return message - 1;
+    }
+
+    size_t spec_length = (size_t)(message - spec_start) + 1;
+    if (spec_length >= sizeof(spec->text)) {
+        return message;
+    }
+    memcpy(spec->text, spec_start, spec_length);
+    spec->text[spec_length] = '\0';
+    spec->conversion = *message;
+    if (size_start[0] == 'l') {
+        spec->size = size_start[1] == 'l' ? LOG_SIZE_LONG_LONG : LOG_SIZE_LONG;
+    } else if (size_start[0] == 'z' || size_start[0] == 'j' || size_start[0] == 't') {
+        spec->size = LOG_SIZE_SIZE_T;
+    }
+
+    return message;
+}
+
+// Custom conversions for engine types, %v2 %v2i %v3 %v4 %m4 and %q. Returns the size of the captured value, or 0 if message isn't one.
+size_t logger_custom_size(const char* message, size_t* chars) {
+    if (message[0] == 'v' && message[1] == '2') {
+        *chars = message[2] == 'i' ? 3 : 2;
+        return message[2] == 'i' ? sizeof(siren::ivec2) : sizeof(siren::vec2);
+    }
+    if (message[0] == 'v' && message[1] == '3') {
+        *chars = 2;
+        return sizeof(siren::vec3);
+    }
+    if (message[0] == 'v' && message[1] == '4') {
+        *chars = 2;
+        return sizeof(siren::vec4);
+    }
+    if (message[0] == 'm' && message[1] == '4') {
+        *chars = 2;
+        return sizeof(siren::mat4);
+    }
+    if (message[0] == 'q') {
+        *chars = 1;
+        return sizeof(siren::quat);
+    }
+    return 0;
+}
+
+struct LogArgsWriter {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+};
+
+bool logger_args_write(LogArgsWriter* writer, const void* value, size_t size) {
+    if (writer->size + size > writer->capacity) {
+        writer->size = writer->capacity;
+        return false;
+    }
+    memcpy(writer->data + writer->size, value, size);
+    writer->size += size;
+    return true;
+}
+
+// Copies the raw arguments out of the va_list without formatting them. Integers are widened to 64 bits.
+size_t logger_capture_args(const char* message, va_list* arg_ptr, uint8_t* data, size_t capacity) {
+    LogArgsWriter writer = (LogArgsWriter) {
+        .data = data,
+        .size = 0,
+        .capacity = capacity
+    };
 
-    __builtin_va_list arg_ptr;
-    va_start(arg_ptr, message);
-    char* out_ptr = out_message;
     while (*message != '\0') {
         if (*message != '%') {
-            *out_ptr = *message;
-            out_ptr++;
             message++;
             continue;
         }
-
         message++;
         if (*message == '\0') {
             break;
         }
 
-        switch (*message) {
-            case 'c': {
-                out_ptr += sprintf(out_ptr, "%c", (char)va_arg(arg_ptr, int));
+        size_t custom_chars;
+        size_t custom_size = logger_custom_size(message, &custom_chars);
+        if (custom_size != 0) {
+            // Vectors and matrices are passed by pointer, so copy the value they point to
+            const void* value = va_arg(*arg_ptr, const void*);
+            logger_args_write(&writer, value, custom_size);
+            message += custom_chars;
+            continue;
+        }
+
+        LogSpec spec;
+        message = logger_parse_spec(message, &spec);
+        switch (spec.conversion) {
+            case 'd':
+            case 'i': {
+                int64_t value;
+                if (spec.size == LOG_SIZE_LONG_LONG) {
+                    value = va_arg(*arg_ptr, long long);
+                } else if (spec.size == LOG_SIZE_LONG) {
+                    value = va_arg(*arg_ptr, long);
+                } else if (spec.size == LOG_SIZE_SIZE_T) {
+                    value = va_arg(*arg_ptr, ptrdiff_t);
+                } else {
+                    value = va_arg(*arg_ptr, int);
+                }
+                logger_args_write(&writer, &value, sizeof(value));
                 break;
             }
-            case 's': {
-                out_ptr += sprintf(out_ptr, "%s", va_arg(arg_ptr, char*));
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                uint64_t value;
+                if (spec.size == LOG_SIZE_LONG_LONG) {
+                    value = va_arg(*arg_ptr, unsigned long long);
+                } else if (spec.size == LOG_SIZE_LONG) {
+                    value = va_arg(*arg_ptr, unsigned long);
+                } else if (spec.size == LOG_SIZE_SIZE_T) {
+                    value = va_arg(*arg_ptr, size_t);
+                } else {
+                    value = va_arg(*arg_ptr, unsigned int);
+                }
+                logger_args_write(&writer, &value, sizeof(value));
                 break;
             }
-            case 'i': {
-                out_ptr += sprintf(out_ptr, "%i", va_arg(arg_ptr, int));
+            case 'c': {
+                int32_t value = va_arg(*arg_ptr, int);
+                logger_args_write(&writer, &value, sizeof(value));
                 break;
             }
-            case 'u': {
-                out_ptr += sprintf(out_ptr, "%u", va_arg(arg_ptr, unsigned int));
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                double value = va_arg(*arg_ptr, double);
+                logger_args_write(&writer, &value, sizeof(value));
                 break;
             }
-            case 'f': {
-                out_ptr += sprintf(out_ptr, "%f", va_arg(arg_ptr, double));
+            case 'p': {
+                uint64_t value = (uint64_t)(uintptr_t)va_arg(*arg_ptr, void*);
+                logger_args_write(&writer, &value, sizeof(value));
                 break;
             }
-            case 'v': {
-                message++;
-                if (*message == '\0') {
-                    break;
-                }
-                switch (*message) {
-                    case '2': {
-                        if (*(message + 1) == 'i') {
-                            ivec2* v = va_arg(arg_ptr, ivec2*);
-                            out_ptr += sprintf(out_ptr, "<%i, %i>", v->x, v->y);
-                            break;
-                        } else {
-                            vec2* v = va_arg(arg_ptr, vec2*);
-                            out_ptr += sprintf(out_ptr, "<%f, %f>", v->x, v->y);
-                            break;
-                        }
-                    }
-                    case '3': {
-                        vec3* v = va_arg(arg_ptr, vec3*);
-                        out_ptr += sprintf(out_ptr, "<%f, %f, %f>", v->x, v->y, v->z);
-                        break;
-                    }
-                    case '4': {
-                        vec4* v = va_arg(arg_ptr, vec4*);
-                        out_ptr += sprintf(out_ptr, "<%f, %f, %f, %f>", v->x, v->y, v->z, v->w);
-                        break;
-                    }
+            case 's': {
+                // Strings are copied with a 16 bit length in front, cut short if they don't fit
+                const char* value = va_arg(*arg_ptr, const char*);
+                if (value == NULL) {
+                    value = "(null)";
                 }
-            } // end case v
-            case 'm': {
-                message++;
-                if (*message == '\0') {
+                size_t length = strlen(value);
+                size_t available = writer.capacity - writer.size;
+                if (available <= sizeof(uint16_t)) {
+                    writer.size = writer.capacity;
                     break;
                 }
-                switch (*message) {
-                    case '4': {
-                        mat4* m = va_arg(arg_ptr, mat4*);
-                        for (int i = 0; i < 4; i++) {
-                            out_ptr += sprintf(out_ptr, "[%f, %f, %f, %f]\n", (*m)[0][i], (*m)[1][i], (*m)[2][i], (*m)[3][i]);
-                        }
-                        break;
-                    }
+                if (length > available - sizeof(uint16_t)) {
+                    length = available - sizeof(uint16_t);
                 }
+                uint16_t stored_length = (uint16_t)length;
+                logger_args_write(&writer, &stored_length, sizeof(stored_length));
+                logger_args_write(&writer, value, length);
                 break;
             }
-            case 'q': {
-                quat* q = va_arg(arg_ptr, quat*);
-                out_ptr += sprintf(out_ptr, "<%f %f %f %f>", q->x, q->y, q->z, q->w);
+        }
+
+        if (*message != '\0') {
+            message++;
+        }
+    }
+
+    return writer.size;
+}
+
+struct LogArgsReader {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+};
+
+bool logger_args_read(LogArgsReader* reader, void* value, size_t size) {
+    if (reader->offset + size > reader->size) {
+        reader->offset = reader->size;
+        return false;
+    }
+    memcpy(value, reader->data + reader->offset, size);
+    reader->offset += size;
+    return true;
+}
+
+struct LogText {
+    char* buffer;
+    size_t capacity;
+    size_t length;
+};
+
+// Appends to the text, always leaving room for the trailing newline
+void logger_append(LogText* text, const char* format, ...) {
+    if (text->length + 2 >= text->capacity) {
+        return;
+    }
+
+    va_list arg_ptr;
+    va_start(arg_ptr, format);
+    int written = vsnprintf(text->buffer + text->length, text->capacity - 1 - text->length, format, arg_ptr);
+    va_end(arg_ptr);
+    if (written > 0) {
+        text->length = text->length + (size_t)written < text->capacity - 2 ? text->length + (size_t)written : text->capacity - 2;
+    }
+}
+
+// Formats one standard conversion. Arguments missing from a truncated record are left out.
+void logger_format_spec(LogText* text, const LogSpec* spec, LogArgsReader* reader) {
+    switch (spec->conversion) {
+        case 'd':
+        case 'i': {
+            int64_t value;
+            if (!logger_args_read(reader, &value, sizeof(value))) {
+                break;
+            }
+            if (spec->size == LOG_SIZE_LONG_LONG) {
+                logger_append(text, spec->text, (long long)value);
+            } else if (spec->size == LOG_SIZE_LONG) {
+                logger_append(text, spec->text, (long)value);
+            } else if (spec->size == LOG_SIZE_SIZE_T) {
+                logger_append(text, spec->text, (ptrdiff_t)value);
+            } else {
+                logger_append(text, spec->text, (int)value);
+            }
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o': {
+            uint64_t value;
+            if (!logger_args_read(reader, &value, sizeof(value))) {
+                break;
+            }
+            if (spec->size == LOG_SIZE_LONG_LONG) {
+                logger_append(text, spec->text, (unsigned long long)value);
+            } else if (spec->size == LOG_SIZE_LONG) {
+                logger_append(text, spec->text, (unsigned long)value);
+            } else if (spec->size == LOG_SIZE_SIZE_T) {
+                logger_append(text, spec->text, (size_t)value);
+            } else {
+                logger_append(text, spec->text, (unsigned int)value);
+            }
+            break;
+        }
+        case 'c': {
+            int32_t value;
+            if (logger_args_read(reader, &value, sizeof(value))) {
+                logger_append(text, spec->text, (int)value);
+            }
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G': {
+            double value;
+            if (logger_args_read(reader, &value, sizeof(value))) {
+                logger_append(text, spec->text, value);
+            }
+            break;
+        }
+        case 'p': {
+            uint64_t value;
+            if (logger_args_read(reader, &value, sizeof(value))) {
+                logger_append(text, spec->text, (void*)(uintptr_t)value);
+            }
+            break;
+        }
+        case 's': {
+            uint16_t length;
+            if (!logger_args_read(reader, &length, sizeof(length)) || reader->offset + length > reader->size) {
+                reader->offset = reader->size;
                 break;
             }
+            // The copy isn't null terminated, so pass the length through as the precision
+            char string_spec[24];
+            const char* precision = strchr(spec->text, '.');
+            size_t prefix_length = (size_t)((precision != NULL ? precision : spec->text + strlen(spec->text) - 1) - spec->text);
+            int max_length = length;
+            if (precision != NULL && atoi(precision + 1) < max_length) {
+                max_length = atoi(precision + 1);
+            }
+            snprintf(string_spec, sizeof(string_spec), "%.*s.*s", (int)prefix_length, spec->text);
+            logger_append(text, string_spec, max_length, (const char*)(reader->data + reader->offset));
+            reader->offset += length;
+            break;
+        }
+        case '%': {
+            logger_append(text, "%%");
+            break;
         }
+    }
+}
 
-        message++;
+void logger_format_custom(LogText* text, const char* message, LogArgsReader* reader) {
+    if (message[0] == 'v' && message[1] == '2' && message[2] == 'i') {
+        siren::ivec2 v;
+        if (logger_args_read(reader, &v, sizeof(v))) {
+            logger_append(text, "<%i, %i>", v.x, v.y);
+        }
+    } else if (message[0] == 'v' && message[1] == '2') {
+        siren::vec2 v;
+        if (logger_args_read(reader, &v, sizeof(v))) {
+            logger_append(text, "<%f, %f>", v.x, v.y);
+        }
+    } else if (message[0] == 'v' && message[1] == '3') {
+        siren::vec3 v;
+        if (logger_args_read(reader, &v, sizeof(v))) {
+            logger_append(text, "<%f, %f, %f>", v.x, v.y, v.z);
+        }
+    } else if (message[0] == 'v' && message[1] == '4') {
+        siren::vec4 v;
+        if (logger_args_read(reader, &v, sizeof(v))) {
+            logger_append(text, "<%f, %f, %f, %f>", v.x, v.y, v.z, v.w);
+        }
+    } else if (message[0] == 'm' && message[1] == '4') {
+        siren::mat4 m;
+        if (logger_args_read(reader, &m, sizeof(m))) {
+            for (int i = 0; i < 4; i++) {
+                logger_append(text, "[%f, %f, %f, %f]\n", m[0][i], m[1][i], m[2][i], m[3][i]);
+            }
+        }
+    } else if (message[0] == 'q') {
+        siren::quat q;
+        if (logger_args_read(reader, &q, sizeof(q))) {
+            logger_append(text, "<%f %f %f %f>", q.x, q.y, q.z, q.w);
+        }
     }
-    // vsnprintf(out_message, MESSAGE_LENGTH, message, arg_ptr);
-    va_end(arg_ptr);
+}
 
-    char log_message[MESSAGE_LENGTH];
-    sprintf(log_message, "%s%s\n", level_prefix[level], out_message);
+size_t siren::logger_format_record(char* buffer, size_t buffer_size, siren::LogLevel level, siren::LogCategory category, const char* message, const uint8_t* args, size_t args_size) {
+    LogText text = (LogText) {
+        .buffer = buffer,
+        .capacity = buffer_size,
+        .length = 0
+    };
+    LogArgsReader reader = (LogArgsReader) {
+        .data = args,
+        .size = args_size,
+        .offset = 0
+    };
+    if (buffer_size < 2) {
+        return 0;
+    }
 
-    if (is_error) {
-        logger_console_write_error(log_message, level);
+    // The engine category keeps the old plain prefix
+    if (category == LOG_CATEGORY_ENGINE) {
+        logger_append(&text, "[%s]: ", LOGGER_LEVEL_NAMES[level]);
     } else {
-        logger_console_write(log_message, level);
+        logger_append(&text, "[%s][%s]: ", LOGGER_LEVEL_NAMES[level], LOGGER_CATEGORY_NAMES[category]);
     }
+    while (*message != '\0') {
+        if (*message != '%') {
+            if (text.length + 2 < text.capacity) {
+                text.buffer[text.length] = *message;
+                text.length++;
+            }
+            message++;
+            continue;
+        }
 
-    if (initialized) {
-        fprintf(logfile, "%s", log_message);
-        fflush(logfile);
+        message++;
+        if (*message == '\0') {
+            break;
+        }
+
+        size_t custom_chars;
+        if (logger_custom_size(message, &custom_chars) != 0) {
+            logger_format_custom(&text, message, &reader);
+            message += custom_chars;
+            continue;
+        }
+
+        LogSpec spec;
+        message = logger_parse_spec(message, &spec);
+        logger_format_spec(&text, &spec, &reader);
+        if (*message != '\0') {
+            message++;
+        }
+    }
+    text.buffer[text.length] = '\n';
+    text.length++;
+    text.buffer[text.length] = '\0';
+
+    return text.length;
+}
+
+// Writer thread
+
+void logger_write_text(siren::LogLevel level, const char* text, size_t length) {
+    if (level == siren::LOG_LEVEL_ERROR) {
+        logger_console_write_error(text, level);
     } else {
-        logger_console_write("[WARN]: Called logger_output() without initializing logger. Log statement will not be written to file.", LOG_LEVEL_WARN);
+        logger_console_write(text, level);
+    }
+    if (state.logfile != NULL && !state.is_binary) {
+        fwrite(text, 1, length, state.logfile);
+    }
+}
+
+void logger_write_binary(const LogRecord* record) {
+    if (state.logfile == NULL) {
+        return;
+    }
+
+    uint64_t message_id = (uint64_t)(uintptr_t)record->message;
+    if (state.written_messages.find(record->message) == state.written_messages.end()) {
+        state.written_messages.insert(record->message);
+        uint8_t entry = siren::LOG_BINARY_ENTRY_FORMAT;
+        siren::LogBinaryFormat format = (siren::LogBinaryFormat) {
+            .message_id = message_id,
+            .length = (uint32_t)strlen(record->message)
+        };
+        fwrite(&entry, sizeof(entry), 1, state.logfile);
+        fwrite(&format, sizeof(format), 1, state.logfile);
+        fwrite(record->message, 1, format.length, state.logfile);
+    }
+
+    uint8_t entry = siren::LOG_BINARY_ENTRY_RECORD;
+    siren::LogBinaryRecord header = (siren::LogBinaryRecord) {
+        .message_id = message_id,
+        .args_size = record->args_size,
+        .level = record->level,
+        .category = record->category
+    };
+    fwrite(&entry, sizeof(entry), 1, state.logfile);
+    fwrite(&header, sizeof(header), 1, state.logfile);
+    fwrite(record->args, 1, record->args_size, state.logfile);
+}
+
+void logger_writer_main() {
+    char text[LOGGER_MESSAGE_LENGTH];
+    std::chrono::steady_clock::time_point last_flush_time = std::chrono::steady_clock::now();
+    bool has_unflushed_records = false;
+
+    while (true) {
+        bool is_quitting = state.is_quitting.load(std::memory_order_acquire);
+        bool is_flush_requested = state.is_flush_requested.exchange(false, std::memory_order_acq_rel);
+        bool has_error = false;
+
+        LogRecord* record;
+        while ((record = logger_ring_peek()) != NULL) {
+            siren::LogLevel level = (siren::LogLevel)record->level;
+            if (state.is_binary) {
+                logger_write_binary(record);
+            }
+            if (!state.is_binary || level <= siren::LOG_LEVEL_WARN) {
+                size_t length = siren::logger_format_record(text, sizeof(text), level, (siren::LogCategory)record->category, record->message, record->args, record->args_size);
+                logger_write_text(level, text, length);
+            }
+            has_error = has_error || level == siren::LOG_LEVEL_ERROR;
+            has_unflushed_records = true;
+            logger_ring_pop(record);
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (has_error || is_flush_requested || is_quitting || now - last_flush_time >= LOGGER_FLUSH_INTERVAL) {
+            if (has_unflushed_records) {
+                if (state.logfile != NULL) {
+                    fflush(state.logfile);
+                }
+                fflush(stdout);
+                has_unflushed_records = false;
+            }
+            last_flush_time = now;
+            {
+                std::lock_guard<std::mutex> lock(state.writer_mutex);
+                state.flushed_position.store(state.dequeue_position.load(std::memory_order_relaxed), std::memory_order_release);
+            }
+            state.flushed_condition.notify_all();
+        }
+
+        if (is_quitting) {
+            break;
+        }
+
+        // Producers only wake the writer for errors, flushes and a half full ring, otherwise it drains on a timer
+        std::unique_lock<std::mutex> lock(state.writer_mutex);
+        state.is_writer_sleeping.store(true, std::memory_order_relaxed);
+        state.writer_condition.wait_for(lock, LOGGER_WRITE_INTERVAL, []() {
+            return state.is_quitting.load(std::memory_order_acquire) || state.is_flush_requested.load(std::memory_order_acquire);
+        });
+        state.is_writer_sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void siren::logger_output(siren::LogLevel level, siren::LogCategory category, const char* message, ...) {
+    bool is_error = level == LOG_LEVEL_ERROR;
+
+    va_list arg_ptr;
+    va_start(arg_ptr, message);
+    size_t args_size = logger_capture_args(message, &arg_ptr, log_args, LOGGER_ARGS_SIZE);
+    va_end(arg_ptr);
+
+    if (!initialized) {
+        char text[LOGGER_MESSAGE_LENGTH];
+        logger_format_record(text, sizeof(text), level, category, message, log_args, args_size);
+        if (is_error) {
+            logger_console_write_error(text, level);
+        } else {
+            logger_console_write(text, level);
+        }
+        logger_console_write("[WARN]: Called logger_output() without initializing logger. Log statement will not be written to file.\n", LOG_LEVEL_WARN);
+        return;
+    }
+
+    if (!logger_ring_push(level, category, message, log_args, (uint32_t)args_size)) {
+        // The writer has fallen a whole ring behind, so wait for it rather than lose the message
+        logger_wake_writer();
+        while (!logger_ring_push(level, category, message, log_args, (uint32_t)args_size)) {
+            std::this_thread::yield();
+        }
+    }
+
+    if (is_error) {
+        logger_wake_writer();
+    } else if (state.is_writer_sleeping.load(std::memory_order_relaxed) &&
+               state.enqueue_position.load(std::memory_order_relaxed) - state.dequeue_position.load(std::memory_order_relaxed) >= LOGGER_RING_CAPACITY / 2) {
+        state.writer_condition.notify_one();
     }
 }
 
 void report_assertion_failure(const char* expression, const char* message, const char* file, int line) {
-    siren::logger_output(siren::LOG_LEVEL_ERROR, "Assertion failure: %s, message: '%s', in file: %s, line %d\n", expression, message, file, line);
+    siren::logger_output(siren::LOG_LEVEL_ERROR, siren::LOG_CATEGORY_ENGINE, "Assertion failure: %s, message: '%s', in file: %s, line %d\n", expression, message, file, line);
+    // The debug break that follows would lose anything still in the ring
+    siren::logger_flush();
 }
 
 // Platform specific console output
@@ -195,16 +845,16 @@ void logger_console_write_error(const char* message, uint8_t color) {
 
 #else
 
-void platform_console_write(const char* message, uint8_t color) {
+void logger_console_write(const char* message, uint8_t color) {
     // ERROR,WARN,INFO,TRACE
     const char* colour_strings[] = {"1;31", "1;33", "1;32", "1;30"};
-    printf("\033[%sm%s\033[0m", colour_strings[colour], message);
+    printf("\033[%sm%s\033[0m", colour_strings[color], message);
 }
 
-void platform_console_write_error(const char* message, uint8_t color) {
+void logger_console_write_error(const char* message, uint8_t color) {
     // ERROR,WARN,INFO,TRACE
     const char* colour_strings[] = {"1;31", "1;33", "1;32", "1;30"};
-    fprintf(stderr, "\033[%sm%s\033[0m", colour_strings[colour], message);
+    fprintf(stderr, "\033[%sm%s\033[0m", colour_strings[color], message);
 }
 
 #endif
\ No newline at end of file
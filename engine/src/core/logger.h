@@ -2,10 +2,20 @@
 
 #include "defines.h"
 
+#include <cstddef>
+
 #ifndef SIREN_LEVEL
 #define SIREN_LEVEL 3
 #endif
 
+/*
+ * The category that the SIREN_* log macros use. A source file can log under another category by defining this
+ * before its includes, e.g. #define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_RENDERER
+ */
+#ifndef SIREN_LOG_CATEGORY
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_ENGINE
+#endif
+
 namespace siren {
     enum LogLevel {
         LOG_LEVEL_ERROR = 0,
@@ -14,27 +24,103 @@ namespace siren {
         LOG_LEVEL_TRACE = 3
     };
 
-    bool logger_init();
+    enum LogCategory {
+        LOG_CATEGORY_ENGINE,
+        LOG_CATEGORY_RENDERER,
+        LOG_CATEGORY_MODEL,
+        LOG_CATEGORY_TEXTURE,
+        LOG_CATEGORY_FONT,
+        LOG_CATEGORY_INPUT,
+        LOG_CATEGORY_GAME,
+        LOG_CATEGORY_COUNT
+    };
+
+    // One bit per LogLevel
+    enum LogMask {
+        LOG_MASK_ERROR = 1 << LOG_LEVEL_ERROR,
+        LOG_MASK_WARN = 1 << LOG_LEVEL_WARN,
+        LOG_MASK_INFO = 1 << LOG_LEVEL_INFO,
+        LOG_MASK_TRACE = 1 << LOG_LEVEL_TRACE,
+        LOG_MASK_ALL = LOG_MASK_ERROR | LOG_MASK_WARN | LOG_MASK_INFO | LOG_MASK_TRACE
+    };
+
+    /*
+     * Log calls only copy their arguments into a lock-free ring, so logging is safe from any thread. A writer thread
+     * formats them and writes them out, flushing periodically and after every error. Because formatting is deferred,
+     * the message passed to the SIREN_* macros must be a string literal.
+     *
+     * In binary mode the writer skips formatting and saves the raw records to console.bin instead of console.log,
+     * which log-decoder turns back into text. Warnings and errors are still formatted to the console.
+     */
+    bool logger_init(bool is_binary);
     void logger_quit();
-    SIREN_API void logger_output(LogLevel level, const char* message, ...);
+    SIREN_API void logger_output(LogLevel level, LogCategory category, const char* message, ...);
+    // Blocks until everything logged so far has been written and flushed
+    SIREN_API void logger_flush();
+
+    /*
+     * Every category starts with LOG_MASK_ALL, unless it was given a mask before logger_init, which keeps it.
+     * Levels above SIREN_LEVEL are compiled out regardless of the mask.
+     */
+    SIREN_API void logger_set_mask(LogCategory category, uint32_t level_mask);
+    SIREN_API uint32_t logger_get_mask(LogCategory category);
+    SIREN_API bool logger_is_enabled(LogLevel level, LogCategory category);
+
+    /*
+     * console.bin starts with LOG_BINARY_MAGIC and LOG_BINARY_VERSION, followed by entries that each start with a LogBinaryEntry byte.
+     * A format entry is a LogBinaryFormat followed by the message text, and is written before the first record that uses that message.
+     * A record entry is a LogBinaryRecord followed by args_size bytes of arguments.
+     */
+    static const char LOG_BINARY_MAGIC[4] = { 'S', 'L', 'O', 'G' };
+    static const uint32_t LOG_BINARY_VERSION = 1;
+
+    enum LogBinaryEntry {
+        LOG_BINARY_ENTRY_FORMAT,
+        LOG_BINARY_ENTRY_RECORD
+    };
+
+    struct LogBinaryFormat {
+        uint64_t message_id;
+        uint32_t length;
+    };
+
+    struct LogBinaryRecord {
+        uint64_t message_id;
+        uint16_t args_size;
+        uint8_t level;
+        uint8_t category;
+    };
+
+    SIREN_API const char* logger_category_name(LogCategory category);
+    /*
+     * Formats a captured record as a line of text, the same as the writer would, and returns its length.
+     * args and args_size are the raw arguments as stored in a binary log.
+     */
+    SIREN_API size_t logger_format_record(char* buffer, size_t buffer_size, LogLevel level, LogCategory category, const char* message, const uint8_t* args, size_t args_size);
 }
 
-#define SIREN_ERROR(message, ...) logger_output(siren::LOG_LEVEL_ERROR, message, ##__VA_ARGS__);
+#define SIREN_LOG(level, message, ...) do { \
+    if (siren::logger_is_enabled(level, SIREN_LOG_CATEGORY)) { \
+        siren::logger_output(level, SIREN_LOG_CATEGORY, message, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define SIREN_ERROR(message, ...) SIREN_LOG(siren::LOG_LEVEL_ERROR, message, ##__VA_ARGS__)
 
 #if SIREN_LEVEL >= 1
-#define SIREN_WARN(message, ...) logger_output(siren::LOG_LEVEL_WARN, message, ##__VA_ARGS__);
+#define SIREN_WARN(message, ...) SIREN_LOG(siren::LOG_LEVEL_WARN, message, ##__VA_ARGS__)
 #else
 #define SIREN_WARN(message, ...)
 #endif
 
 #if SIREN_LEVEL >= 2
-#define SIREN_INFO(message, ...) logger_output(siren::LOG_LEVEL_INFO, message, ##__VA_ARGS__);
+#define SIREN_INFO(message, ...) SIREN_LOG(siren::LOG_LEVEL_INFO, message, ##__VA_ARGS__)
 #else
 #define SIREN_INFO(message, ...)
 #endif
 
 #if SIREN_LEVEL >= 3
-#define SIREN_TRACE(message, ...) logger_output(siren::LOG_LEVEL_TRACE, message, ##__VA_ARGS__);
+#define SIREN_TRACE(message, ...) SIREN_LOG(siren::LOG_LEVEL_TRACE, message, ##__VA_ARGS__)
 #else
 #define SIREN_TRACE(message, ...)
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,275 @@
+#include "memory.h"
+
+#include "core/logger.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+static const uint32_t MEMORY_LOG_MAX_ASSETS = 8;
+
+struct MemoryAssetRecord {
+    siren::MemoryTag tag;
+    uint64_t bytes[siren::MEMORY_KIND_COUNT];
+};
+
+struct MemoryState {
+    // Loads can happen on the render thread and on job threads, so the ledger is locked
+    std::mutex mutex;
+    siren::MemoryReport report;
+    std::unordered_map<std::string, MemoryAssetRecord> assets;
+};
+
+static MemoryState state;
+
+static const char* MEMORY_TAG_NAMES[siren::MEMORY_TAG_COUNT] = {
+    "engine",
+    "arena",
+    "renderer",
+    "model",
+    "texture",
+    "font",
+    "geometry"
+};
+
+static const char* MEMORY_KIND_NAMES[siren::MEMORY_KIND_COUNT] = {
+    "cpu",
+    "vertex",
+    "index",
+    "uniform",
+    "texture",
+    "renderbuffer"
+};
+
+// Callers hold the lock
+void memory_record(siren::MemoryTag tag, siren::MemoryKind kind, const char* asset, size_t bytes, bool is_alloc) {
+    siren::MemoryTagStats& tag_stats = state.report.tags[tag];
+    if (is_alloc) {
+        tag_stats.bytes[kind] += bytes;
+        tag_stats.allocation_count++;
+        if (tag_stats.bytes[kind] > tag_stats.peak_bytes[kind]) {
+            tag_stats.peak_bytes[kind] = tag_stats.bytes[kind];
+        }
+        state.report.total_bytes[kind] += bytes;
+    } else {
+        if (tag_stats.bytes[kind] < bytes || tag_stats.allocation_count == 0) {
+            SIREN_WARN("Memory freed from tag %s that was never allocated (%llu bytes of %s).", MEMORY_TAG_NAMES[tag], (unsigned long long)bytes, MEMORY_KIND_NAMES[kind]);
+            return;
+        }
+        tag_stats.bytes[kind] -= bytes;
+        tag_stats.allocation_count--;
+        state.report.total_bytes[kind] -= bytes;
+    }
+
+    if (asset == NULL) {
+        return;
+    }
+
+    auto it = state.assets.find(asset);
+    if (it == state.assets.end()) {
+        if (!is_alloc) {
+            return;
+        }
+        MemoryAssetRecord record;
+        memset(&record, 0, sizeof(record));
+        record.tag = tag;
+        it = state.assets.emplace(std::string(asset), record).first;
+    }
+    if (is_alloc) {
+        it->second.bytes[kind] += bytes;
+        return;
+    }
+
+    it->second.bytes[kind] -= std::min(it->second.bytes[kind], (uint64_t)bytes);
+    for (uint32_t index = 0; index < siren::MEMORY_KIND_COUNT; index++) {
+        if (it->second.bytes[index] != 0) {
+            return;
+        }
+    }
+    state.assets.erase(it);
+}
+
+siren::MemoryTextureFormatStats* memory_find_texture_format(const char* format) {
+    for (uint32_t index = 0; index < state.report.texture_format_count; index++) {
+        siren::MemoryTextureFormatStats& stats = state.report.texture_formats[index];
+        if (stats.name == format || strcmp(stats.name, format) == 0) {
+            return &stats;
+        }
+    }
+    if (state.report.texture_format_count == siren::MEMORY_MAX_TEXTURE_FORMATS) {
+        return NULL;
+    }
+
+    siren::MemoryTextureFormatStats* stats = &state.report.texture_formats[state.report.texture_format_count];
+    state.report.texture_format_count++;
+    stats->name = format;
+    stats->bytes = 0;
+    return stats;
+}
+
+void siren::memory_track_alloc(siren::MemoryTag tag, siren::MemoryKind kind, const char* asset, size_t bytes) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    memory_record(tag, kind, asset, bytes, true);
+}
+
+void siren::memory_track_free(siren::MemoryTag tag, siren::MemoryKind kind, const char* asset, size_t bytes) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    memory_record(tag, kind, asset, bytes, false);
+}
+
+void siren::memory_track_texture_alloc(siren::MemoryTag tag, const char* asset, const char* format, uint32_t mip_level, size_t bytes) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    memory_record(tag, MEMORY_KIND_TEXTURE, asset, bytes, true);
+
+    MemoryTextureFormatStats* format_stats = memory_find_texture_format(format);
+    if (format_stats != NULL) {
+        format_stats->bytes += bytes;
+    }
+    state.report.texture_mip_bytes[std::min(mip_level, MEMORY_MAX_MIP_LEVELS - 1)] += bytes;
+}
+
+void siren::memory_track_texture_free(siren::MemoryTag tag, const char* asset, const char* format, uint32_t mip_level, size_t bytes) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    memory_record(tag, MEMORY_KIND_TEXTURE, asset, bytes, false);
+
+    MemoryTextureFormatStats* format_stats = memory_find_texture_format(format);
+    if (format_stats != NULL) {
+        format_stats->bytes -= std::min(format_stats->bytes, (uint64_t)bytes);
+    }
+    uint64_t& mip_bytes = state.report.texture_mip_bytes[std::min(mip_level, MEMORY_MAX_MIP_LEVELS - 1)];
+    mip_bytes -= std::min(mip_bytes, (uint64_t)bytes);
+}
+
+siren::MemoryReport siren::memory_report() {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    MemoryReport report = state.report;
+    report.asset_count = (uint32_t)state.assets.size();
+    return report;
+}
+
+uint64_t memory_asset_total(const uint64_t* bytes) {
+    uint64_t total = 0;
+    for (uint32_t index = 0; index < siren::MEMORY_KIND_COUNT; index++) {
+        total += bytes[index];
+    }
+    return total;
+}
+
+uint32_t siren::memory_get_asset_stats(siren::MemoryAssetStats* assets, uint32_t max_assets) {
+    std::vector<MemoryAssetStats> sorted;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        sorted.reserve(state.assets.size());
+        for (auto& it : state.assets) {
+            MemoryAssetStats stats;
+            snprintf(stats.name, sizeof(stats.name), "%s", it.first.c_str());
+            stats.tag = it.second.tag;
+            memcpy(stats.bytes, it.second.bytes, sizeof(stats.bytes));
+            sorted.push_back(stats);
+        }
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const MemoryAssetStats& a, const MemoryAssetStats& b) {
+        return memory_asset_total(a.bytes) > memory_asset_total(b.bytes);
+    });
+    uint32_t count = std::min(max_assets, (uint32_t)sorted.size());
+    for (uint32_t index = 0; index < count; index++) {
+        assets[index] = sorted[index];
+    }
+
+    return (uint32_t)sorted.size();
+}
+
+void memory_format_bytes(char* buffer, size_t buffer_size, uint64_t bytes) {
+    if (bytes >= 1024 * 1024) {
+        snprintf(buffer, buffer_size, "%.2f MiB", (double)bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024) {
+        snprintf(buffer, buffer_size, "%.1f KiB", (double)bytes / 1024.0);
+    } else {
+        snprintf(buffer, buffer_size, "%llu B", (unsigned long long)bytes);
+    }
+}
+
+// Appends "kind size, kind size" for every non-zero kind
+void memory_format_kinds(char* buffer, size_t buffer_size, const uint64_t* bytes) {
+    size_t length = 0;
+    buffer[0] = '\0';
+    for (uint32_t kind = 0; kind < siren::MEMORY_KIND_COUNT && length < buffer_size; kind++) {
+        if (bytes[kind] == 0) {
+            continue;
+        }
+        char size[32];
+        memory_format_bytes(size, sizeof(size), bytes[kind]);
+        int written = snprintf(buffer + length, buffer_size - length, "%s%s %s", length == 0 ? "" : ", ", MEMORY_KIND_NAMES[kind], size);
+        if (written < 0) {
+            break;
+        }
+        length += (size_t)written;
+    }
+    if (length == 0) {
+        snprintf(buffer, buffer_size, "none");
+    }
+}
+
+void siren::memory_log_report() {
+    MemoryReport report = memory_report();
+    char line[512];
+
+    memory_format_kinds(line, sizeof(line), report.total_bytes);
+    SIREN_INFO("Memory: %s", line);
+    for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        if (memory_asset_total(report.tags[tag].bytes) == 0) {
+            continue;
+        }
+        memory_format_kinds(line, sizeof(line), report.tags[tag].bytes);
+        SIREN_INFO("    %-10s %s (%u allocations)", MEMORY_TAG_NAMES[tag], line, report.tags[tag].allocation_count);
+    }
+
+    if (report.total_bytes[MEMORY_KIND_TEXTURE] != 0) {
+        size_t length = 0;
+        line[0] = '\0';
+        for (uint32_t index = 0; index < report.texture_format_count && length < sizeof(line); index++) {
+            if (report.texture_formats[index].bytes == 0) {
+                continue;
+            }
+            char size[32];
+            memory_format_bytes(size, sizeof(size), report.texture_formats[index].bytes);
+            length += snprintf(line + length, sizeof(line) - length, "%s%s %s", length == 0 ? "" : ", ", report.texture_formats[index].name, size);
+        }
+        SIREN_INFO("    texture formats: %s", line);
+
+        length = 0;
+        line[0] = '\0';
+        for (uint32_t level = 0; level < MEMORY_MAX_MIP_LEVELS && length < sizeof(line); level++) {
+            if (report.texture_mip_bytes[level] == 0) {
+                continue;
+            }
+            char size[32];
+            memory_format_bytes(size, sizeof(size), report.texture_mip_bytes[level]);
+            length += snprintf(line + length, sizeof(line) - length, "%smip %u %s", length == 0 ? "" : ", ", level, size);
+        }
+        SIREN_INFO("    texture levels: %s", line);
+    }
+
+    MemoryAssetStats assets[MEMORY_LOG_MAX_ASSETS];
+    uint32_t asset_count = memory_get_asset_stats(assets, MEMORY_LOG_MAX_ASSETS);
+    for (uint32_t index = 0; index < std::min(asset_count, MEMORY_LOG_MAX_ASSETS); index++) {
+        memory_format_kinds(line, sizeof(line), assets[index].bytes);
+        SIREN_INFO("    [%s] %s: %s", MEMORY_TAG_NAMES[assets[index].tag], assets[index].name, line);
+    }
+    if (asset_count > MEMORY_LOG_MAX_ASSETS) {
+        SIREN_INFO("    ...and %u more assets", asset_count - MEMORY_LOG_MAX_ASSETS);
+    }
+}
+
+const char* siren::memory_tag_name(siren::MemoryTag tag) {
+    return MEMORY_TAG_NAMES[tag];
+}
+
+const char* siren::memory_kind_name(siren::MemoryKind kind) {
+    return MEMORY_KIND_NAMES[kind];
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+
+namespace siren {
+    // The subsystem that owns an allocation
+    enum MemoryTag {
+        MEMORY_TAG_ENGINE,
+        MEMORY_TAG_ARENA,
+        MEMORY_TAG_RENDERER,
+        MEMORY_TAG_MODEL,
+        MEMORY_TAG_TEXTURE,
+        MEMORY_TAG_FONT,
+        MEMORY_TAG_GEOMETRY,
+        MEMORY_TAG_COUNT
+    };
+
+    // Where an allocation lives
+    enum MemoryKind {
+        MEMORY_KIND_CPU,
+        MEMORY_KIND_VERTEX_BUFFER,
+        MEMORY_KIND_INDEX_BUFFER,
+        MEMORY_KIND_UNIFORM_BUFFER,
+        MEMORY_KIND_TEXTURE,
+        MEMORY_KIND_RENDERBUFFER,
+        MEMORY_KIND_COUNT
+    };
+
+    static const uint32_t MEMORY_MAX_MIP_LEVELS = 16;
+    static const uint32_t MEMORY_MAX_TEXTURE_FORMATS = 16;
+    static const uint32_t MEMORY_ASSET_NAME_LENGTH = 96;
+
+    struct MemoryTagStats {
+        uint64_t bytes[MEMORY_KIND_COUNT];
+        uint64_t peak_bytes[MEMORY_KIND_COUNT];
+        // Allocations currently alive
+        uint32_t allocation_count;
+    };
+
+    struct MemoryTextureFormatStats {
+        const char* name;
+        uint64_t bytes;
+    };
+
+    struct MemoryReport {
+        uint64_t total_bytes[MEMORY_KIND_COUNT];
+        MemoryTagStats tags[MEMORY_TAG_COUNT];
+
+        // Texture memory broken down by storage format and by mip level, across all tags
+        uint32_t texture_format_count;
+        MemoryTextureFormatStats texture_formats[MEMORY_MAX_TEXTURE_FORMATS];
+        uint64_t texture_mip_bytes[MEMORY_MAX_MIP_LEVELS];
+
+        uint32_t asset_count;
+    };
+
+    struct MemoryAssetStats {
+        char name[MEMORY_ASSET_NAME_LENGTH];
+        MemoryTag tag;
+        uint64_t bytes[MEMORY_KIND_COUNT];
+    };
+
+    /*
+     * Records an allocation against a tag, and against an asset if asset isn't NULL.
+     * Nothing is allocated here, this is only a ledger. Every alloc should be matched by a free with the same arguments.
+     */
+    SIREN_API void memory_track_alloc(MemoryTag tag, MemoryKind kind, const char* asset, size_t bytes);
+    SIREN_API void memory_track_free(MemoryTag tag, MemoryKind kind, const char* asset, size_t bytes);
+    // Texture storage is recorded a mip level at a time so that it can be reported by format and level. format should be a string literal.
+    SIREN_API void memory_track_texture_alloc(MemoryTag tag, const char* asset, const char* format, uint32_t mip_level, size_t bytes);
+    SIREN_API void memory_track_texture_free(MemoryTag tag, const char* asset, const char* format, uint32_t mip_level, size_t bytes);
+
+    SIREN_API MemoryReport memory_report();
+    /*
+     * Returns the number of assets currently holding memory.
+     * Writes up to max_assets of them into assets, sorted by total size.
+     */
+    SIREN_API uint32_t memory_get_asset_stats(MemoryAssetStats* assets, uint32_t max_assets);
+    // Logs totals per kind and tag, texture memory by format and mip level, and the largest assets
+    SIREN_API void memory_log_report();
+
+    SIREN_API const char* memory_tag_name(MemoryTag tag);
+    SIREN_API const char* memory_kind_name(MemoryKind kind);
+}
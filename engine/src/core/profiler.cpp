@@ -0,0 +1,349 @@
+#include "profiler.h"
+
+#include "core/logger.h"
+
+#include <SDL2/SDL.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+static const uint32_t PROFILER_EVENT_CAPACITY = 1 << 16;
+static const uint32_t PROFILER_MAX_DEPTH = 64;
+static const uint32_t PROFILER_ZONE_TABLE_SIZE = 256;
+static const uint32_t PROFILER_THREAD_NAME_LENGTH = 32;
+
+// Frame time histogram buckets are 0.1ms wide, frames over 100ms go in the last bucket
+static const uint32_t PROFILER_HISTOGRAM_BUCKETS = 1001;
+static const float PROFILER_HISTOGRAM_BUCKET_WIDTH = 0.1f;
+
+struct ProfilerEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    uint32_t depth;
+};
+
+struct ProfilerZoneEntry {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> call_count;
+    std::atomic<uint64_t> total_ticks;
+};
+
+// Each thread writes only to its own buffer, so recording never takes a lock
+struct ProfilerThreadBuffer {
+    uint32_t thread_id;
+    char thread_name[PROFILER_THREAD_NAME_LENGTH];
+
+    ProfilerEvent events[PROFILER_EVENT_CAPACITY];
+    std::atomic<uint64_t> event_count;
+
+    const char* stack_names[PROFILER_MAX_DEPTH];
+    uint64_t stack_starts[PROFILER_MAX_DEPTH];
+    uint32_t depth;
+
+    ProfilerZoneEntry zones[PROFILER_ZONE_TABLE_SIZE];
+};
+
+struct ProfilerState {
+    uint64_t start_time;
+    uint64_t frequency;
+
+    std::mutex thread_buffers_mutex;
+    std::vector<ProfilerThreadBuffer*> thread_buffers;
+
+    uint32_t histogram[PROFILER_HISTOGRAM_BUCKETS];
+    uint32_t frame_count;
+    double frame_time_sum;
+    float frame_time_max;
+};
+
+static bool initialized = false;
+static ProfilerState state;
+static thread_local ProfilerThreadBuffer* thread_buffer = NULL;
+
+ProfilerThreadBuffer* profiler_get_thread_buffer() {
+    if (thread_buffer != NULL) {
+        return thread_buffer;
+    }
+
+    thread_buffer = new ProfilerThreadBuffer();
+    thread_buffer->event_count = 0;
+    thread_buffer->depth = 0;
+    for (uint32_t i = 0; i < PROFILER_ZONE_TABLE_SIZE; i++) {
+        thread_buffer->zones[i].name = NULL;
+        thread_buffer->zones[i].call_count = 0;
+        thread_buffer->zones[i].total_ticks = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(state.thread_buffers_mutex);
+    thread_buffer->thread_id = (uint32_t)state.thread_buffers.size();
+    snprintf(thread_buffer->thread_name, PROFILER_THREAD_NAME_LENGTH, "thread %u", thread_buffer->thread_id);
+    state.thread_buffers.push_back(thread_buffer);
+
+    return thread_buffer;
+}
+
+bool siren::profiler_init() {
+    if (initialized) {
+        return true;
+    }
+
+    state.frequency = SDL_GetPerformanceFrequency();
+    state.start_time = SDL_GetPerformanceCounter();
+    memset(state.histogram, 0, sizeof(state.histogram));
+    state.frame_count = 0;
+    state.frame_time_sum = 0.0;
+    state.frame_time_max = 0.0f;
+
+    initialized = true;
+    profiler_set_thread_name("main");
+
+    return true;
+}
+
+void siren::profiler_quit() {
+    if (!initialized) {
+        return;
+    }
+
+    ProfilerFrameStats stats = profiler_get_frame_stats();
+    SIREN_INFO("Frame times over %u frames: avg %fms p50 %fms p95 %fms p99 %fms max %fms", stats.frame_count, stats.average, stats.p50, stats.p95, stats.p99, stats.max);
+
+    // Thread buffers are intentionally leaked since worker threads may still hold a pointer to theirs
+    initialized = false;
+}
+
+void siren::profiler_frame_end(float frame_time) {
+    if (!initialized) {
+        return;
+    }
+
+    float frame_time_ms = frame_time * 1000.0f;
+    uint32_t bucket = (uint32_t)(frame_time_ms / PROFILER_HISTOGRAM_BUCKET_WIDTH);
+    if (bucket >= PROFILER_HISTOGRAM_BUCKETS) {
+        bucket = PROFILER_HISTOGRAM_BUCKETS - 1;
+    }
+
+    state.histogram[bucket]++;
+    state.frame_count++;
+    state.frame_time_sum += frame_time_ms;
+    state.frame_time_max = std::max(state.frame_time_max, frame_time_ms);
+}
+
+void siren::profiler_zone_begin(const char* name) {
+    if (!initialized) {
+        return;
+    }
+
+    ProfilerThreadBuffer* buffer = profiler_get_thread_buffer();
+    if (buffer->depth < PROFILER_MAX_DEPTH) {
+        buffer->stack_names[buffer->depth] = name;
+        buffer->stack_starts[buffer->depth] = SDL_GetPerformanceCounter();
+    }
+    buffer->depth++;
+}
+
+void siren::profiler_zone_end() {
+    if (!initialized || thread_buffer == NULL || thread_buffer->depth == 0) {
+        return;
+    }
+
+    uint64_t end = SDL_GetPerformanceCounter();
+    ProfilerThreadBuffer* buffer = thread_buffer;
+    buffer->depth--;
+    if (buffer->depth >= PROFILER_MAX_DEPTH) {
+        return;
+    }
+
+    const char* name = buffer->stack_names[buffer->depth];
+    uint64_t start = buffer->stack_starts[buffer->depth];
+
+    // Append to the ring buffer, overwriting the oldest event once full
+    uint64_t event_index = buffer->event_count.load(std::memory_order_relaxed);
+    buffer->events[event_index % PROFILER_EVENT_CAPACITY] = (ProfilerEvent) {
+        .name = name,
+        .start = start,
+        .end = end,
+        .depth = buffer->depth
+    };
+    buffer->event_count.store(event_index + 1, std::memory_order_release);
+
+    // Accumulate into the zone table, keyed on the name pointer
+    uint32_t slot = (uint32_t)(((uintptr_t)name >> 3) % PROFILER_ZONE_TABLE_SIZE);
+    for (uint32_t probe = 0; probe < PROFILER_ZONE_TABLE_SIZE; probe++) {
+        ProfilerZoneEntry& zone = buffer->zones[(slot + probe) % PROFILER_ZONE_TABLE_SIZE];
+        const char* zone_name = zone.name.load(std::memory_order_relaxed);
+        if (zone_name == NULL) {
+            zone.name.store(name, std::memory_order_release);
+            zone_name = name;
+        }
+        if (zone_name == name) {
+            zone.call_count.store(zone.call_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            zone.total_ticks.store(zone.total_ticks.load(std::memory_order_relaxed) + (end - start), std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+void siren::profiler_set_thread_name(const char* name) {
+    if (!initialized) {
+        return;
+    }
+
+    ProfilerThreadBuffer* buffer = profiler_get_thread_buffer();
+    snprintf(buffer->thread_name, PROFILER_THREAD_NAME_LENGTH, "%s", name);
+}
+
+siren::ProfilerFrameStats siren::profiler_get_frame_stats() {
+    ProfilerFrameStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (!initialized || state.frame_count == 0) {
+        return stats;
+    }
+
+    stats.frame_count = state.frame_count;
+    stats.average = (float)(state.frame_time_sum / (double)state.frame_count);
+    stats.max = state.frame_time_max;
+
+    // Walk the histogram and report the upper edge of the bucket each percentile lands in
+    const float percentiles[3] = { 0.50f, 0.95f, 0.99f };
+    float* results[3] = { &stats.p50, &stats.p95, &stats.p99 };
+    uint32_t percentile_index = 0;
+    uint64_t running_count = 0;
+    for (uint32_t bucket = 0; bucket < PROFILER_HISTOGRAM_BUCKETS && percentile_index < 3; bucket++) {
+        running_count += state.histogram[bucket];
+        while (percentile_index < 3 && (float)running_count >= percentiles[percentile_index] * (float)state.frame_count) {
+            *results[percentile_index] = std::min((float)(bucket + 1) * PROFILER_HISTOGRAM_BUCKET_WIDTH, state.frame_time_max);
+            percentile_index++;
+        }
+    }
+
+    return stats;
+}
+
+uint32_t siren::profiler_get_zone_stats(siren::ProfilerZoneStats* zones, uint32_t max_zones) {
+    if (!initialized) {
+        return 0;
+    }
+
+    // Merge each thread's table by zone name, since the same zone can run on several threads
+    std::vector<ProfilerZoneStats> merged;
+    {
+        std::lock_guard<std::mutex> lock(state.thread_buffers_mutex);
+        for (ProfilerThreadBuffer* buffer : state.thread_buffers) {
+            for (uint32_t i = 0; i < PROFILER_ZONE_TABLE_SIZE; i++) {
+                const char* name = buffer->zones[i].name.load(std::memory_order_acquire);
+                uint64_t call_count = buffer->zones[i].call_count.load(std::memory_order_relaxed);
+                if (name == NULL || call_count == 0) {
+                    continue;
+                }
+
+                double total_time = (double)buffer->zones[i].total_ticks.load(std::memory_order_relaxed) * 1000.0 / (double)state.frequency;
+                bool found = false;
+                for (ProfilerZoneStats& entry : merged) {
+                    if (entry.name == name || strcmp(entry.name, name) == 0) {
+                        entry.call_count += call_count;
+                        entry.total_time += total_time;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    merged.push_back((ProfilerZoneStats) {
+                        .name = name,
+                        .call_count = call_count,
+                        .total_time = total_time
+                    });
+                }
+            }
+        }
+    }
+
+    std::sort(merged.begin(), merged.end(), [](const ProfilerZoneStats& a, const ProfilerZoneStats& b) {
+        return a.total_time > b.total_time;
+    });
+    for (uint32_t i = 0; i < merged.size() && i < max_zones; i++) {
+        zones[i] = merged[i];
+    }
+
+    return (uint32_t)merged.size();
+}
+
+void siren::profiler_reset_stats() {
+    if (!initialized) {
+        return;
+    }
+
+    memset(state.histogram, 0, sizeof(state.histogram));
+    state.frame_count = 0;
+    state.frame_time_sum = 0.0;
+    state.frame_time_max = 0.0f;
+
+    std::lock_guard<std::mutex> lock(state.thread_buffers_mutex);
+    for (ProfilerThreadBuffer* buffer : state.thread_buffers) {
+        for (uint32_t i = 0; i < PROFILER_ZONE_TABLE_SIZE; i++) {
+            buffer->zones[i].call_count.store(0, std::memory_order_relaxed);
+            buffer->zones[i].total_ticks.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void profiler_write_json_string(FILE* file, const char* value) {
+    fputc('"', file);
+    for (const char* c = value; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool siren::profiler_write_chrome_trace(const char* path) {
+    if (!initialized) {
+        return false;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        SIREN_ERROR("Unable to open profiler trace %s for writing", path);
+        return false;
+    }
+
+    double ticks_to_microseconds = 1000000.0 / (double)state.frequency;
+    bool is_first_event = true;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::lock_guard<std::mutex> lock(state.thread_buffers_mutex);
+    for (ProfilerThreadBuffer* buffer : state.thread_buffers) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", is_first_event ? "" : ",\n", buffer->thread_id);
+        profiler_write_json_string(file, buffer->thread_name);
+        fprintf(file, "}}");
+        is_first_event = false;
+
+        uint64_t event_count = buffer->event_count.load(std::memory_order_acquire);
+        uint64_t first_event = event_count > PROFILER_EVENT_CAPACITY ? event_count - PROFILER_EVENT_CAPACITY : 0;
+        for (uint64_t event_index = first_event; event_index < event_count; event_index++) {
+            const ProfilerEvent& event = buffer->events[event_index % PROFILER_EVENT_CAPACITY];
+            if (event.start < state.start_time) {
+                continue;
+            }
+
+            fprintf(file, ",\n{\"name\":");
+            profiler_write_json_string(file, event.name);
+            fprintf(file, ",\"cat\":\"siren\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    buffer->thread_id,
+                    (double)(event.start - state.start_time) * ticks_to_microseconds,
+                    (double)(event.end - event.start) * ticks_to_microseconds);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    SIREN_INFO("Profiler trace written to %s", path);
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "defines.h"
+
+// Profiling is compiled into debug builds by default. Define SIREN_PROFILE as 0 or 1 to override.
+#ifndef SIREN_PROFILE
+#ifdef SIREN_DEBUG
+#define SIREN_PROFILE 1
+#else
+#define SIREN_PROFILE 0
+#endif
+#endif
+
+namespace siren {
+    // All times are in milliseconds
+    struct ProfilerFrameStats {
+        uint32_t frame_count;
+        float average;
+        float p50;
+        float p95;
+        float p99;
+        float max;
+    };
+
+    struct ProfilerZoneStats {
+        const char* name;
+        uint64_t call_count;
+        double total_time;
+    };
+
+    bool profiler_init();
+    void profiler_quit();
+    void profiler_frame_end(float frame_time);
+
+    SIREN_API void profiler_zone_begin(const char* name);
+    SIREN_API void profiler_zone_end();
+    SIREN_API void profiler_set_thread_name(const char* name);
+
+    SIREN_API ProfilerFrameStats profiler_get_frame_stats();
+    /*
+     * Returns the number of distinct zones recorded since the last reset, across all threads.
+     * Writes up to max_zones of them into zones, sorted by total time.
+     */
+    SIREN_API uint32_t profiler_get_zone_stats(ProfilerZoneStats* zones, uint32_t max_zones);
+    SIREN_API void profiler_reset_stats();
+
+    /*
+     * Writes every zone still held in the per-thread ring buffers as a Chrome trace (chrome://tracing, Perfetto).
+     * Call this while other threads are idle or the most recent events may be torn.
+     */
+    SIREN_API bool profiler_write_chrome_trace(const char* path);
+
+    class ProfilerScope {
+        public:
+            SIREN_INLINE ProfilerScope(const char* name) {
+                profiler_zone_begin(name);
+            }
+
+            SIREN_INLINE ~ProfilerScope() {
+                profiler_zone_end();
+            }
+    };
+}
+
+#if SIREN_PROFILE
+#define SIREN_PROFILE_CONCAT_INNER(a, b) a##b
+#define SIREN_PROFILE_CONCAT(a, b) SIREN_PROFILE_CONCAT_INNER(a, b)
+#define SIREN_PROFILE_SCOPE(name) siren::ProfilerScope SIREN_PROFILE_CONCAT(profiler_scope_, __LINE__)(name);
+#else
+#define SIREN_PROFILE_SCOPE(name)
+#endif
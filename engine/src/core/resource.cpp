@@ -1,11 +1,481 @@
 #include "resource.h"
 
-static std::string resource_path;
+#include "core/logger.h"
+#include "core/compression.h"
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+static const size_t RESOURCE_MAX_PATH_LENGTH = 1024;
+
+// A read-only view of a whole file
+struct ResourceMapping {
+    const uint8_t* data;
+    size_t size;
+    void* file_handle;
+    void* mapping_handle;
+};
+
+struct ResourceMount {
+    bool is_archive;
+    // Directory mounts always end in a slash
+    std::string path;
+
+    ResourceMapping mapping;
+    const siren::ResourceArchiveHeader* header;
+    const siren::ResourceArchiveEntry* entries;
+    const char* paths;
+};
+
+struct ResourceFileStorage {
+    ResourceMapping mapping;
+    uint8_t* buffer;
+};
+
+struct ResourceState {
+    std::string base_path;
+    std::string cache_path;
+    std::vector<ResourceMount> mounts;
+};
+
+static ResourceState state;
+// Numbers temp files, so that threads writing the same path don't write into each other's
+static std::atomic<uint32_t> temp_file_count(0);
+
+bool resource_map_file(const char* path, ResourceMapping* mapping);
+void resource_unmap_file(ResourceMapping* mapping);
+bool resource_create_directory(const char* path);
+bool resource_replace_file(const char* from, const char* to);
+
+// Returns the path without any leading "./", with backslashes written to buffer as slashes
+const char* resource_normalize_path(const char* path, char* buffer, size_t buffer_size) {
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+    size_t length = strlen(path);
+    if (length >= buffer_size) {
+        return NULL;
+    }
+    for (size_t index = 0; index <= length; index++) {
+        buffer[index] = path[index] == '\\' ? '/' : path[index];
+    }
+    return buffer;
+}
+
+uint64_t siren::resource_hash(const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t index = 0; index < size; index++) {
+        hash ^= bytes[index];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t siren::resource_hash_path(const char* path) {
+    char normalized[RESOURCE_MAX_PATH_LENGTH];
+    if (resource_normalize_path(path, normalized, sizeof(normalized)) == NULL) {
+        return resource_hash(path, strlen(path));
+    }
+    return resource_hash(normalized, strlen(normalized));
+}
+
+bool siren::resource_mount_directory(const char* path) {
+    ResourceMount mount;
+    mount.is_archive = false;
+    mount.path = std::string(path);
+    if (!mount.path.empty() && mount.path.back() != '/' && mount.path.back() != '\\') {
+        mount.path += "/";
+    }
+    mount.mapping = (ResourceMapping) { .data = NULL, .size = 0, .file_handle = NULL, .mapping_handle = NULL };
+    mount.header = NULL;
+    mount.entries = NULL;
+    mount.paths = NULL;
+    state.mounts.push_back(mount);
+
+    SIREN_TRACE("Mounted resource directory %s", path);
+    return true;
+}
+
+bool siren::resource_mount_archive(const char* path) {
+    ResourceMount mount;
+    mount.is_archive = true;
+    mount.path = std::string(path);
+    if (!resource_map_file(path, &mount.mapping)) {
+        SIREN_ERROR("Unable to open resource archive %s", path);
+        return false;
+    }
+
+    // Validate everything up front so that lookups can trust the table of contents
+    const ResourceArchiveHeader* header = (const ResourceArchiveHeader*)mount.mapping.data;
+    size_t size = mount.mapping.size;
+    if (size < sizeof(ResourceArchiveHeader) || memcmp(header->magic, RESOURCE_ARCHIVE_MAGIC, sizeof(header->magic)) != 0) {
+        SIREN_ERROR("%s is not a resource archive", path);
+        resource_unmap_file(&mount.mapping);
+        return false;
+    }
+    if (header->version != RESOURCE_ARCHIVE_VERSION) {
+        SIREN_ERROR("Resource archive %s is version %u, expected version %u", path, header->version, RESOURCE_ARCHIVE_VERSION);
+        resource_unmap_file(&mount.mapping);
+        return false;
+    }
+    if (header->entries_offset % alignof(ResourceArchiveEntry) != 0 || header->entries_offset > size ||
+            (size - header->entries_offset) / sizeof(ResourceArchiveEntry) < header->entry_count ||
+            header->paths_offset > size || size - header->paths_offset == 0 || mount.mapping.data[size - 1] != '\0') {
+        SIREN_ERROR("Resource archive %s has a corrupt table of contents", path);
+        resource_unmap_file(&mount.mapping);
+        return false;
+    }
+    const ResourceArchiveEntry* entries = (const ResourceArchiveEntry*)(mount.mapping.data + header->entries_offset);
+    for (uint32_t index = 0; index < header->entry_count; index++) {
+        const ResourceArchiveEntry& entry = entries[index];
+        if (entry.offset > size || entry.stored_size > size - entry.offset || entry.path_offset >= size - header->paths_offset ||
+                entry.compression > RESOURCE_COMPRESSION_LZ4 || (entry.compression == RESOURCE_COMPRESSION_NONE && entry.stored_size != entry.size)) {
+            SIREN_ERROR("Resource archive %s has a corrupt entry %u", path, index);
+            resource_unmap_file(&mount.mapping);
+            return false;
+        }
+    }
+
+    mount.header = header;
+    mount.entries = entries;
+    mount.paths = (const char*)(mount.mapping.data + header->paths_offset);
+    state.mounts.push_back(mount);
+
+    SIREN_INFO("Mounted resource archive %s with %u entries", path, header->entry_count);
+    return true;
+}
+
+void siren::resource_unmount_all() {
+    for (ResourceMount& mount : state.mounts) {
+        if (mount.is_archive) {
+            resource_unmap_file(&mount.mapping);
+        }
+    }
+    state.mounts.clear();
+}
 
 void siren::resource_set_base_path(const char* path) {
-    resource_path = std::string(path);
+    resource_unmount_all();
+    state.base_path = std::string(path);
+    resource_mount_directory(path);
+}
+
+const std::string& siren::resource_get_base_path() {
+    return state.base_path;
+}
+
+const siren::ResourceArchiveEntry* resource_archive_find(const ResourceMount& mount, const char* path, uint64_t hash) {
+    const siren::ResourceArchiveEntry* begin = mount.entries;
+    const siren::ResourceArchiveEntry* end = mount.entries + mount.header->entry_count;
+    const siren::ResourceArchiveEntry* it = std::lower_bound(begin, end, hash, [](const siren::ResourceArchiveEntry& entry, uint64_t value) {
+        return entry.path_hash < value;
+    });
+    // Entries with the same hash sit next to each other, so a collision only costs a string compare
+    for (; it != end && it->path_hash == hash; it++) {
+        if (strcmp(mount.paths + it->path_offset, path) == 0) {
+            return it;
+        }
+    }
+    return NULL;
+}
+
+bool resource_archive_open(const ResourceMount& mount, const siren::ResourceArchiveEntry* entry, const char* path, siren::ResourceFile* file) {
+    const uint8_t* stored = mount.mapping.data + entry->offset;
+    if (entry->compression == siren::RESOURCE_COMPRESSION_NONE) {
+        *file = (siren::ResourceFile) {
+            .data = stored,
+            .size = (size_t)entry->size,
+            .storage = NULL
+        };
+        return true;
+    }
+
+    ResourceFileStorage* storage = new ResourceFileStorage();
+    storage->mapping = (ResourceMapping) { .data = NULL, .size = 0, .file_handle = NULL, .mapping_handle = NULL };
+    storage->buffer = (uint8_t*)malloc(entry->size != 0 ? (size_t)entry->size : 1);
+    if (!siren::compression_lz4_decompress(stored, (size_t)entry->stored_size, storage->buffer, (size_t)entry->size)) {
+        SIREN_ERROR("Resource %s in archive %s failed to decompress", path, mount.path.c_str());
+        free(storage->buffer);
+        delete storage;
+        return false;
+    }
+    *file = (siren::ResourceFile) {
+        .data = storage->buffer,
+        .size = (size_t)entry->size,
+        .storage = storage
+    };
+    return true;
+}
+
+bool siren::resource_open(const char* path, siren::ResourceFile* file) {
+    char normalized[RESOURCE_MAX_PATH_LENGTH];
+    if (resource_normalize_path(path, normalized, sizeof(normalized)) == NULL) {
+        SIREN_ERROR("Resource path is too long: %s", path);
+        return false;
+    }
+    uint64_t hash = resource_hash(normalized, strlen(normalized));
+
+    for (size_t index = state.mounts.size(); index > 0; index--) {
+        const ResourceMount& mount = state.mounts[index - 1];
+        if (mount.is_archive) {
+            const ResourceArchiveEntry* entry = resource_archive_find(mount, normalized, hash);
+            if (entry != NULL) {
+                return resource_archive_open(mount, entry, normalized, file);
+            }
+            continue;
+        }
+
+        char full_path[RESOURCE_MAX_PATH_LENGTH];
+        int length = snprintf(full_path, sizeof(full_path), "%s%s", mount.path.c_str(), normalized);
+        if (length < 0 || (size_t)length >= sizeof(full_path)) {
+            continue;
+        }
+        ResourceMapping mapping;
+        if (!resource_map_file(full_path, &mapping)) {
+            continue;
+        }
+        ResourceFileStorage* storage = new ResourceFileStorage();
+        storage->mapping = mapping;
+        storage->buffer = NULL;
+        *file = (ResourceFile) {
+            .data = mapping.data,
+            .size = mapping.size,
+            .storage = storage
+        };
+        return true;
+    }
+
+    SIREN_ERROR("Resource %s was not found in any mount", path);
+    return false;
+}
+
+void siren::resource_close(siren::ResourceFile* file) {
+    if (file->storage != NULL) {
+        ResourceFileStorage* storage = (ResourceFileStorage*)file->storage;
+        if (storage->buffer != NULL) {
+            free(storage->buffer);
+        } else {
+            resource_unmap_file(&storage->mapping);
+        }
+        delete storage;
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->storage = NULL;
+}
+
+bool siren::resource_exists(const char* path) {
+    char normalized[RESOURCE_MAX_PATH_LENGTH];
+    if (resource_normalize_path(path, normalized, sizeof(normalized)) == NULL) {
+        return false;
+    }
+    uint64_t hash = resource_hash(normalized, strlen(normalized));
+
+    for (size_t index = state.mounts.size(); index > 0; index--) {
+        const ResourceMount& mount = state.mounts[index - 1];
+        if (mount.is_archive) {
+            if (resource_archive_find(mount, normalized, hash) != NULL) {
+                return true;
+            }
+            continue;
+        }
+
+        char full_path[RESOURCE_MAX_PATH_LENGTH];
+        snprintf(full_path, sizeof(full_path), "%s%s", mount.path.c_str(), normalized);
+        FILE* loose_file = fopen(full_path, "rb");
+        if (loose_file != NULL) {
+            fclose(loose_file);
+            return true;
+        }
+    }
+    return false;
+}
+
+void siren::resource_set_cache_path(const char* path) {
+    if (path == NULL) {
+        state.cache_path.clear();
+        return;
+    }
+
+    state.cache_path = std::string(path);
+    if (!state.cache_path.empty() && state.cache_path.back() != '/' && state.cache_path.back() != '\\') {
+        state.cache_path += "/";
+    }
+    if (!resource_create_directory(state.cache_path.c_str())) {
+        SIREN_WARN("Unable to create cache directory %s, cooked assets won't be cached", path);
+        state.cache_path.clear();
+    }
+}
+
+const char* siren::resource_get_cache_path() {
+    return state.cache_path.empty() ? NULL : state.cache_path.c_str();
+}
+
+bool siren::resource_get_cache_file(uint64_t source_hash, const char* suffix, char* buffer, size_t buffer_size) {
+    if (state.cache_path.empty()) {
+        return false;
+    }
+    int length = snprintf(buffer, buffer_size, "%s%016llx%s", state.cache_path.c_str(), (unsigned long long)source_hash, suffix);
+    return length > 0 && (size_t)length < buffer_size;
+}
+
+bool siren::resource_open_file(const char* path, siren::ResourceFile* file) {
+    ResourceMapping mapping;
+    if (!resource_map_file(path, &mapping)) {
+        return false;
+    }
+    ResourceFileStorage* storage = new ResourceFileStorage();
+    storage->mapping = mapping;
+    storage->buffer = NULL;
+    *file = (ResourceFile) {
+        .data = mapping.data,
+        .size = mapping.size,
+        .storage = storage
+    };
+    return true;
+}
+
+bool siren::resource_write_file(const char* path, const void* data, size_t size) {
+    std::string temp_path = std::string(path) + "." + std::to_string(temp_file_count.fetch_add(1)) + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (file == NULL) {
+        SIREN_WARN("Unable to open %s for writing", temp_path.c_str());
+        return false;
+    }
+    bool success = size == 0 || fwrite(data, 1, size, file) == size;
+    success = fclose(file) == 0 && success;
+    if (!success || !resource_replace_file(temp_path.c_str(), path)) {
+        SIREN_WARN("Unable to write %s", path);
+        remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Platform specific file mapping
+
+#ifdef SIREN_PLATFORM_WINDOWS
+
+#include <windows.h>
+
+bool resource_map_file(const char* path, ResourceMapping* mapping) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // Empty files can't be mapped, but they can still be opened
+    *mapping = (ResourceMapping) {
+        .data = NULL,
+        .size = (size_t)file_size.QuadPart,
+        .file_handle = file,
+        .mapping_handle = NULL
+    };
+    if (mapping->size == 0) {
+        return true;
+    }
+
+    HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file_mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+    void* data = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(file_mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mapping->data = (const uint8_t*)data;
+    mapping->mapping_handle = file_mapping;
+
+    return true;
+}
+
+void resource_unmap_file(ResourceMapping* mapping) {
+    if (mapping->data != NULL) {
+        UnmapViewOfFile(mapping->data);
+    }
+    if (mapping->mapping_handle != NULL) {
+        CloseHandle((HANDLE)mapping->mapping_handle);
+    }
+    if (mapping->file_handle != NULL) {
+        CloseHandle((HANDLE)mapping->file_handle);
+    }
+    *mapping = (ResourceMapping) { .data = NULL, .size = 0, .file_handle = NULL, .mapping_handle = NULL };
+}
+
+bool resource_create_directory(const char* path) {
+    return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+bool resource_replace_file(const char* from, const char* to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING);
+}
+
+#else
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+bool resource_map_file(const char* path, ResourceMapping* mapping) {
+    int file = open(path, O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        close(file);
+        return false;
+    }
+
+    // Empty files can't be mapped, but they can still be opened
+    *mapping = (ResourceMapping) {
+        .data = NULL,
+        .size = (size_t)file_stat.st_size,
+        .file_handle = NULL,
+        .mapping_handle = NULL
+    };
+    if (mapping->size != 0) {
+        void* data = mmap(NULL, mapping->size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED) {
+            close(file);
+            return false;
+        }
+        mapping->data = (const uint8_t*)data;
+    }
+    // The mapping keeps the file alive on its own
+    close(file);
+
+    return true;
+}
+
+void resource_unmap_file(ResourceMapping* mapping) {
+    if (mapping->data != NULL) {
+        munmap((void*)mapping->data, mapping->size);
+    }
+    *mapping = (ResourceMapping) { .data = NULL, .size = 0, .file_handle = NULL, .mapping_handle = NULL };
+}
+
+bool resource_create_directory(const char* path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+bool resource_replace_file(const char* from, const char* to) {
+    return rename(from, to) == 0;
 }
 
-const std::string siren::resource_get_base_path() {
-    return resource_path;
-}
\ No newline at end of file
+#endif
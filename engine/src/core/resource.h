@@ -1,10 +1,92 @@
 #pragma once
 
+#include "defines.h"
+
 #include <string>
+#include <cstddef>
 
 namespace siren {
+    static const uint32_t RESOURCE_HANDLE_NULL = UINT32_MAX;
+
+    /*
+     * Resources are read through mounts. A mount is either a loose directory, for development, or a packed archive
+     * built by siren-pack. Paths are relative to the mount, e.g. "shader/basic.vert", and later mounts are searched first.
+     * Mount everything before loading anything, since lookups from job threads aren't locked against mounting.
+     */
+    SIREN_API bool resource_mount_directory(const char* path);
+    SIREN_API bool resource_mount_archive(const char* path);
+    void resource_unmount_all();
+
+    // Unmounts everything and mounts path as a directory
     void resource_set_base_path(const char* path);
-    const std::string resource_get_base_path();
+    const std::string& resource_get_base_path();
 
-    static const uint32_t RESOURCE_HANDLE_NULL = UINT32_MAX;
-}
\ No newline at end of file
+    /*
+     * The contents of a resource. Archive entries that aren't compressed point straight into the mapped archive,
+     * loose files are mapped on open, and compressed entries are decompressed into memory owned by the file.
+     * data stays valid until resource_close.
+     */
+    struct ResourceFile {
+        const uint8_t* data;
+        size_t size;
+        // Set when data is owned by this file rather than by a mounted archive
+        void* storage;
+    };
+
+    // Safe to call from any thread
+    SIREN_API bool resource_open(const char* path, ResourceFile* file);
+    SIREN_API void resource_close(ResourceFile* file);
+    SIREN_API bool resource_exists(const char* path);
+
+    /*
+     * Cooked assets are cached as files in a writable directory outside of the mounts. NULL disables the cache.
+     * The directory is created if it doesn't exist.
+     */
+    SIREN_API void resource_set_cache_path(const char* path);
+    // Returns NULL when caching is disabled
+    SIREN_API const char* resource_get_cache_path();
+    // Writes the path of the cached file for a source with this hash, e.g. "cache/0123456789abcdef.smesh". False when caching is disabled.
+    SIREN_API bool resource_get_cache_file(uint64_t source_hash, const char* suffix, char* buffer, size_t buffer_size);
+    // Maps a file by its real path, ignoring the mounts. Fails quietly if it doesn't exist.
+    SIREN_API bool resource_open_file(const char* path, ResourceFile* file);
+    // Writes to a temporary file and renames it over path, so that readers never see a partial file. Threads can write the same path at once.
+    SIREN_API bool resource_write_file(const char* path, const void* data, size_t size);
+
+    // 64-bit FNV-1a, used to key archive entries by path
+    SIREN_API uint64_t resource_hash(const void* data, size_t size);
+    // Hashes a path after turning backslashes into slashes and dropping any leading "./"
+    SIREN_API uint64_t resource_hash_path(const char* path);
+
+    /*
+     * Archive layout. A ResourceArchiveHeader, then every entry's data aligned to RESOURCE_ARCHIVE_ALIGNMENT,
+     * then entry_count ResourceArchiveEntry sorted by path_hash, then the entry paths as null terminated strings.
+     */
+    static const char RESOURCE_ARCHIVE_MAGIC[4] = { 'S', 'P', 'A', 'K' };
+    static const uint32_t RESOURCE_ARCHIVE_VERSION = 1;
+    static const uint32_t RESOURCE_ARCHIVE_ALIGNMENT = 16;
+
+    enum ResourceCompression {
+        RESOURCE_COMPRESSION_NONE,
+        RESOURCE_COMPRESSION_LZ4
+    };
+
+    struct ResourceArchiveHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t entry_count;
+        uint32_t reserved;
+        uint64_t entries_offset;
+        uint64_t paths_offset;
+    };
+
+    struct ResourceArchiveEntry {
+        uint64_t path_hash;
+        uint64_t offset;
+        // Size in the archive, and size once decompressed
+        uint64_t stored_size;
+        uint64_t size;
+        // Offset of the path from paths_offset
+        uint32_t path_offset;
+        uint32_t compression;
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "defines.h"
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace siren {
+    /*
+     * Storage for values referred to by handles. A handle is a slot index in its low SLOT_MAP_INDEX_BITS and that slot's
+     * generation above them. Removing a value bumps its slot's generation, so old handles stop resolving instead of
+     * pointing at whatever reuses the slot.
+     * Values live in pages that never move once allocated, so a pointer from slot_map_get stays valid until its value is
+     * removed, and another thread can look up values it was handed while more are inserted.
+     * Declare slot maps as statics so that their page table starts zeroed.
+     */
+    static const uint32_t SLOT_MAP_INDEX_BITS = 16;
+    static const uint32_t SLOT_MAP_INDEX_MASK = (1u << SLOT_MAP_INDEX_BITS) - 1;
+    // The last index is never handed out, so that no handle is ever UINT32_MAX
+    static const uint32_t SLOT_MAP_MAX_SLOTS = SLOT_MAP_INDEX_MASK;
+    static const uint32_t SLOT_MAP_PAGE_SIZE = 256;
+    static const uint32_t SLOT_MAP_MAX_PAGES = (SLOT_MAP_MAX_SLOTS + SLOT_MAP_PAGE_SIZE - 1) / SLOT_MAP_PAGE_SIZE;
+    static const uint32_t SLOT_MAP_HANDLE_NULL = UINT32_MAX;
+
+    template <typename T>
+    struct SlotMapSlot {
+        T value;
+        uint32_t generation;
+        // Position of this slot's handle in SlotMap::handles while it's live
+        uint32_t dense_index;
+        bool is_live;
+    };
+
+    template <typename T>
+    struct SlotMap {
+        SlotMapSlot<T>* pages[SLOT_MAP_MAX_PAGES];
+        // Slots handed out so far, live or free
+        uint32_t slot_count;
+        std::vector<uint32_t> free_slots;
+        // Every live handle, packed together for iteration
+        std::vector<uint32_t> handles;
+    };
+
+    template <typename T>
+    SlotMapSlot<T>* slot_map_get_slot(const SlotMap<T>* map, uint32_t handle) {
+        uint32_t index = handle & SLOT_MAP_INDEX_MASK;
+        if (index >= SLOT_MAP_MAX_SLOTS || map->pages[index / SLOT_MAP_PAGE_SIZE] == NULL) {
+            return NULL;
+        }
+        SlotMapSlot<T>* slot = &map->pages[index / SLOT_MAP_PAGE_SIZE][index % SLOT_MAP_PAGE_SIZE];
+        if (!slot->is_live || slot->generation != handle >> SLOT_MAP_INDEX_BITS) {
+            return NULL;
+        }
+        return slot;
+    }
+
+    // Returns NULL for SLOT_MAP_HANDLE_NULL and for handles whose value has been removed
+    template <typename T>
+    T* slot_map_get(const SlotMap<T>* map, uint32_t handle) {
+        SlotMapSlot<T>* slot = slot_map_get_slot(map, handle);
+        return slot != NULL ? &slot->value : NULL;
+    }
+
+    // Reuses a free slot if there is one. Returns SLOT_MAP_HANDLE_NULL once all SLOT_MAP_MAX_SLOTS are live.
+    template <typename T>
+    uint32_t slot_map_insert(SlotMap<T>* map, T&& value) {
+        uint32_t index;
+        if (!map->free_slots.empty()) {
+            index = map->free_slots.back();
+            map->free_slots.pop_back();
+        } else {
+            if (map->slot_count == SLOT_MAP_MAX_SLOTS) {
+                return SLOT_MAP_HANDLE_NULL;
+            }
+            index = map->slot_count;
+            if (map->pages[index / SLOT_MAP_PAGE_SIZE] == NULL) {
+                map->pages[index / SLOT_MAP_PAGE_SIZE] = new SlotMapSlot<T>[SLOT_MAP_PAGE_SIZE]();
+            }
+            map->slot_count++;
+        }
+
+        SlotMapSlot<T>* slot = &map->pages[index / SLOT_MAP_PAGE_SIZE][index % SLOT_MAP_PAGE_SIZE];
+        slot->value = std::move(value);
+        slot->dense_index = (uint32_t)map->handles.size();
+        slot->is_live = true;
+        uint32_t handle = (slot->generation << SLOT_MAP_INDEX_BITS) | index;
+        map->handles.push_back(handle);
+        return handle;
+    }
+
+    // Destroys the value and frees its slot. False if the handle didn't resolve.
+    template <typename T>
+    bool slot_map_remove(SlotMap<T>* map, uint32_t handle) {
+        SlotMapSlot<T>* slot = slot_map_get_slot(map, handle);
+        if (slot == NULL) {
+            return false;
+        }
+        slot->value = T();
+        slot->is_live = false;
+        slot->generation = (slot->generation + 1) & (UINT32_MAX >> SLOT_MAP_INDEX_BITS);
+
+        // Fill the hole in the dense handles with the last one
+        uint32_t last_handle = map->handles.back();
+        map->handles[slot->dense_index] = last_handle;
+        map->pages[(last_handle & SLOT_MAP_INDEX_MASK) / SLOT_MAP_PAGE_SIZE][(last_handle & SLOT_MAP_INDEX_MASK) % SLOT_MAP_PAGE_SIZE].dense_index = slot->dense_index;
+        map->handles.pop_back();
+
+        map->free_slots.push_back(handle & SLOT_MAP_INDEX_MASK);
+        return true;
+    }
+}
@@ -32,6 +32,10 @@
 #define SIREN_INLINE __forceinline
 #define SIREN_NO_INLINE __declspec(noinline)
 #else
-#define SIREN_INLINE static inline
+// Not static, since that would also make member functions static
+#define SIREN_INLINE inline
 #define SIREN_NO_INLINE 
-#endif
\ No newline at end of file
+#endif
+
+// True while a constexpr function is being evaluated at compile time, where it can't use SIMD intrinsics
+#define SIREN_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "defines.h"
+
+#include "math.h"
+#include "vector3.h"
+#include "vector4.h"
+#include "matrix.h"
+#include "simd.h"
+
+namespace siren {
+    /*
+     * An affine transform, stored as the top three rows of a 4x4 matrix whose bottom row is always (0, 0, 0, 1). Each
+     * row holds the x, y and z axis terms and the translation for one output component, which is the layout GLSL reads
+     * as a mat3x4. Multiplying two of them is three rows of work instead of four.
+     */
+    struct affine3x4 {
+        vec4 rows[3];
+
+        SIREN_INLINE constexpr affine3x4(float value = 0.0f) : rows{
+            vec4(value, 0.0f, 0.0f, 0.0f),
+            vec4(0.0f, value, 0.0f, 0.0f),
+            vec4(0.0f, 0.0f, value, 0.0f)
+        } { }
+
+        SIREN_INLINE constexpr vec4& operator[](uint32_t index) {
+            return rows[index];
+        }
+
+        SIREN_INLINE constexpr const vec4& operator[](uint32_t index) const {
+            return rows[index];
+        }
+
+        // The bottom row of matrix is dropped, so it has to be affine already
+        SIREN_INLINE static affine3x4 from_mat4(const mat4& matrix) {
+            simd4f row_0 = matrix.columns[0].to_simd();
+            simd4f row_1 = matrix.columns[1].to_simd();
+            simd4f row_2 = matrix.columns[2].to_simd();
+            simd4f row_3 = matrix.columns[3].to_simd();
+            simd_transpose(&row_0, &row_1, &row_2, &row_3);
+
+            affine3x4 result;
+            result.rows[0] = vec4::from_simd(row_0);
+            result.rows[1] = vec4::from_simd(row_1);
+            result.rows[2] = vec4::from_simd(row_2);
+            return result;
+        }
+
+        SIREN_INLINE mat4 to_mat4() const {
+            simd4f column_0 = rows[0].to_simd();
+            simd4f column_1 = rows[1].to_simd();
+            simd4f column_2 = rows[2].to_simd();
+            simd4f column_3 = simd_set(0.0f, 0.0f, 0.0f, 1.0f);
+            simd_transpose(&column_0, &column_1, &column_2, &column_3);
+
+            mat4 result;
+            result.columns[0] = vec4::from_simd(column_0);
+            result.columns[1] = vec4::from_simd(column_1);
+            result.columns[2] = vec4::from_simd(column_2);
+            result.columns[3] = vec4::from_simd(column_3);
+            return result;
+        }
+
+        // Each result row is the other's rows scaled by this row's axis terms, plus this row's translation
+        SIREN_INLINE affine3x4 operator*(const affine3x4& other) const {
+            simd4f other_0 = other.rows[0].to_simd();
+            simd4f other_1 = other.rows[1].to_simd();
+            simd4f other_2 = other.rows[2].to_simd();
+
+            affine3x4 result;
+            for (uint32_t row = 0; row < 3; row++) {
+                simd4f sum = simd_mul(simd_splat(rows[row][0]), other_0);
+                sum = simd_add(sum, simd_mul(simd_splat(rows[row][1]), other_1));
+                sum = simd_add(sum, simd_mul(simd_splat(rows[row][2]), other_2));
+                sum = simd_add(sum, simd_set(0.0f, 0.0f, 0.0f, rows[row][3]));
+                simd_store(result.rows[row].elements, sum);
+            }
+
+            return result;
+        }
+
+        SIREN_INLINE vec3 transform_point(const vec3& point) const {
+            return vec3(rows[0][0] * point.x + rows[0][1] * point.y + rows[0][2] * point.z + rows[0][3],
+                        rows[1][0] * point.x + rows[1][1] * point.y + rows[1][2] * point.z + rows[1][3],
+                        rows[2][0] * point.x + rows[2][1] * point.y + rows[2][2] * point.z + rows[2][3]);
+        }
+
+        /*
+         * The 3x3 part is inverted through its adjugate, whose columns are the cross products of its rows, and the
+         * translation becomes the inverted 3x3 applied to the negated translation.
+         */
+        SIREN_INLINE affine3x4 inversed() const {
+            simd4f row_0 = rows[0].to_simd();
+            simd4f row_1 = rows[1].to_simd();
+            simd4f row_2 = rows[2].to_simd();
+
+            simd4f adjugate_0 = affine_cross(row_1, row_2);
+            simd4f adjugate_1 = affine_cross(row_2, row_0);
+            simd4f adjugate_2 = affine_cross(row_0, row_1);
+            vec4 determinant_terms = vec4::from_simd(simd_mul(row_0, adjugate_0));
+            float determinant = determinant_terms.x + determinant_terms.y + determinant_terms.z;
+            simd4f inverse_determinant = simd_splat(1.0f / determinant);
+
+            simd4f translation = simd_mul(adjugate_0, simd_splat(rows[0][3]));
+            translation = simd_add(translation, simd_mul(adjugate_1, simd_splat(rows[1][3])));
+            translation = simd_add(translation, simd_mul(adjugate_2, simd_splat(rows[2][3])));
+
+            simd4f column_0 = simd_mul(adjugate_0, inverse_determinant);
+            simd4f column_1 = simd_mul(adjugate_1, inverse_determinant);
+            simd4f column_2 = simd_mul(adjugate_2, inverse_determinant);
+            simd4f column_3 = simd_mul(translation, simd_splat(-1.0f / determinant));
+            simd_transpose(&column_0, &column_1, &column_2, &column_3);
+
+            affine3x4 result;
+            result.rows[0] = vec4::from_simd(column_0);
+            result.rows[1] = vec4::from_simd(column_1);
+            result.rows[2] = vec4::from_simd(column_2);
+            return result;
+        }
+
+    private:
+        // The cross product of the x, y and z lanes. The w lane comes out as 0.
+        SIREN_INLINE static simd4f affine_cross(simd4f a, simd4f b) {
+            return simd_sub(
+                    simd_mul(simd_shuffle<1, 2, 0, 3>(a), simd_shuffle<2, 0, 1, 3>(b)),
+                    simd_mul(simd_shuffle<2, 0, 1, 3>(a), simd_shuffle<1, 2, 0, 3>(b)));
+        }
+    };
+}
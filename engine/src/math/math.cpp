@@ -1,7 +1,38 @@
 #include "math.h"
 
+#include "vector3.h"
+#include "vector4.h"
+#include "matrix.h"
+
 #include <cstring>
 
+// Tables are built from the math types at compile time, so check that the operations they use stay constexpr
+constexpr siren::mat4 MATH_CHECK_TRANSFORM = siren::mat4::translate(siren::vec3(1.0f, 2.0f, 3.0f)) * siren::mat4::scale(siren::vec3(2.0f, 3.0f, 4.0f));
+static_assert(MATH_CHECK_TRANSFORM[0][0] == 2.0f && MATH_CHECK_TRANSFORM[1][1] == 3.0f && MATH_CHECK_TRANSFORM[2][2] == 4.0f, "mat4 multiply isn't constexpr");
+static_assert(MATH_CHECK_TRANSFORM[3][0] == 1.0f && MATH_CHECK_TRANSFORM[3][1] == 2.0f && MATH_CHECK_TRANSFORM[3][2] == 3.0f && MATH_CHECK_TRANSFORM[3][3] == 1.0f, "mat4 multiply isn't constexpr");
+
+constexpr siren::mat4 MATH_CHECK_ORTHOGRAPHIC = siren::mat4::orthographic(0.0f, 2.0f, 0.0f, 4.0f, -1.0f, 1.0f);
+static_assert(MATH_CHECK_ORTHOGRAPHIC[0][0] == 1.0f && MATH_CHECK_ORTHOGRAPHIC[1][1] == 0.5f && MATH_CHECK_ORTHOGRAPHIC[2][2] == -1.0f, "mat4::orthographic isn't constexpr");
+static_assert(MATH_CHECK_ORTHOGRAPHIC[3][0] == -1.0f && MATH_CHECK_ORTHOGRAPHIC[3][1] == -1.0f && MATH_CHECK_ORTHOGRAPHIC[3][3] == 1.0f, "mat4::orthographic isn't constexpr");
+
+constexpr siren::mat4 MATH_CHECK_PERSPECTIVE = siren::mat4::perspective_from_half_tan(1.0f, 2.0f, 1.0f, 3.0f);
+static_assert(MATH_CHECK_PERSPECTIVE[0][0] == 0.5f && MATH_CHECK_PERSPECTIVE[1][1] == 1.0f && MATH_CHECK_PERSPECTIVE[2][2] == -2.0f, "mat4::perspective_from_half_tan isn't constexpr");
+static_assert(MATH_CHECK_PERSPECTIVE[2][3] == -1.0f && MATH_CHECK_PERSPECTIVE[3][2] == -3.0f && MATH_CHECK_PERSPECTIVE[3][3] == 0.0f, "mat4::perspective_from_half_tan isn't constexpr");
+
+constexpr siren::vec4 math_check_vec4_assignment() {
+    siren::vec4 result(1.0f, 2.0f, 3.0f, 4.0f);
+    result += siren::vec4(1.0f);
+    result -= siren::vec4(0.5f);
+    result *= 2.0f;
+    result /= 4.0f;
+    return result;
+}
+constexpr siren::vec4 MATH_CHECK_VEC4 = math_check_vec4_assignment();
+static_assert(MATH_CHECK_VEC4.x == 0.75f && MATH_CHECK_VEC4.y == 1.25f && MATH_CHECK_VEC4.z == 1.75f && MATH_CHECK_VEC4.w == 2.25f, "vec4 operators aren't constexpr");
+
+constexpr siren::vec3 MATH_CHECK_CROSS = siren::vec3::cross(siren::vec3(1.0f, 0.0f, 0.0f), siren::vec3(0.0f, 1.0f, 0.0f));
+static_assert(MATH_CHECK_CROSS.x == 0.0f && MATH_CHECK_CROSS.y == 0.0f && MATH_CHECK_CROSS.z == 1.0f, "vec3::cross isn't constexpr");
+
 SIREN_INLINE int siren::max(int a, int b) {
     return a > b ? a : b;
 }
@@ -16,11 +16,11 @@ namespace siren {
     SIREN_API float clampf(float n, float lower, float upper);
     SIREN_API int next_largest_power_of_two(int number);
 
-    SIREN_INLINE float deg_to_rad(float degrees) {
+    SIREN_INLINE constexpr float deg_to_rad(float degrees) {
         return degrees * SIREN_DEG2RAD_MULTIPLIER;
     }
 
-    SIREN_INLINE float rad_to_deg(float radians) {
+    SIREN_INLINE constexpr float rad_to_deg(float radians) {
         return radians * SIREN_RAD2DEG_MULTIPLIER;
     }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "math.h"
 #include "vector3.h"
 #include "vector4.h"
+#include "simd.h"
 
 #include <cstring>
 
@@ -12,37 +13,64 @@ namespace siren {
     struct mat4 {
         vec4 columns[4];
 
-        SIREN_INLINE mat4(float value = 0.0f) {
-            columns[0] = vec4(value, 0.0f, 0.0f, 0.0f);
-            columns[1] = vec4(0.0f, value, 0.0f, 0.0f);
-            columns[2] = vec4(0.0f, 0.0f, value, 0.0f);
-            columns[3] = vec4(0.0f, 0.0f, 0.0f, value);
-        }
+        SIREN_INLINE constexpr mat4(float value = 0.0f) : columns{
+            vec4(value, 0.0f, 0.0f, 0.0f),
+            vec4(0.0f, value, 0.0f, 0.0f),
+            vec4(0.0f, 0.0f, value, 0.0f),
+            vec4(0.0f, 0.0f, 0.0f, value)
+        } { }
 
-        SIREN_INLINE vec4& operator[](uint32_t index) {
+        SIREN_INLINE constexpr vec4& operator[](uint32_t index) {
             return columns[index];
         }
 
-        SIREN_INLINE const vec4& operator[](uint32_t index) const {
+        SIREN_INLINE constexpr const vec4& operator[](uint32_t index) const {
             return columns[index];
         }
 
-        SIREN_INLINE mat4 operator*(const mat4& other) const {
+        // Each result column is the columns of this scaled by the other's column, summed in order
+        SIREN_INLINE constexpr mat4 operator*(const mat4& other) const {
             mat4 result;
 
-            for (uint32_t row = 0; row < 4; row++) {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
                 for (uint32_t col = 0; col < 4; col++) {
-                    result[col][row] = (columns[0][row] * other[col][0]) +
-                                       (columns[1][row] * other[col][1]) +
-                                       (columns[2][row] * other[col][2]) +
-                                       (columns[3][row] * other[col][3]);
+                    result.columns[col] = (columns[0] * other[col][0]) + (columns[1] * other[col][1]) + (columns[2] * other[col][2]) + (columns[3] * other[col][3]);
                 }
+                return result;
             }
 
+#if defined(SIREN_SIMD_AVX2)
+            // Two result columns at a time, each 128 bit half broadcasting from its own column of other
+            __m256 column_0 = _mm256_broadcast_ps((const __m128*)columns[0].elements);
+            __m256 column_1 = _mm256_broadcast_ps((const __m128*)columns[1].elements);
+            __m256 column_2 = _mm256_broadcast_ps((const __m128*)columns[2].elements);
+            __m256 column_3 = _mm256_broadcast_ps((const __m128*)columns[3].elements);
+            for (uint32_t col = 0; col < 4; col += 2) {
+                __m256 pair = _mm256_loadu_ps(other.columns[col].elements);
+                __m256 sum = _mm256_mul_ps(column_0, _mm256_permute_ps(pair, 0x00));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(column_1, _mm256_permute_ps(pair, 0x55)));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(column_2, _mm256_permute_ps(pair, 0xAA)));
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(column_3, _mm256_permute_ps(pair, 0xFF)));
+                _mm256_storeu_ps(result.columns[col].elements, sum);
+            }
+#else
+            simd4f column_0 = columns[0].to_simd();
+            simd4f column_1 = columns[1].to_simd();
+            simd4f column_2 = columns[2].to_simd();
+            simd4f column_3 = columns[3].to_simd();
+            for (uint32_t col = 0; col < 4; col++) {
+                simd4f sum = simd_mul(column_0, simd_splat(other[col][0]));
+                sum = simd_add(sum, simd_mul(column_1, simd_splat(other[col][1])));
+                sum = simd_add(sum, simd_mul(column_2, simd_splat(other[col][2])));
+                sum = simd_add(sum, simd_mul(column_3, simd_splat(other[col][3])));
+                simd_store(result.columns[col].elements, sum);
+            }
+#endif
+
             return result;
         }
 
-        SIREN_INLINE static mat4 orthographic(float left, float right, float bottom, float top, float near, float far) {
+        SIREN_INLINE static constexpr mat4 orthographic(float left, float right, float bottom, float top, float near, float far) {
             mat4 result(1.0f);
             result[0][0] = 2.0f / (right - left);
             result[1][1] = 2.0f / (top - bottom);
@@ -55,8 +83,11 @@ namespace siren {
         }
 
         SIREN_INLINE static mat4 perspective(float fov, float aspect, float near, float far) {
-            float half_tan_fov = tan(fov * 0.5f);
+            return perspective_from_half_tan(tan(fov * 0.5f), aspect, near, far);
+        }
 
+        // tan isn't constexpr, so this takes tan(fov / 2) directly for projections built at compile time
+        SIREN_INLINE static constexpr mat4 perspective_from_half_tan(float half_tan_fov, float aspect, float near, float far) {
             mat4 result(0.0f);
             result[0][0] = 1.0f / (aspect * half_tan_fov);
             result[1][1] = 1.0f / half_tan_fov;
@@ -93,7 +124,7 @@ namespace siren {
             return result;
         }
 
-        SIREN_INLINE static mat4 translate(vec3 position) {
+        SIREN_INLINE static constexpr mat4 translate(vec3 position) {
             mat4 result(1.0f);
             result[3][0] = position.x;
             result[3][1] = position.y;
@@ -114,12 +145,12 @@ namespace siren {
             result[1][2] = (axis.z * axis.y * (1 - cos_theta)) + (axis.x * sin_theta);
             result[2][0] = (axis.x * axis.z * (1 - cos_theta)) + (axis.y * sin_theta);
             result[2][1] = (axis.y * axis.z * (1 - cos_theta)) - (axis.x * sin_theta);
-            result[2][2] = cos_theta + (axis.x * axis.x * (1 - cos_theta));
+            result[2][2] = cos_theta + (axis.z * axis.z * (1 - cos_theta));
 
             return result;
         }
 
-        SIREN_INLINE static mat4 scale(vec3 value) {
+        SIREN_INLINE static constexpr mat4 scale(vec3 value) {
             mat4 result(1.0f);
             result[0][0] = value.x;
             result[1][1] = value.y;
@@ -128,46 +159,79 @@ namespace siren {
             return result;
         }
 
+        /*
+         * Cofactor expansion over the 2x2 determinants of the top two and bottom two rows (b00 to b11). Result lane n
+         * of column k is p * x - q * y + r * z, with the signs folded into z.
+         */
         SIREN_INLINE mat4 inversed() const {
-            float b00 = columns[0][0] * columns[1][1] - columns[0][1] * columns[1][0];
-            float b01 = columns[0][0] * columns[1][2] - columns[0][2] * columns[1][0];
-            float b02 = columns[0][0] * columns[1][3] - columns[0][3] * columns[1][0];
-            float b03 = columns[0][1] * columns[1][2] - columns[0][2] * columns[1][1];
-            float b04 = columns[0][1] * columns[1][3] - columns[0][3] * columns[1][1];
-            float b05 = columns[0][2] * columns[1][3] - columns[0][3] * columns[1][2];
-            float b06 = columns[2][0] * columns[3][1] - columns[2][1] * columns[3][0];
-            float b07 = columns[2][0] * columns[3][2] - columns[2][2] * columns[3][0];
-            float b08 = columns[2][0] * columns[3][3] - columns[2][3] * columns[3][0];
-            float b09 = columns[2][1] * columns[3][2] - columns[2][2] * columns[3][1];
-            float b10 = columns[2][1] * columns[3][3] - columns[2][3] * columns[3][1];
-            float b11 = columns[2][2] * columns[3][3] - columns[2][3] * columns[3][2];
-
-            float determinant = b00 * b11 - b01 * b10 + b02 * b09 + b03 * b08 - b04 * b07 + b05 * b06;
-
+            simd4f column_0 = columns[0].to_simd();
+            simd4f column_1 = columns[1].to_simd();
+            simd4f column_2 = columns[2].to_simd();
+            simd4f column_3 = columns[3].to_simd();
+
+            // (b00, b01, b02, b03), (b04, b05, b04, b05), (b06, b07, b08, b09), (b10, b11, b10, b11)
+            simd4f b0 = simd_sub(
+                    simd_mul(simd_shuffle<0, 0, 0, 1>(column_0), simd_shuffle<1, 2, 3, 2>(column_1)),
+                    simd_mul(simd_shuffle<1, 2, 3, 2>(column_0), simd_shuffle<0, 0, 0, 1>(column_1)));
+            simd4f b1 = simd_sub(
+                    simd_mul(simd_shuffle<1, 2, 1, 2>(column_0), simd_shuffle<3, 3, 3, 3>(column_1)),
+                    simd_mul(simd_shuffle<3, 3, 3, 3>(column_0), simd_shuffle<1, 2, 1, 2>(column_1)));
+            simd4f b2 = simd_sub(
+                    simd_mul(simd_shuffle<0, 0, 0, 1>(column_2), simd_shuffle<1, 2, 3, 2>(column_3)),
+                    simd_mul(simd_shuffle<1, 2, 3, 2>(column_2), simd_shuffle<0, 0, 0, 1>(column_3)));
+            simd4f b3 = simd_sub(
+                    simd_mul(simd_shuffle<1, 2, 1, 2>(column_2), simd_shuffle<3, 3, 3, 3>(column_3)),
+                    simd_mul(simd_shuffle<3, 3, 3, 3>(column_2), simd_shuffle<1, 2, 1, 2>(column_3)));
+
+            vec4 b_0 = vec4::from_simd(b0);
+            vec4 b_1 = vec4::from_simd(b1);
+            vec4 b_2 = vec4::from_simd(b2);
+            vec4 b_3 = vec4::from_simd(b3);
+            float determinant = b_0[0] * b_3[1] - b_0[1] * b_3[0] + b_0[2] * b_2[3] + b_0[3] * b_2[2] - b_1[0] * b_2[1] + b_1[1] * b_2[0];
+
+            // (c1[i], c0[j], c3[i], c2[j]) for the element pairs the result columns read
+            simd4f m12 = inversed_gather<1, 2>(column_1, column_0, column_3, column_2);
+            simd4f m21 = inversed_gather<2, 1>(column_1, column_0, column_3, column_2);
+            simd4f m20 = inversed_gather<2, 0>(column_1, column_0, column_3, column_2);
+            simd4f m02 = inversed_gather<0, 2>(column_1, column_0, column_3, column_2);
+            simd4f m01 = inversed_gather<0, 1>(column_1, column_0, column_3, column_2);
+            simd4f m10 = inversed_gather<1, 0>(column_1, column_0, column_3, column_2);
+            simd4f m22 = inversed_gather<2, 2>(column_1, column_0, column_3, column_2);
+            simd4f m33 = inversed_gather<3, 3>(column_1, column_0, column_3, column_2);
+
+            // (b11, b10, b05, b04), (b08, b11, b02, b05), (b10, b08, b04, b02), (b07, b09, b01, b03)
+            simd4f x0 = simd_shuffle2<1, 0, 1, 0>(b3, b1);
+            simd4f x1 = inversed_gather<2, 1>(b2, b3, b0, b1);
+            simd4f x2 = inversed_gather<0, 2>(b3, b2, b1, b0);
+            simd4f x3 = simd_shuffle2<1, 3, 1, 3>(b2, b0);
+            // (b09, b09, b03, b03), (b07, b07, b01, b01), (b06, b06, b00, b00)
+            simd4f z0 = simd_shuffle2<3, 3, 3, 3>(b2, b0);
+            simd4f z1 = simd_shuffle2<1, 1, 1, 1>(b2, b0);
+            simd4f z2 = simd_shuffle2<0, 0, 0, 0>(b2, b0);
+            simd4f signs = simd_set(1.0f, -1.0f, 1.0f, -1.0f);
+            simd4f flipped_signs = simd_set(-1.0f, 1.0f, -1.0f, 1.0f);
+
+            simd4f inverse_determinant = simd_splat(1.0f / determinant);
             mat4 result;
-            result.columns[0] = vec4(
-                    columns[1][1] * b11 - columns[1][2] * b10 + columns[1][3] * b09,
-                    columns[0][2] * b10 - columns[0][1] * b11 - columns[0][3] * b09,
-                    columns[3][1] * b05 - columns[3][2] * b04 + columns[3][3] * b03,
-                    columns[2][2] * b04 - columns[2][1] * b05 - columns[2][3] * b03);
-            result.columns[1] = vec4(
-                    columns[1][2] * b08 - columns[1][0] * b11 - columns[1][3] * b07,
-                    columns[0][0] * b11 - columns[0][2] * b08 + columns[0][3] * b07,
-                    columns[3][2] * b02 - columns[3][0] * b05 - columns[3][3] * b01,
-                    columns[2][0] * b05 - columns[2][2] * b02 + columns[2][3] * b01);
-            result.columns[2] = vec4(
-                    columns[1][0] * b10 - columns[1][1] * b08 + columns[1][3] * b06,
-                    columns[0][1] * b08 - columns[0][0] * b10 - columns[0][3] * b06,
-                    columns[3][0] * b04 - columns[3][1] * b02 + columns[3][3] * b00,
-                    columns[2][1] * b02 - columns[2][0] * b04 - columns[2][3] * b00);
-            result.columns[3] = vec4(
-                    columns[1][1] * b07 - columns[1][0] * b09 - columns[1][2] * b06,
-                    columns[0][0] * b09 - columns[0][1] * b07 + columns[0][2] * b06,
-                    columns[3][1] * b01 - columns[3][0] * b03 - columns[3][2] * b00,
-                    columns[2][0] * b03 - columns[2][1] * b01 + columns[2][2] * b00);
-            result = result * (1.0f / determinant);
+            result.columns[0] = vec4::from_simd(simd_mul(inversed_column(m12, x0, m21, simd_shuffle<1, 0, 3, 2>(x0), m33, simd_mul(z0, signs)), inverse_determinant));
+            result.columns[1] = vec4::from_simd(simd_mul(inversed_column(m20, x1, m02, simd_shuffle<1, 0, 3, 2>(x1), m33, simd_mul(z1, flipped_signs)), inverse_determinant));
+            result.columns[2] = vec4::from_simd(simd_mul(inversed_column(m01, x2, m10, simd_shuffle<1, 0, 3, 2>(x2), m33, simd_mul(z2, signs)), inverse_determinant));
+            result.columns[3] = vec4::from_simd(simd_mul(inversed_column(m10, x3, m01, simd_shuffle<1, 0, 3, 2>(x3), m22, simd_mul(z2, flipped_signs)), inverse_determinant));
 
             return result;
         }
+
+    private:
+        // Returns (a[I], b[J], c[I], d[J])
+        template <int I, int J>
+        SIREN_INLINE static simd4f inversed_gather(simd4f a, simd4f b, simd4f c, simd4f d) {
+            simd4f low = simd_shuffle2<I, I, J, J>(a, b);
+            simd4f high = simd_shuffle2<I, I, J, J>(c, d);
+            return simd_shuffle2<0, 2, 0, 2>(low, high);
+        }
+
+        SIREN_INLINE static simd4f inversed_column(simd4f p, simd4f x, simd4f q, simd4f y, simd4f r, simd4f z) {
+            return simd_add(simd_sub(simd_mul(p, x), simd_mul(q, y)), simd_mul(r, z));
+        }
     };
 }
\ No newline at end of file
@@ -4,29 +4,20 @@
 
 #include "math/math.h"
 #include "math/matrix.h"
+#include "math/simd.h"
 
 #include "core/asserts.h"
 
 namespace siren {
-    struct quat {
+    struct alignas(16) quat {
         float x;
         float y;
         float z;
         float w;
 
-        SIREN_INLINE quat() {
-            x = 0.0f;
-            y = 0.0f;
-            z = 0.0f;
-            w = 1.0f;
-        }
+        SIREN_INLINE constexpr quat() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) { }
 
-        SIREN_INLINE quat(float x, float y, float z, float w) {
-            this->x = x;
-            this->y = y;
-            this->z = z;
-            this->w = w;
-        }
+        SIREN_INLINE constexpr quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) { }
 
         SIREN_INLINE float normal() const {
             return sqrtf((x * x) + (y * y) + (z * z) + (w * w));
@@ -37,7 +28,7 @@ namespace siren {
             return quat(x / _normal, y / _normal, z / _normal, w / _normal);
         }
 
-        SIREN_INLINE quat conjugate() const {
+        SIREN_INLINE constexpr quat conjugate() const {
             return quat(-x, -y, -z, w);
         }
 
@@ -61,15 +52,15 @@ namespace siren {
             return true;
         }
 
-        SIREN_INLINE quat operator+(const quat& other) const {
+        SIREN_INLINE constexpr quat operator+(const quat& other) const {
             return quat(x + other.x, y + other.y, z + other.z, w + other.w);
         }
 
-        SIREN_INLINE quat operator-(const quat& other) const {
+        SIREN_INLINE constexpr quat operator-(const quat& other) const {
             return quat(x - other.x, y - other.y, z - other.z, w - other.w);
         }
 
-        SIREN_INLINE quat operator*(const quat& other) const {
+        SIREN_INLINE constexpr quat operator*(const quat& other) const {
             quat result;
 
             result.x = x * other.w +
@@ -95,36 +86,35 @@ namespace siren {
             return result;
         }
 
-        SIREN_INLINE static float dot(const quat& a, const quat& b) {
+        SIREN_INLINE static constexpr float dot(const quat& a, const quat& b) {
             return (a.x * b.x) + (a.y * b.y) + (a.z * b.z) + (a.w * b.w);
         }
 
+        /*
+         * Column k is k_diagonal + 2 * (a + b * signs) * scale, where a and b are the products of quaternion components
+         * that sum into it. scale is -1 on the diagonal, so that lane becomes 1 - 2 * (a + b).
+         */
         SIREN_INLINE mat4 to_mat4() const {
+            simd4f n = simd_load(&x);
+            simd4f two = simd_splat(2.0f);
+
+            // (nyy, nxy, nxz) + (nzz, nwz, -nwy)
+            simd4f sum_0 = simd_add(
+                    simd_mul(simd_shuffle<1, 0, 0, 3>(n), simd_shuffle<1, 1, 2, 3>(n)),
+                    simd_mul(simd_mul(simd_shuffle<2, 3, 3, 3>(n), simd_shuffle<2, 2, 1, 3>(n)), simd_set(1.0f, 1.0f, -1.0f, 0.0f)));
+            // (nxy, nxx, nyz) + (-nwz, nzz, nwx)
+            simd4f sum_1 = simd_add(
+                    simd_mul(simd_shuffle<0, 0, 1, 3>(n), simd_shuffle<1, 0, 2, 3>(n)),
+                    simd_mul(simd_mul(simd_shuffle<3, 2, 3, 3>(n), simd_shuffle<2, 2, 0, 3>(n)), simd_set(-1.0f, 1.0f, 1.0f, 0.0f)));
+            // (nxz, nyz, nxx) + (nwy, -nwx, nyy)
+            simd4f sum_2 = simd_add(
+                    simd_mul(simd_shuffle<0, 1, 0, 3>(n), simd_shuffle<2, 2, 0, 3>(n)),
+                    simd_mul(simd_mul(simd_shuffle<3, 3, 1, 3>(n), simd_shuffle<1, 0, 1, 3>(n)), simd_set(1.0f, -1.0f, 1.0f, 0.0f)));
+
             mat4 result(1.0f);
-            // quat n = normalized();
-            quat n = quat(x, y, z, w);
-
-            float nxx = n.x * n.x;
-            float nyy = n.y * n.y;
-            float nzz = n.z * n.z;
-            float nxz = n.x * n.z;
-            float nxy = n.x * n.y;
-            float nyz = n.y * n.z;
-            float nwx = n.w * n.x;
-            float nwy = n.w * n.y;
-            float nwz = n.w * n.z;
-
-            result[0][0] = 1.0f - 2.0f * (nyy + nzz);
-            result[0][1] = 2.0f * (nxy + nwz);
-            result[0][2] = 2.0f * (nxz - nwy);
-
-            result[1][0] = 2.0f * (nxy - nwz);
-            result[1][1] = 1.0f - 2.0f * (nxx + nzz);
-            result[1][2] = 2.0f * (nyz + nwx);
-
-            result[2][0] = 2.0f * (nxz + nwy);
-            result[2][1] = 2.0f * (nyz - nwx);
-            result[2][2] = 1.0f - 2.0f * (nxx + nyy);
+            result.columns[0] = vec4::from_simd(simd_add(simd_set(1.0f, 0.0f, 0.0f, 0.0f), simd_mul(simd_mul(two, sum_0), simd_set(-1.0f, 1.0f, 1.0f, 0.0f))));
+            result.columns[1] = vec4::from_simd(simd_add(simd_set(0.0f, 1.0f, 0.0f, 0.0f), simd_mul(simd_mul(two, sum_1), simd_set(1.0f, -1.0f, 1.0f, 0.0f))));
+            result.columns[2] = vec4::from_simd(simd_add(simd_set(0.0f, 0.0f, 1.0f, 0.0f), simd_mul(simd_mul(two, sum_2), simd_set(1.0f, 1.0f, -1.0f, 0.0f))));
 
             return result;
         }
@@ -173,8 +163,8 @@ namespace siren {
             float sz = sin(z * 0.5f);
 
             return quat(
-                sx * cx * cz - cx * sy * sz,
-                cx * sy * cz - sx * cy * sz,
+                sx * cy * cz - cx * sy * sz,
+                cx * sy * cz + sx * cy * sz,
                 cx * cy * sz - sx * sy * cz,
                 cx * cy * cz + sx * sy * sz
             );
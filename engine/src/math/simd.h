@@ -0,0 +1,191 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ * Four wide float operations for the math types, picked at compile time from the target's instruction set. Define
+ * SIREN_SIMD_DISABLE to force the scalar path.
+ * Every path does the same lane-wise IEEE operations in the same order and never fuses a multiply into an add, so the
+ * scalar path gives bit-identical results to the vector ones. math-bench --check-kernels checks this.
+ */
+#if defined(SIREN_SIMD_DISABLE)
+#define SIREN_SIMD_SCALAR 1
+#elif defined(__AVX2__)
+#define SIREN_SIMD_SSE 1
+#define SIREN_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#define SIREN_SIMD_SSE 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SIREN_SIMD_NEON 1
+#else
+#define SIREN_SIMD_SCALAR 1
+#endif
+
+#if defined(SIREN_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(SIREN_SIMD_SSE)
+#include <emmintrin.h>
+#elif defined(SIREN_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace siren {
+#if defined(SIREN_SIMD_SSE)
+    typedef __m128 simd4f;
+
+    // Loads and stores need 16 byte aligned pointers
+    SIREN_INLINE simd4f simd_load(const float* values) {
+        return _mm_load_ps(values);
+    }
+
+    SIREN_INLINE void simd_store(float* values, simd4f v) {
+        _mm_store_ps(values, v);
+    }
+
+    SIREN_INLINE simd4f simd_load_unaligned(const float* values) {
+        return _mm_loadu_ps(values);
+    }
+
+    SIREN_INLINE simd4f simd_set(float x, float y, float z, float w) {
+        return _mm_set_ps(w, z, y, x);
+    }
+
+    SIREN_INLINE simd4f simd_splat(float value) {
+        return _mm_set1_ps(value);
+    }
+
+    SIREN_INLINE simd4f simd_add(simd4f a, simd4f b) {
+        return _mm_add_ps(a, b);
+    }
+
+    SIREN_INLINE simd4f simd_sub(simd4f a, simd4f b) {
+        return _mm_sub_ps(a, b);
+    }
+
+    SIREN_INLINE simd4f simd_mul(simd4f a, simd4f b) {
+        return _mm_mul_ps(a, b);
+    }
+
+    SIREN_INLINE simd4f simd_div(simd4f a, simd4f b) {
+        return _mm_div_ps(a, b);
+    }
+
+    // Returns (a[X], a[Y], b[Z], b[W])
+    template <int X, int Y, int Z, int W>
+    SIREN_INLINE simd4f simd_shuffle2(simd4f a, simd4f b) {
+        return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+    }
+#elif defined(SIREN_SIMD_NEON)
+    typedef float32x4_t simd4f;
+
+    SIREN_INLINE simd4f simd_load(const float* values) {
+        return vld1q_f32(values);
+    }
+
+    SIREN_INLINE void simd_store(float* values, simd4f v) {
+        vst1q_f32(values, v);
+    }
+
+    SIREN_INLINE simd4f simd_load_unaligned(const float* values) {
+        return vld1q_f32(values);
+    }
+
+    SIREN_INLINE simd4f simd_set(float x, float y, float z, float w) {
+        float values[4] = { x, y, z, w };
+        return vld1q_f32(values);
+    }
+
+    SIREN_INLINE simd4f simd_splat(float value) {
+        return vdupq_n_f32(value);
+    }
+
+    SIREN_INLINE simd4f simd_add(simd4f a, simd4f b) {
+        return vaddq_f32(a, b);
+    }
+
+    SIREN_INLINE simd4f simd_sub(simd4f a, simd4f b) {
+        return vsubq_f32(a, b);
+    }
+
+    SIREN_INLINE simd4f simd_mul(simd4f a, simd4f b) {
+        return vmulq_f32(a, b);
+    }
+
+    SIREN_INLINE simd4f simd_div(simd4f a, simd4f b) {
+        return vdivq_f32(a, b);
+    }
+
+    template <int X, int Y, int Z, int W>
+    SIREN_INLINE simd4f simd_shuffle2(simd4f a, simd4f b) {
+        simd4f result = vdupq_n_f32(vgetq_lane_f32(a, X));
+        result = vsetq_lane_f32(vgetq_lane_f32(a, Y), result, 1);
+        result = vsetq_lane_f32(vgetq_lane_f32(b, Z), result, 2);
+        return vsetq_lane_f32(vgetq_lane_f32(b, W), result, 3);
+    }
+#else
+    struct alignas(16) simd4f {
+        float lanes[4];
+    };
+
+    SIREN_INLINE simd4f simd_load(const float* values) {
+        return (simd4f) { { values[0], values[1], values[2], values[3] } };
+    }
+
+    SIREN_INLINE void simd_store(float* values, simd4f v) {
+        for (int lane = 0; lane < 4; lane++) {
+            values[lane] = v.lanes[lane];
+        }
+    }
+
+    SIREN_INLINE simd4f simd_load_unaligned(const float* values) {
+        return simd_load(values);
+    }
+
+    SIREN_INLINE simd4f simd_set(float x, float y, float z, float w) {
+        return (simd4f) { { x, y, z, w } };
+    }
+
+    SIREN_INLINE simd4f simd_splat(float value) {
+        return (simd4f) { { value, value, value, value } };
+    }
+
+    SIREN_INLINE simd4f simd_add(simd4f a, simd4f b) {
+        return (simd4f) { { a.lanes[0] + b.lanes[0], a.lanes[1] + b.lanes[1], a.lanes[2] + b.lanes[2], a.lanes[3] + b.lanes[3] } };
+    }
+
+    SIREN_INLINE simd4f simd_sub(simd4f a, simd4f b) {
+        return (simd4f) { { a.lanes[0] - b.lanes[0], a.lanes[1] - b.lanes[1], a.lanes[2] - b.lanes[2], a.lanes[3] - b.lanes[3] } };
+    }
+
+    SIREN_INLINE simd4f simd_mul(simd4f a, simd4f b) {
+        return (simd4f) { { a.lanes[0] * b.lanes[0], a.lanes[1] * b.lanes[1], a.lanes[2] * b.lanes[2], a.lanes[3] * b.lanes[3] } };
+    }
+
+    SIREN_INLINE simd4f simd_div(simd4f a, simd4f b) {
+        return (simd4f) { { a.lanes[0] / b.lanes[0], a.lanes[1] / b.lanes[1], a.lanes[2] / b.lanes[2], a.lanes[3] / b.lanes[3] } };
+    }
+
+    template <int X, int Y, int Z, int W>
+    SIREN_INLINE simd4f simd_shuffle2(simd4f a, simd4f b) {
+        return (simd4f) { { a.lanes[X], a.lanes[Y], b.lanes[Z], b.lanes[W] } };
+    }
+#endif
+
+    // Returns (v[X], v[Y], v[Z], v[W])
+    template <int X, int Y, int Z, int W>
+    SIREN_INLINE simd4f simd_shuffle(simd4f v) {
+        return simd_shuffle2<X, Y, Z, W>(v, v);
+    }
+
+    // Swaps rows and columns, treating a to d as the rows of a 4x4 matrix
+    SIREN_INLINE void simd_transpose(simd4f* a, simd4f* b, simd4f* c, simd4f* d) {
+        simd4f ab_low = simd_shuffle2<0, 1, 0, 1>(*a, *b);
+        simd4f ab_high = simd_shuffle2<2, 3, 2, 3>(*a, *b);
+        simd4f cd_low = simd_shuffle2<0, 1, 0, 1>(*c, *d);
+        simd4f cd_high = simd_shuffle2<2, 3, 2, 3>(*c, *d);
+        *a = simd_shuffle2<0, 2, 0, 2>(ab_low, cd_low);
+        *b = simd_shuffle2<1, 3, 1, 3>(ab_low, cd_low);
+        *c = simd_shuffle2<0, 2, 0, 2>(ab_high, cd_high);
+        *d = simd_shuffle2<1, 3, 1, 3>(ab_high, cd_high);
+    }
+}
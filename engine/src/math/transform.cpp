@@ -0,0 +1,147 @@
+#include "transform.h"
+
+#include "core/asserts.h"
+#include "math/simd.h"
+
+static const uint32_t TRANSFORM_BATCH_LANES = 4;
+
+/*
+ * Composes TRANSFORM_BATCH_LANES transforms starting at index. Lane n of every vector belongs to transform index + n,
+ * so each matrix element is worked out for all of them at once. columns[c][r] holds row r of column c.
+ */
+void transform_batch_compose(const siren::TransformBatch& batch, uint32_t index, siren::simd4f columns[4][4]) {
+    using namespace siren;
+
+    simd4f x = simd_load_unaligned(batch.rotation_x + index);
+    simd4f y = simd_load_unaligned(batch.rotation_y + index);
+    simd4f z = simd_load_unaligned(batch.rotation_z + index);
+    simd4f w = simd_load_unaligned(batch.rotation_w + index);
+    simd4f scale_x = simd_load_unaligned(batch.scale_x + index);
+    simd4f scale_y = simd_load_unaligned(batch.scale_y + index);
+    simd4f scale_z = simd_load_unaligned(batch.scale_z + index);
+
+    simd4f xx = simd_mul(x, x);
+    simd4f yy = simd_mul(y, y);
+    simd4f zz = simd_mul(z, z);
+    simd4f xy = simd_mul(x, y);
+    simd4f xz = simd_mul(x, z);
+    simd4f yz = simd_mul(y, z);
+    simd4f wx = simd_mul(w, x);
+    simd4f wy = simd_mul(w, y);
+    simd4f wz = simd_mul(w, z);
+    simd4f one = simd_splat(1.0f);
+    simd4f two = simd_splat(2.0f);
+    simd4f zero = simd_splat(0.0f);
+
+    // The rotation's first three columns, each scaled by its axis
+    columns[0][0] = simd_mul(simd_sub(one, simd_mul(two, simd_add(yy, zz))), scale_x);
+    columns[0][1] = simd_mul(simd_mul(two, simd_add(xy, wz)), scale_x);
+    columns[0][2] = simd_mul(simd_mul(two, simd_sub(xz, wy)), scale_x);
+    columns[0][3] = zero;
+    columns[1][0] = simd_mul(simd_mul(two, simd_sub(xy, wz)), scale_y);
+    columns[1][1] = simd_mul(simd_sub(one, simd_mul(two, simd_add(xx, zz))), scale_y);
+    columns[1][2] = simd_mul(simd_mul(two, simd_add(yz, wx)), scale_y);
+    columns[1][3] = zero;
+    columns[2][0] = simd_mul(simd_mul(two, simd_add(xz, wy)), scale_z);
+    columns[2][1] = simd_mul(simd_mul(two, simd_sub(yz, wx)), scale_z);
+    columns[2][2] = simd_mul(simd_sub(one, simd_mul(two, simd_add(xx, yy))), scale_z);
+    columns[2][3] = zero;
+    columns[3][0] = simd_load_unaligned(batch.position_x + index);
+    columns[3][1] = simd_load_unaligned(batch.position_y + index);
+    columns[3][2] = simd_load_unaligned(batch.position_z + index);
+    columns[3][3] = one;
+}
+
+// Transposing a column's rows gives that column for each lane's transform
+void transform_batch_store(siren::simd4f columns[4][4], siren::mat4* matrices) {
+    for (uint32_t column = 0; column < 4; column++) {
+        siren::simd4f* rows = columns[column];
+        siren::simd_transpose(&rows[0], &rows[1], &rows[2], &rows[3]);
+        for (uint32_t lane = 0; lane < TRANSFORM_BATCH_LANES; lane++) {
+            siren::simd_store(matrices[lane].columns[column].elements, rows[lane]);
+        }
+    }
+}
+
+// Transposing a row across the columns gives that row for each lane's transform, and the bottom row is never written
+void transform_batch_store(siren::simd4f columns[4][4], siren::affine3x4* matrices) {
+    for (uint32_t row = 0; row < 3; row++) {
+        siren::simd4f lanes[4] = { columns[0][row], columns[1][row], columns[2][row], columns[3][row] };
+        siren::simd_transpose(&lanes[0], &lanes[1], &lanes[2], &lanes[3]);
+        for (uint32_t lane = 0; lane < TRANSFORM_BATCH_LANES; lane++) {
+            siren::simd_store(matrices[lane].rows[row].elements, lanes[lane]);
+        }
+    }
+}
+
+template <typename T>
+void transform_batch_convert(const siren::TransformBatch& batch, T* matrices) {
+    siren::simd4f columns[4][4];
+    uint32_t index = 0;
+    for (; index + TRANSFORM_BATCH_LANES <= batch.count; index += TRANSFORM_BATCH_LANES) {
+        transform_batch_compose(batch, index, columns);
+        transform_batch_store(columns, matrices + index);
+    }
+    if (index == batch.count) {
+        return;
+    }
+
+    // The leftovers go through the same path, padded out with identity transforms
+    float tail[10][TRANSFORM_BATCH_LANES];
+    const float* sources[10] = {
+        batch.position_x, batch.position_y, batch.position_z,
+        batch.rotation_x, batch.rotation_y, batch.rotation_z, batch.rotation_w,
+        batch.scale_x, batch.scale_y, batch.scale_z
+    };
+    const float identity[10] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+    uint32_t tail_count = batch.count - index;
+    for (uint32_t component = 0; component < 10; component++) {
+        for (uint32_t lane = 0; lane < TRANSFORM_BATCH_LANES; lane++) {
+            tail[component][lane] = lane < tail_count ? sources[component][index + lane] : identity[component];
+        }
+    }
+    siren::TransformBatch tail_batch = (siren::TransformBatch) {
+        .position_x = tail[0],
+        .position_y = tail[1],
+        .position_z = tail[2],
+        .rotation_x = tail[3],
+        .rotation_y = tail[4],
+        .rotation_z = tail[5],
+        .rotation_w = tail[6],
+        .scale_x = tail[7],
+        .scale_y = tail[8],
+        .scale_z = tail[9],
+        .count = TRANSFORM_BATCH_LANES
+    };
+    T tail_matrices[TRANSFORM_BATCH_LANES];
+    transform_batch_compose(tail_batch, 0, columns);
+    transform_batch_store(columns, tail_matrices);
+    for (uint32_t lane = 0; lane < tail_count; lane++) {
+        matrices[index + lane] = tail_matrices[lane];
+    }
+}
+
+template <typename T>
+void transform_compose(const T* local, const int* parent_ids, uint32_t count, T* world) {
+    for (uint32_t index = 0; index < count; index++) {
+        int parent_id = parent_ids[index];
+        SIREN_ASSERT(parent_id < (int)index);
+        world[index] = parent_id == -1 ? local[index] : world[parent_id] * local[index];
+    }
+}
+
+void siren::transform_batch_to_mat4(const siren::TransformBatch& batch, siren::mat4* matrices) {
+    transform_batch_convert(batch, matrices);
+}
+
+void siren::transform_batch_to_affine3x4(const siren::TransformBatch& batch, siren::affine3x4* matrices) {
+    transform_batch_convert(batch, matrices);
+}
+
+void siren::transform_compose_hierarchy(const siren::mat4* local, const int* parent_ids, uint32_t count, siren::mat4* world) {
+    transform_compose(local, parent_ids, count, world);
+}
+
+void siren::transform_compose_hierarchy(const siren::affine3x4* local, const int* parent_ids, uint32_t count, siren::affine3x4* world) {
+    transform_compose(local, parent_ids, count, world);
+}
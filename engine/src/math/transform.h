@@ -5,6 +5,7 @@
 #include "math/vector3.h"
 #include "math/quaternion.h"
 #include "math/matrix.h"
+#include "math/affine.h"
 
 namespace siren {
     struct Transform {
@@ -30,8 +31,46 @@ namespace siren {
             return result;
         }
 
+        // translate(position) * rotation * scale(scale), written out instead of multiplied
         SIREN_API SIREN_INLINE mat4 to_mat4() {
-            return mat4::translate(position) * rotation.to_mat4() * mat4::scale(scale);
+            mat4 result = rotation.to_mat4();
+            result.columns[0] *= scale.x;
+            result.columns[1] *= scale.y;
+            result.columns[2] *= scale.z;
+            result.columns[3] = vec4(position.x, position.y, position.z, 1.0f);
+            return result;
+        }
+
+        SIREN_API SIREN_INLINE affine3x4 to_affine3x4() {
+            return affine3x4::from_mat4(to_mat4());
         }
     };
+
+    /*
+     * Transforms laid out as one array per component, so a batch can be turned into matrices several at a time. Every
+     * array holds count floats.
+     */
+    struct TransformBatch {
+        const float* position_x;
+        const float* position_y;
+        const float* position_z;
+        const float* rotation_x;
+        const float* rotation_y;
+        const float* rotation_z;
+        const float* rotation_w;
+        const float* scale_x;
+        const float* scale_y;
+        const float* scale_z;
+        uint32_t count;
+    };
+
+    // Writes batch.count matrices, the same as calling Transform::to_mat4 on each transform
+    SIREN_API void transform_batch_to_mat4(const TransformBatch& batch, mat4* matrices);
+    SIREN_API void transform_batch_to_affine3x4(const TransformBatch& batch, affine3x4* matrices);
+    /*
+     * Multiplies each local matrix by its parent's world matrix, for a hierarchy sorted so that every parent comes
+     * before its children. A parent id of -1 is a root. world may be the same array as local.
+     */
+    SIREN_API void transform_compose_hierarchy(const mat4* local, const int* parent_ids, uint32_t count, mat4* world);
+    SIREN_API void transform_compose_hierarchy(const affine3x4* local, const int* parent_ids, uint32_t count, affine3x4* world);
 }
\ No newline at end of file
@@ -12,21 +12,15 @@ namespace siren {
             int y;
         };
 
-        SIREN_INLINE ivec2() {
-            x = 0;
-            y = 0;
-        }
+        SIREN_INLINE constexpr ivec2() : x(0), y(0) { }
 
-        SIREN_INLINE ivec2(int x, int y) {
-            this->x = x;
-            this->y = y;
-        }
+        SIREN_INLINE constexpr ivec2(int x, int y) : x(x), y(y) { }
 
-        ivec2 operator+(const ivec2& other) {
+        SIREN_INLINE constexpr ivec2 operator+(const ivec2& other) const {
             return ivec2(x + other.x, y + other.y);
         }
 
-        ivec2 operator-(const ivec2& other) {
+        SIREN_INLINE constexpr ivec2 operator-(const ivec2& other) const {
             return ivec2(x - other.x, y - other.y);
         }
     };
@@ -42,20 +36,11 @@ namespace siren {
             };
         };
 
-        SIREN_INLINE vec2() {
-            x = 0;
-            y = 0;
-        }
+        SIREN_INLINE constexpr vec2() : x(0.0f), y(0.0f) { }
 
-        SIREN_INLINE vec2(const float& value) {
-            x = value;
-            y = value;
-        }
+        SIREN_INLINE constexpr vec2(const float& value) : x(value), y(value) { }
 
-        SIREN_INLINE vec2(float x, float y) {
-            this->x = x;
-            this->y = y;
-        }
+        SIREN_INLINE constexpr vec2(float x, float y) : x(x), y(y) { }
 
         SIREN_INLINE bool operator==(const vec2& other) const {
             if (fabs(x - other.x) > SIREN_FLOAT_EPSILON) {
@@ -67,41 +52,41 @@ namespace siren {
             return true;
         }
 
-        SIREN_INLINE vec2 operator+(const vec2& other) const {
+        SIREN_INLINE constexpr vec2 operator+(const vec2& other) const {
             return vec2(x + other.x, y + other.y);
         }
 
-        SIREN_INLINE vec2 operator-(const vec2& other) const {
+        SIREN_INLINE constexpr vec2 operator-(const vec2& other) const {
             return vec2(x - other.x, y - other.y);
         }
 
-        SIREN_INLINE vec2 operator*(const float scaler) const {
+        SIREN_INLINE constexpr vec2 operator*(const float scaler) const {
             return vec2(x * scaler, y * scaler);
         }
 
-        SIREN_INLINE vec2 operator/(const float scaler) const {
+        SIREN_INLINE constexpr vec2 operator/(const float scaler) const {
             return vec2(x / scaler, y / scaler);
         }
 
-        SIREN_INLINE vec2& operator+=(const vec2& other) {
+        SIREN_INLINE constexpr vec2& operator+=(const vec2& other) {
             x += other.x;
             y += other.y;
             return *this;
         }
 
-        SIREN_INLINE vec2& operator-=(const vec2& other) {
+        SIREN_INLINE constexpr vec2& operator-=(const vec2& other) {
             x -= other.x;
             y -= other.y;
             return *this;
         }
 
-        SIREN_INLINE vec2& operator*=(const float scaler) {
+        SIREN_INLINE constexpr vec2& operator*=(const float scaler) {
             x *= scaler;
             y *= scaler;
             return *this;
         }
 
-        SIREN_INLINE vec2& operator/=(const float scaler) {
+        SIREN_INLINE constexpr vec2& operator/=(const float scaler) {
             x /= scaler;
             y /= scaler;
             return *this;
@@ -129,9 +114,9 @@ namespace siren {
     }; // end union vec2
 
     // vec2 constants
-    static const vec2 VEC2_ZERO = vec2(0.0f, 0.0f);
-    static const vec2 VEC2_UP = vec2(0.0f, -1.0f);
-    static const vec2 VEC2_RIGHT = vec2(1.0f, 0.0f);
-    static const vec2 VEC2_DOWN = vec2(0.0f, 1.0f);
-    static const vec2 VEC2_LEFT = vec2(-1.0f, 0.0f);
+    static constexpr vec2 VEC2_ZERO = vec2(0.0f, 0.0f);
+    static constexpr vec2 VEC2_UP = vec2(0.0f, -1.0f);
+    static constexpr vec2 VEC2_RIGHT = vec2(1.0f, 0.0f);
+    static constexpr vec2 VEC2_DOWN = vec2(0.0f, 1.0f);
+    static constexpr vec2 VEC2_LEFT = vec2(-1.0f, 0.0f);
 }
\ No newline at end of file
@@ -20,29 +20,24 @@ namespace siren {
             float u, v, w;
         };
 
-        SIREN_INLINE vec3() {
-            x = 0;
-            y = 0;
-            z = 0;
-        }
+        SIREN_INLINE constexpr vec3() : x(0.0f), y(0.0f), z(0.0f) { }
 
-        SIREN_INLINE vec3(float value) {
-            x = value;
-            y = value;
-            z = value;
-        }
+        SIREN_INLINE constexpr vec3(float value) : x(value), y(value), z(value) { }
 
-        SIREN_INLINE vec3(float x, float y, float z) {
-            this->x = x;
-            this->y = y;
-            this->z = z;
-        }
+        SIREN_INLINE constexpr vec3(float x, float y, float z) : x(x), y(y), z(z) { }
 
-        SIREN_INLINE float& operator[](uint32_t index) {
+        // Constant expressions can only read the members the constructor set, which are x, y and z rather than elements
+        SIREN_INLINE constexpr float& operator[](uint32_t index) {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return index == 0 ? x : index == 1 ? y : z;
+            }
             return elements[index];
         }
 
-        SIREN_INLINE const float& operator[](uint32_t index) const {
+        SIREN_INLINE constexpr const float& operator[](uint32_t index) const {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return index == 0 ? x : index == 1 ? y : z;
+            }
             return elements[index];
         }
 
@@ -59,44 +54,44 @@ namespace siren {
             return true;
         }
 
-        SIREN_INLINE vec3 operator+(const vec3& other) const {
+        SIREN_INLINE constexpr vec3 operator+(const vec3& other) const {
             return vec3(x + other.x, y + other.y, z + other.z);
         }
 
-        SIREN_INLINE vec3 operator-(const vec3& other) const {
+        SIREN_INLINE constexpr vec3 operator-(const vec3& other) const {
             return vec3(x - other.x, y - other.y, z - other.z);
         }
 
-        SIREN_INLINE vec3 operator*(const float scaler) const {
+        SIREN_INLINE constexpr vec3 operator*(const float scaler) const {
             return vec3(x * scaler, y * scaler, z * scaler);
         }
 
-        SIREN_INLINE vec3 operator/(const float scaler) const {
+        SIREN_INLINE constexpr vec3 operator/(const float scaler) const {
             return vec3(x / scaler, y / scaler, z / scaler);
         }
 
-        SIREN_INLINE vec3& operator+=(const vec3& other) {
+        SIREN_INLINE constexpr vec3& operator+=(const vec3& other) {
             x += other.x;
             y += other.y;
             z += other.z;
             return *this;
         }
         
-        SIREN_INLINE vec3& operator-=(const vec3& other) {
+        SIREN_INLINE constexpr vec3& operator-=(const vec3& other) {
             x -= other.x;
             y -= other.y;
             z -= other.z;
             return *this;
         }
 
-        SIREN_INLINE vec3& operator*=(const float scaler) {
+        SIREN_INLINE constexpr vec3& operator*=(const float scaler) {
             x *= scaler;
             y *= scaler;
             z *= scaler;
             return *this;
         }
         
-        SIREN_INLINE vec3& operator/=(const float scaler) {
+        SIREN_INLINE constexpr vec3& operator/=(const float scaler) {
             x /= scaler;
             y /= scaler;
             z /= scaler;
@@ -123,27 +118,27 @@ namespace siren {
             return vec3(x - other.x, y - other.y, z - other.z).normalized();
         }
 
-        SIREN_INLINE static float dot(const vec3& a, const vec3& b) {
+        SIREN_INLINE static constexpr float dot(const vec3& a, const vec3& b) {
             return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
         }
 
-        SIREN_INLINE static vec3 cross(const vec3& a, const vec3& b) {
+        SIREN_INLINE static constexpr vec3 cross(const vec3& a, const vec3& b) {
             return vec3((a.y * b.z) - (a.z * b.y),
                         (a.z * b.x) - (a.x * b.z),
                         (a.x * b.y) - (a.y * b.x));
         }
 
-        SIREN_INLINE static vec3 lerp(const vec3& a, const vec3& b, float time) {
+        SIREN_INLINE static constexpr vec3 lerp(const vec3& a, const vec3& b, float time) {
             return a + ((b - a) * time);
         }
     }; // end union vec3
 
     // vec3 constants
-    static const vec3 VEC3_ZERO = vec3(0.0f, 0.0f, 0.0f);
-    static const vec3 VEC3_UP = vec3(0.0f, -1.0f, 0.0f);
-    static const vec3 VEC3_DOWN = vec3(0.0f, 1.0f, 0.0f);
-    static const vec3 VEC3_LEFT = vec3(-1.0f, 0.0f, 0.0f);
-    static const vec3 VEC3_RIGHT = vec3(1.0f, 0.0f, 0.0f);
-    static const vec3 VEC3_FORWARD = vec3(0.0f, 0.0f, -1.0f);
-    static const vec3 VEC3_BACK = vec3(0.0f, 0.0f, 1.0f);
+    static constexpr vec3 VEC3_ZERO = vec3(0.0f, 0.0f, 0.0f);
+    static constexpr vec3 VEC3_UP = vec3(0.0f, -1.0f, 0.0f);
+    static constexpr vec3 VEC3_DOWN = vec3(0.0f, 1.0f, 0.0f);
+    static constexpr vec3 VEC3_LEFT = vec3(-1.0f, 0.0f, 0.0f);
+    static constexpr vec3 VEC3_RIGHT = vec3(1.0f, 0.0f, 0.0f);
+    static constexpr vec3 VEC3_FORWARD = vec3(0.0f, 0.0f, -1.0f);
+    static constexpr vec3 VEC3_BACK = vec3(0.0f, 0.0f, 1.0f);
 }
\ No newline at end of file
@@ -3,9 +3,11 @@
 #include "defines.h"
 
 #include "math.h"
+#include "simd.h"
 
 namespace siren {
-    union vec4 {
+    // Aligned so the arithmetic below can load and store it as one vector
+    union alignas(16) vec4 {
         float elements[4];
         struct {
             union {
@@ -22,32 +24,24 @@ namespace siren {
             };
         };
 
-        SIREN_INLINE vec4() {
-            x = 0;
-            y = 0;
-            z = 0;
-            w = 0;
-        }
+        SIREN_INLINE constexpr vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) { }
 
-        SIREN_INLINE vec4(const float value) {
-            x = value;
-            y = value;
-            z = value;
-            w = value;
-        }
+        SIREN_INLINE constexpr vec4(const float value) : x(value), y(value), z(value), w(value) { }
 
-        SIREN_INLINE vec4(float x, float y, float z, float w) {
-            this->x = x;
-            this->y = y;
-            this->z = z;
-            this->w = w;
-        }
+        SIREN_INLINE constexpr vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) { }
 
-        SIREN_INLINE float& operator[](uint32_t index) {
+        // Constant expressions can only read the members the constructor set, which are x to w rather than elements
+        SIREN_INLINE constexpr float& operator[](uint32_t index) {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return index == 0 ? x : index == 1 ? y : index == 2 ? z : w;
+            }
             return elements[index];
         }
 
-        SIREN_INLINE const float& operator[](uint32_t index) const {
+        SIREN_INLINE constexpr const float& operator[](uint32_t index) const {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return index == 0 ? x : index == 1 ? y : index == 2 ? z : w;
+            }
             return elements[index];
         }
 
@@ -67,51 +61,78 @@ namespace siren {
             return true;
         }
 
-        SIREN_INLINE vec4 operator+(const vec4& other) const {
-            return vec4(x + other.x, y + other.y, z + other.z, w + other.w);
+        SIREN_INLINE static vec4 from_simd(simd4f v) {
+            vec4 result;
+            simd_store(result.elements, v);
+            return result;
         }
 
-        SIREN_INLINE vec4 operator-(const vec4& other) const {
-            return vec4(x - other.x, y - other.y, z - other.z, w - other.w);
+        SIREN_INLINE simd4f to_simd() const {
+            return simd_load(elements);
         }
 
-        SIREN_INLINE vec4 operator*(const float scaler) const {
-            return vec4(x * scaler, y * scaler, z * scaler, w * scaler);
+        // Intrinsics can't run at compile time, so constant expressions take the same lane-wise operations one at a time
+        SIREN_INLINE constexpr vec4 operator+(const vec4& other) const {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return vec4(x + other.x, y + other.y, z + other.z, w + other.w);
+            }
+            return from_simd(simd_add(to_simd(), other.to_simd()));
         }
 
-        SIREN_INLINE vec4 operator/(const float scaler) const {
-            return vec4(x / scaler, y / scaler, z / scaler, w / scaler);
+        SIREN_INLINE constexpr vec4 operator-(const vec4& other) const {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return vec4(x - other.x, y - other.y, z - other.z, w - other.w);
+            }
+            return from_simd(simd_sub(to_simd(), other.to_simd()));
         }
 
-        SIREN_INLINE vec4& operator+=(const vec4& other) {
-            x += other.x;
-            y += other.y;
-            z += other.z;
-            w += other.w;
+        SIREN_INLINE constexpr vec4 operator*(const float scaler) const {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return vec4(x * scaler, y * scaler, z * scaler, w * scaler);
+            }
+            return from_simd(simd_mul(to_simd(), simd_splat(scaler)));
+        }
+
+        SIREN_INLINE constexpr vec4 operator/(const float scaler) const {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                return vec4(x / scaler, y / scaler, z / scaler, w / scaler);
+            }
+            return from_simd(simd_div(to_simd(), simd_splat(scaler)));
+        }
+
+        SIREN_INLINE constexpr vec4& operator+=(const vec4& other) {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                *this = *this + other;
+                return *this;
+            }
+            simd_store(elements, simd_add(to_simd(), other.to_simd()));
             return *this;
         }
 
-        SIREN_INLINE vec4& operator-=(const vec4& other) {
-            x -= other.x;
-            y -= other.y;
-            z -= other.z;
-            w -= other.w;
+        SIREN_INLINE constexpr vec4& operator-=(const vec4& other) {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                *this = *this - other;
+                return *this;
+            }
+            simd_store(elements, simd_sub(to_simd(), other.to_simd()));
             return *this;
         }
 
-        SIREN_INLINE vec4& operator*=(const float scaler) {
-            x *= scaler;
-            y *= scaler;
-            z *= scaler;
-            w *= scaler;
+        SIREN_INLINE constexpr vec4& operator*=(const float scaler) {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                *this = *this * scaler;
+                return *this;
+            }
+            simd_store(elements, simd_mul(to_simd(), simd_splat(scaler)));
             return *this;
         }
 
-        SIREN_INLINE vec4& operator/=(const float scaler) {
-            x /= scaler;
-            y /= scaler;
-            z /= scaler;
-            w /= scaler;
+        SIREN_INLINE constexpr vec4& operator/=(const float scaler) {
+            if (SIREN_IS_CONSTANT_EVALUATED()) {
+                *this = *this / scaler;
+                return *this;
+            }
+            simd_store(elements, simd_div(to_simd(), simd_splat(scaler)));
             return *this;
         }
 
@@ -124,7 +145,7 @@ namespace siren {
             if (_length == 0.0f) {
                 return vec4(0.0f);
             }
-            return vec4(x / _length, y / _length, z / _length, w / _length);
+            return *this / _length;
         }
     }; // end union vec4
 }
\ No newline at end of file
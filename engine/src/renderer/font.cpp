@@ -1,8 +1,17 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_FONT
+
 #include "font.h"
 
 #include "core/logger.h"
 #include "core/resource.h"
+#include "core/profiler.h"
+#include "core/memory.h"
+#include "core/job.h"
+#include "core/asset.h"
+#include "core/slot_map.h"
 #include "math/math.h"
+#include "renderer/renderer.h"
+#include "renderer/texture.h"
 
 #include <glad/glad.h>
 #include <SDL2/SDL.h>
@@ -10,12 +19,95 @@
 
 #include <cstring>
 #include <cstdio>
+#include <vector>
+#include <mutex>
 #include <unordered_map>
 
-static std::vector<siren::Font> fonts;
+struct FontSlot {
+    siren::Font font;
+    // Key in font_handles
+    std::string key;
+    std::string path;
+};
+
+// The render thread looks fonts up while the main thread adds them, which the slot map's fixed pages allow
+static siren::SlotMap<FontSlot> fonts;
 static std::unordered_map<std::string, siren::FontHandle> font_handles;
+// Returned for handles that don't resolve. It has no atlas, so text drawn with it is skipped.
+static const siren::Font FONT_EMPTY = (siren::Font) {
+    .atlas = 0,
+    .glyph_width = 0,
+    .glyph_height = 0,
+    .atlas_width = 0,
+    .atlas_height = 0
+};
+// SDL_ttf shares one FreeType library between every font, so fonts are rasterized one at a time
+static std::mutex font_rasterize_mutex;
+
+/*
+ * Cooked atlases are cached as <cache path>/<source hash>_<size>.sfnt, since one ttf makes a different atlas per size.
+ * A FontCookedHeader is followed by the atlas as one byte per texel.
+ */
+static const char FONT_COOKED_MAGIC[4] = { 'S', 'F', 'N', 'T' };
+static const uint32_t FONT_COOKED_VERSION = 1;
+static const size_t FONT_COOKED_PATH_LENGTH = 1024;
+
+struct FontCookedHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint32_t size;
+    uint32_t glyph_width;
+    uint32_t glyph_height;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+};
+
+// Glyphs rendered into a single channel atlas, ready to be uploaded
+struct FontAtlas {
+    // Points into storage for a rasterized atlas, or into cooked_file for a cached one
+    const uint8_t* pixels;
+    std::vector<uint8_t> storage;
+    siren::ResourceFile cooked_file;
+    uint32_t width;
+    uint32_t height;
+    uint32_t glyph_width;
+    uint32_t glyph_height;
+};
+
+struct FontLoad {
+    std::string path;
+    uint16_t size;
+    siren::FontHandle handle;
+    FontAtlas atlas;
+    bool is_rasterized;
+    siren::Font font;
+};
 
-bool font_load(siren::Font* font, std::string path, uint16_t size);
+bool font_rasterize(FontAtlas* atlas, std::string path, uint16_t size);
+bool font_rasterize_ttf(FontAtlas* atlas, const siren::ResourceFile& file, const std::string& path, uint16_t size);
+bool font_read_cooked(FontAtlas* atlas, const char* cooked_path, uint64_t source_hash, uint64_t source_size, uint16_t size);
+bool font_write_cooked(const FontAtlas* atlas, const char* cooked_path, uint64_t source_hash, uint64_t source_size, uint16_t size);
+void font_upload(siren::Font* font, FontAtlas* atlas, const char* path);
+// Slots are inserted before loading, so that a full slot map fails before any work is done
+siren::FontHandle font_insert(const std::string& key, const std::string& path) {
+    FontSlot slot;
+    slot.font = FONT_EMPTY;
+    slot.key = key;
+    slot.path = path;
+    siren::FontHandle handle = siren::slot_map_insert(&fonts, std::move(slot));
+    if (handle == siren::FONT_HANDLE_NULL) {
+        SIREN_ERROR("Unable to load font %s, %u fonts are already loaded.", key.c_str(), siren::SLOT_MAP_MAX_SLOTS);
+    }
+    return handle;
+}
+
+void font_set_resident(siren::FontHandle handle, const siren::Font& font) {
+    uint64_t vram_bytes = siren::texture_get_memory_size(GL_RED, siren::ivec2(font.atlas_width, font.atlas_height), 1, 1, 1);
+    siren::asset_set_resident(siren::ASSET_TYPE_FONT, handle, vram_bytes, 0);
+}
 
 siren::FontHandle siren::font_acquire(const char* path, uint16_t size) {
     std::string key = std::string(path) + std::string(":") + std::to_string(size);
@@ -23,30 +115,240 @@ siren::FontHandle siren::font_acquire(const char* path, uint16_t size) {
     // Check if font has been loaded
     auto it = font_handles.find(key);
     if (it != font_handles.end()) {
+        asset_reference(ASSET_TYPE_FONT, it->second);
         return it->second;
     }
 
     // Begin creating a new font
-    Font font;
-    std::string full_path = resource_get_base_path() + std::string(path);
-    if (!font_load(&font, full_path, size)) {
+    SIREN_PROFILE_SCOPE("font_load");
+    FontAtlas atlas;
+    if (!font_rasterize(&atlas, std::string(path), size)) {
+        return FONT_HANDLE_NULL;
+    }
+    FontHandle handle = font_insert(key, std::string(path));
+    if (handle == FONT_HANDLE_NULL) {
+        atlas.storage = std::vector<uint8_t>();
+        resource_close(&atlas.cooked_file);
         return FONT_HANDLE_NULL;
     }
 
-    fonts.push_back(font);
-    FontHandle handle = fonts.size() - 1;
+    RendererContextScope context_scope;
+    FontSlot* slot = slot_map_get(&fonts, handle);
+    font_upload(&slot->font, &atlas, path);
+
+    font_handles[key] = handle;
+    font_set_resident(handle, slot->font);
+    asset_reference(ASSET_TYPE_FONT, handle);
+    return handle;
+}
+
+void siren::font_release(siren::FontHandle handle) {
+    if (slot_map_get(&fonts, handle) == NULL) {
+        return;
+    }
+    asset_unreference(ASSET_TYPE_FONT, handle);
+}
+
+void siren::font_evict(uint32_t handle) {
+    FontSlot* slot = slot_map_get(&fonts, handle);
+    if (slot == NULL) {
+        return;
+    }
+    const Font& font = slot->font;
+    texture_track_memory(MEMORY_TAG_FONT, slot->path.c_str(), GL_RED, ivec2(font.atlas_width, font.atlas_height), 1, 1, 1, true);
+    glDeleteTextures(1, &font.atlas);
+    SIREN_TRACE("Evicted font %s.", slot->key.c_str());
+
+    // The next acquire loads it into a new slot, and this handle stops resolving
+    font_handles.erase(slot->key);
+    slot_map_remove(&fonts, handle);
+}
+
+bool font_load_upload(void* data) {
+    FontLoad* load = (FontLoad*)data;
+    if (load->is_rasterized) {
+        font_upload(&load->font, &load->atlas, load->path.c_str());
+    }
+    return true;
+}
+
+void font_load_finish(void* data) {
+    FontLoad* load = (FontLoad*)data;
+    // Fonts without an atlas are never evicted, so the slot is still there
+    FontSlot* slot = siren::slot_map_get(&fonts, load->handle);
+    if (load->is_rasterized) {
+        slot->font = load->font;
+        font_set_resident(load->handle, load->font);
+    } else {
+        // The handle stops resolving, and the next acquire tries again
+        SIREN_ERROR("Font %s failed to load.", slot->key.c_str());
+        font_handles.erase(slot->key);
+        siren::slot_map_remove(&fonts, load->handle);
+        siren::asset_forget(siren::ASSET_TYPE_FONT, load->handle);
+    }
+    delete load;
+}
+
+void font_load_job(void* data) {
+    FontLoad* load = (FontLoad*)data;
+    load->is_rasterized = font_rasterize(&load->atlas, load->path, load->size);
+    siren::renderer_queue_upload(font_load_upload, font_load_finish, load);
+}
+
+siren::FontHandle siren::font_acquire_async(const char* path, uint16_t size) {
+    std::string key = std::string(path) + std::string(":") + std::to_string(size);
+    auto it = font_handles.find(key);
+    if (it != font_handles.end()) {
+        asset_reference(ASSET_TYPE_FONT, it->second);
+        return it->second;
+    }
+
+    // Text drawn with a font that has no atlas yet is skipped
+    FontHandle handle = font_insert(key, std::string(path));
+    if (handle == FONT_HANDLE_NULL) {
+        return FONT_HANDLE_NULL;
+    }
     font_handles[key] = handle;
+    asset_reference(ASSET_TYPE_FONT, handle);
+
+    FontLoad* load = new FontLoad();
+    load->path = std::string(path);
+    load->size = size;
+    load->handle = handle;
+    load->is_rasterized = false;
+    Job job = (Job) {
+        .function = font_load_job,
+        .data = load
+    };
+    job_run(&job, 1, NULL);
+
     return handle;
 }
 
+bool siren::font_is_ready(siren::FontHandle handle) {
+    return font_get(handle).atlas != 0;
+}
+
 const siren::Font& siren::font_get(siren::FontHandle handle) {
-    return fonts[handle];
+    const FontSlot* slot = slot_map_get(&fonts, handle);
+    return slot != NULL ? slot->font : FONT_EMPTY;
+}
+
+bool font_get_cooked_path(uint64_t source_hash, uint16_t size, char* buffer, size_t buffer_size) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "_%u.sfnt", (uint32_t)size);
+    return siren::resource_get_cache_file(source_hash, suffix, buffer, buffer_size);
 }
 
-bool font_load(siren::Font* font, std::string path, uint16_t size) {
+bool font_read_cooked(FontAtlas* atlas, const char* cooked_path, uint64_t source_hash, uint64_t source_size, uint16_t size) {
+    siren::ResourceFile& file = atlas->cooked_file;
+    if (!siren::resource_open_file(cooked_path, &file)) {
+        return false;
+    }
+
+    FontCookedHeader header;
+    bool is_valid = file.size >= sizeof(header);
+    if (is_valid) {
+        memcpy(&header, file.data, sizeof(header));
+        is_valid = memcmp(header.magic, FONT_COOKED_MAGIC, sizeof(header.magic)) == 0 && header.version == FONT_COOKED_VERSION &&
+                   header.source_hash == source_hash && header.source_size == source_size && header.size == size &&
+                   header.height != 0 && (file.size - sizeof(header)) / header.height >= header.width;
+    }
+    if (!is_valid) {
+        siren::resource_close(&file);
+        return false;
+    }
+
+    atlas->pixels = file.data + sizeof(header);
+    atlas->width = header.width;
+    atlas->height = header.height;
+    atlas->glyph_width = header.glyph_width;
+    atlas->glyph_height = header.glyph_height;
+    return true;
+}
+
+bool font_write_cooked(const FontAtlas* atlas, const char* cooked_path, uint64_t source_hash, uint64_t source_size, uint16_t size) {
+    FontCookedHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FONT_COOKED_MAGIC, sizeof(header.magic));
+    header.version = FONT_COOKED_VERSION;
+    header.source_hash = source_hash;
+    header.source_size = source_size;
+    header.size = size;
+    header.glyph_width = atlas->glyph_width;
+    header.glyph_height = atlas->glyph_height;
+    header.width = atlas->width;
+    header.height = atlas->height;
+
+    std::vector<uint8_t> blob(sizeof(header) + (size_t)atlas->width * atlas->height);
+    memcpy(blob.data(), &header, sizeof(header));
+    memcpy(blob.data() + sizeof(header), atlas->pixels, (size_t)atlas->width * atlas->height);
+    return siren::resource_write_file(cooked_path, blob.data(), blob.size());
+}
+
+// Reads the cooked atlas if there is an up to date one, and otherwise rasterizes it and cooks it for next time
+bool font_rasterize(FontAtlas* atlas, std::string path, uint16_t size) {
+    SIREN_PROFILE_SCOPE("font_rasterize");
+    atlas->pixels = NULL;
+    atlas->cooked_file = (siren::ResourceFile) { .data = NULL, .size = 0, .storage = NULL };
+    siren::ResourceFile file;
+    if (!siren::resource_open(path.c_str(), &file)) {
+        return false;
+    }
+
+    char cooked_path[FONT_COOKED_PATH_LENGTH];
+    uint64_t source_hash = 0;
+    bool is_cache_enabled = siren::resource_get_cache_path() != NULL;
+    if (is_cache_enabled) {
+        source_hash = siren::resource_hash(file.data, file.size);
+        is_cache_enabled = font_get_cooked_path(source_hash, size, cooked_path, sizeof(cooked_path));
+    }
+    if (is_cache_enabled && font_read_cooked(atlas, cooked_path, source_hash, file.size, size)) {
+        siren::resource_close(&file);
+        return true;
+    }
+
+    bool success = font_rasterize_ttf(atlas, file, path, size);
+    if (success && is_cache_enabled) {
+        font_write_cooked(atlas, cooked_path, source_hash, file.size, size);
+    }
+    siren::resource_close(&file);
+    return success;
+}
+
+siren::CookResult siren::font_cook(const char* path, uint16_t size) {
+    SIREN_PROFILE_SCOPE("font_cook");
+    ResourceFile file;
+    if (!resource_open(path, &file)) {
+        return COOK_FAILED;
+    }
+    uint64_t source_hash = resource_hash(file.data, file.size);
+    char cooked_path[FONT_COOKED_PATH_LENGTH];
+    if (!font_get_cooked_path(source_hash, size, cooked_path, sizeof(cooked_path))) {
+        resource_close(&file);
+        return COOK_FAILED;
+    }
+
+    FontAtlas atlas;
+    atlas.pixels = NULL;
+    atlas.cooked_file = (ResourceFile) { .data = NULL, .size = 0, .storage = NULL };
+    CookResult result = COOK_UP_TO_DATE;
+    if (!font_read_cooked(&atlas, cooked_path, source_hash, file.size, size)) {
+        bool success = font_rasterize_ttf(&atlas, file, std::string(path), size) && font_write_cooked(&atlas, cooked_path, source_hash, file.size, size);
+        result = success ? COOK_WRITTEN : COOK_FAILED;
+    }
+    resource_close(&atlas.cooked_file);
+    resource_close(&file);
+    return result;
+}
+
+// Renders every glyph into the atlas. Touches no GL state, so it can run on any thread.
+bool font_rasterize_ttf(FontAtlas* atlas, const siren::ResourceFile& file, const std::string& path, uint16_t size) {
     static const SDL_Color COLOR_WHITE = { 255, 255, 255, 255 };
+    std::lock_guard<std::mutex> lock(font_rasterize_mutex);
 
-    TTF_Font* ttf_font = TTF_OpenFont(path.c_str(), size);
+    // The font reads from the file as glyphs are rendered, so the file has to outlive it
+    TTF_Font* ttf_font = TTF_OpenFontRW(SDL_RWFromConstMem(file.data, (int)file.size), 1, size);
     if (ttf_font == NULL) {
         SIREN_ERROR("Unable to open font at path %s. SDL Error: %s", path.c_str(), TTF_GetError());
         return false;
@@ -60,6 +362,10 @@ bool font_load(siren::Font* font, std::string path, uint16_t size) {
         char text[2] = { (char)(i + siren::Font::FIRST_CHAR), '\0' };
         glyphs[i] = TTF_RenderText_Solid(ttf_font, text, COLOR_WHITE);
         if (glyphs[i] == NULL) {
+            for (int j = 0; j < i; j++) {
+                SDL_FreeSurface(glyphs[j]);
+            }
+            TTF_CloseFont(ttf_font);
             return false;
         }
 
@@ -70,30 +376,53 @@ bool font_load(siren::Font* font, std::string path, uint16_t size) {
     // Render each surface glyph onto an atlas surface
     int atlas_width = siren::next_largest_power_of_two(max_width * 96);
     int atlas_height = siren::next_largest_power_of_two(max_height);
-    SDL_Surface* atlas_surface = SDL_CreateRGBSurface(0, atlas_width, atlas_height, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+    SDL_Surface* surface = SDL_CreateRGBSurface(0, atlas_width, atlas_height, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
     for (int i = 0; i < 96; i++) {
         SDL_Rect dest_rect = { max_width * i, 0, glyphs[i]->w, glyphs[i]->h };
-        SDL_BlitSurface(glyphs[i], NULL, atlas_surface, &dest_rect);
+        SDL_BlitSurface(glyphs[i], NULL, surface, &dest_rect);
     }
 
-    // Render the atlas surface onto a GL texture
-    glGenTextures(1, &font->atlas);
-    glBindTexture(GL_TEXTURE_2D, font->atlas);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas_width, atlas_height, 0, GL_BGRA, GL_UNSIGNED_BYTE, atlas_surface->pixels);
-
-    // Finish setting up FontData struct
-    font->glyph_width = (uint32_t)max_width;
-    font->glyph_height = (uint32_t)max_height;
+    // Text only samples the red channel, so that's all the atlas keeps
+    atlas->storage.resize((size_t)atlas_width * atlas_height);
+    for (int y = 0; y < atlas_height; y++) {
+        const uint32_t* row = (const uint32_t*)((const uint8_t*)surface->pixels + y * surface->pitch);
+        for (int x = 0; x < atlas_width; x++) {
+            atlas->storage[(size_t)y * atlas_width + x] = (uint8_t)((row[x] & 0x00ff0000) >> 16);
+        }
+    }
+    atlas->pixels = atlas->storage.data();
+    atlas->width = (uint32_t)atlas_width;
+    atlas->height = (uint32_t)atlas_height;
+    atlas->glyph_width = (uint32_t)max_width;
+    atlas->glyph_height = (uint32_t)max_height;
 
     // Cleanup
-    glBindTexture(GL_TEXTURE_2D, 0);
+    SDL_FreeSurface(surface);
     for (int i = 0; i < 96; i++) {
         SDL_FreeSurface(glyphs[i]);
     }
-    SDL_FreeSurface(atlas_surface);
     TTF_CloseFont(ttf_font);
 
     return true;
-}
\ No newline at end of file
+}
+
+// Upload the atlas to a GL texture and free the atlas
+void font_upload(siren::Font* font, FontAtlas* atlas, const char* path) {
+    glGenTextures(1, &font->atlas);
+    glBindTexture(GL_TEXTURE_2D, font->atlas);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas->width, atlas->height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas->pixels);
+    siren::texture_track_memory(siren::MEMORY_TAG_FONT, path, GL_RED, siren::ivec2(atlas->width, atlas->height), 1, 1, 1);
+
+    // Finish setting up FontData struct
+    font->glyph_width = atlas->glyph_width;
+    font->glyph_height = atlas->glyph_height;
+    font->atlas_width = atlas->width;
+    font->atlas_height = atlas->height;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    atlas->storage = std::vector<uint8_t>();
+    siren::resource_close(&atlas->cooked_file);
+    atlas->pixels = NULL;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "core/cook.h"
 
 namespace siren {
     struct Font {
@@ -9,10 +10,26 @@ namespace siren {
         uint32_t atlas;
         uint32_t glyph_width;
         uint32_t glyph_height;
+        uint32_t atlas_width;
+        uint32_t atlas_height;
     };
 
+    // A slot map handle, see slot_map.h. Handles to an evicted font stop resolving rather than aliasing another font.
     typedef uint32_t FontHandle;
     static const FontHandle FONT_HANDLE_NULL = UINT32_MAX;
     SIREN_API FontHandle font_acquire(const char* path, uint16_t size);
+    // Starts loading a font on a worker thread and returns its handle straight away. Text drawn with it is skipped until it's ready.
+    SIREN_API FontHandle font_acquire_async(const char* path, uint16_t size);
+    SIREN_API bool font_is_ready(FontHandle handle);
+    /*
+     * Drops a reference taken by font_acquire or font_acquire_async. A font with no references stays loaded until it's
+     * evicted to stay under the VRAM budget, see asset.h, after which acquiring it again loads it under a new handle.
+     */
+    SIREN_API void font_release(FontHandle handle);
+    // Deletes a font's atlas and frees its slot, called by the asset system
+    void font_evict(uint32_t handle);
+    // Writes the cached atlas of a font at one size without loading it. See cook.h. Safe to call from any thread.
+    SIREN_API CookResult font_cook(const char* path, uint16_t size);
+    // A font with no atlas if the handle doesn't resolve
     const Font& font_get(FontHandle handle);
 }
\ No newline at end of file
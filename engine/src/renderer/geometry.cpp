@@ -1,53 +1,76 @@
 #include "geometry.h"
 
+#include "core/memory.h"
+
 #include <glad/glad.h>
 #include <cstddef>
 
+constexpr siren::Geometry::VertexData siren::GEOMETRY_CUBE_VERTICES[GEOMETRY_CUBE_VERTEX_COUNT] = {
+    // back face
+    { vec3(-1.0f, -1.0f, -1.0f), vec3( 0.0f,  0.0f, -1.0f), vec3( 0.0f,  0.0f,  0.0f) }, // bottom-left
+    { vec3( 1.0f,  1.0f, -1.0f), vec3( 0.0f,  0.0f, -1.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-right
+    { vec3( 1.0f, -1.0f, -1.0f), vec3( 0.0f,  0.0f, -1.0f), vec3( 1.0f,  0.0f,  0.0f) }, // bottom-right
+    { vec3( 1.0f,  1.0f, -1.0f), vec3( 0.0f,  0.0f, -1.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-right
+    { vec3(-1.0f, -1.0f, -1.0f), vec3( 0.0f,  0.0f, -1.0f), vec3( 0.0f,  0.0f,  0.0f) }, // bottom-left
+    { vec3(-1.0f,  1.0f, -1.0f), vec3( 0.0f,  0.0f, -1.0f), vec3( 0.0f,  1.0f,  0.0f) }, // top-left
+    // front face
+    { vec3(-1.0f, -1.0f,  1.0f), vec3( 0.0f,  0.0f,  1.0f), vec3( 0.0f,  0.0f,  0.0f) }, // bottom-left
+    { vec3( 1.0f, -1.0f,  1.0f), vec3( 0.0f,  0.0f,  1.0f), vec3( 1.0f,  0.0f,  0.0f) }, // bottom-right
+    { vec3( 1.0f,  1.0f,  1.0f), vec3( 0.0f,  0.0f,  1.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-right
+    { vec3( 1.0f,  1.0f,  1.0f), vec3( 0.0f,  0.0f,  1.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-right
+    { vec3(-1.0f,  1.0f,  1.0f), vec3( 0.0f,  0.0f,  1.0f), vec3( 0.0f,  1.0f,  0.0f) }, // top-left
+    { vec3(-1.0f, -1.0f,  1.0f), vec3( 0.0f,  0.0f,  1.0f), vec3( 0.0f,  0.0f,  0.0f) }, // bottom-left
+    // left face
+    { vec3(-1.0f,  1.0f,  1.0f), vec3(-1.0f,  0.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // top-right
+    { vec3(-1.0f,  1.0f, -1.0f), vec3(-1.0f,  0.0f,  0.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-left
+    { vec3(-1.0f, -1.0f, -1.0f), vec3(-1.0f,  0.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // bottom-left
+    { vec3(-1.0f, -1.0f, -1.0f), vec3(-1.0f,  0.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // bottom-left
+    { vec3(-1.0f, -1.0f,  1.0f), vec3(-1.0f,  0.0f,  0.0f), vec3( 0.0f,  0.0f,  0.0f) }, // bottom-right
+    { vec3(-1.0f,  1.0f,  1.0f), vec3(-1.0f,  0.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // top-right
+    // right face
+    { vec3( 1.0f,  1.0f,  1.0f), vec3( 1.0f,  0.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // top-left
+    { vec3( 1.0f, -1.0f, -1.0f), vec3( 1.0f,  0.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // bottom-right
+    { vec3( 1.0f,  1.0f, -1.0f), vec3( 1.0f,  0.0f,  0.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-right
+    { vec3( 1.0f, -1.0f, -1.0f), vec3( 1.0f,  0.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // bottom-right
+    { vec3( 1.0f,  1.0f,  1.0f), vec3( 1.0f,  0.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // top-left
+    { vec3( 1.0f, -1.0f,  1.0f), vec3( 1.0f,  0.0f,  0.0f), vec3( 0.0f,  0.0f,  0.0f) }, // bottom-left
+    // bottom face
+    { vec3(-1.0f, -1.0f, -1.0f), vec3( 0.0f, -1.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // top-right
+    { vec3( 1.0f, -1.0f, -1.0f), vec3( 0.0f, -1.0f,  0.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-left
+    { vec3( 1.0f, -1.0f,  1.0f), vec3( 0.0f, -1.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // bottom-left
+    { vec3( 1.0f, -1.0f,  1.0f), vec3( 0.0f, -1.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // bottom-left
+    { vec3(-1.0f, -1.0f,  1.0f), vec3( 0.0f, -1.0f,  0.0f), vec3( 0.0f,  0.0f,  0.0f) }, // bottom-right
+    { vec3(-1.0f, -1.0f, -1.0f), vec3( 0.0f, -1.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // top-right
+    // top face
+    { vec3(-1.0f,  1.0f, -1.0f), vec3( 0.0f,  1.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // top-left
+    { vec3( 1.0f,  1.0f,  1.0f), vec3( 0.0f,  1.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // bottom-right
+    { vec3( 1.0f,  1.0f, -1.0f), vec3( 0.0f,  1.0f,  0.0f), vec3( 1.0f,  1.0f,  0.0f) }, // top-right
+    { vec3( 1.0f,  1.0f,  1.0f), vec3( 0.0f,  1.0f,  0.0f), vec3( 1.0f,  0.0f,  0.0f) }, // bottom-right
+    { vec3(-1.0f,  1.0f, -1.0f), vec3( 0.0f,  1.0f,  0.0f), vec3( 0.0f,  1.0f,  0.0f) }, // top-left
+    { vec3(-1.0f,  1.0f,  1.0f), vec3( 0.0f,  1.0f,  0.0f), vec3( 0.0f,  0.0f,  0.0f) }  // bottom-left
+};
+
+// Checked at compile time, which also keeps the table and the vec3 math it's checked with usable in constant expressions
+constexpr bool geometry_is_cube_wound_toward_normals() {
+    for (uint32_t index = 0; index < siren::GEOMETRY_CUBE_VERTEX_COUNT; index += 3) {
+        const siren::Geometry::VertexData* triangle = &siren::GEOMETRY_CUBE_VERTICES[index];
+        siren::vec3 face_normal = siren::vec3::cross(triangle[1].position - triangle[0].position, triangle[2].position - triangle[0].position);
+        if (siren::vec3::dot(face_normal, triangle[0].normal) <= 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(geometry_is_cube_wound_toward_normals(), "Every cube triangle has to wind counterclockwise around its normal");
+
 siren::Geometry siren::geometry_create_cube(vec3 extents) {
-	float cube_vertices[] = {
-		// back face
-		-extents.x, -extents.y, -extents.z,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, // bottom-left
-		 extents.x,  extents.y, -extents.z,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, 0.0f, // top-right
-		 extents.x, -extents.y, -extents.z,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, 0.0f, // bottom-right
-		 extents.x,  extents.y, -extents.z,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, 0.0f, // top-right
-		-extents.x, -extents.y, -extents.z,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, 0.0f, // bottom-left
-		-extents.x,  extents.y, -extents.z,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, 0.0f, // top-left
-		// front face
-		-extents.x, -extents.y,  extents.z,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, 0.0f, // bottom-left
-		 extents.x, -extents.y,  extents.z,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, 0.0f, // bottom-right
-		 extents.x,  extents.y,  extents.z,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, 0.0f, // top-right
-		 extents.x,  extents.y,  extents.z,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, 0.0f, // top-right
-		-extents.x,  extents.y,  extents.z,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, 0.0f, // top-left
-		-extents.x, -extents.y,  extents.z,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, 0.0f, // bottom-left
-		// left face
-		-extents.x,  extents.y,  extents.z, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f, // top-right
-		-extents.x,  extents.y, -extents.z, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, 0.0f, // top-left
-		-extents.x, -extents.y, -extents.z, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, 0.0f, // bottom-left
-		-extents.x, -extents.y, -extents.z, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, 0.0f, // bottom-left
-		-extents.x, -extents.y,  extents.z, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, 0.0f, // bottom-right
-		-extents.x,  extents.y,  extents.z, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f, // top-right
-		// right face
-		 extents.x,  extents.y,  extents.z,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f, // top-left
-		 extents.x, -extents.y, -extents.z,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, 0.0f, // bottom-right
-		 extents.x,  extents.y, -extents.z,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, 0.0f, // top-right
-		 extents.x, -extents.y, -extents.z,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, 0.0f, // bottom-right
-		 extents.x,  extents.y,  extents.z,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f, // top-left
-		 extents.x, -extents.y,  extents.z,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, 0.0f, // bottom-left
-		 // bottom face
-		 -extents.x, -extents.y, -extents.z,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, 0.0f, // top-right
-		  extents.x, -extents.y, -extents.z,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, 0.0f, // top-left
-		  extents.x, -extents.y,  extents.z,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, 0.0f, // bottom-left
-		  extents.x, -extents.y,  extents.z,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, 0.0f, // bottom-left
-		 -extents.x, -extents.y,  extents.z,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, 0.0f, // bottom-right
-		 -extents.x, -extents.y, -extents.z,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, 0.0f, // top-right
-		 // top face
-		 -extents.x,  extents.y, -extents.z,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, 0.0f, // top-left
-		  extents.x,  extents.y , extents.z,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, 0.0f, // bottom-right
-		  extents.x,  extents.y, -extents.z,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, 0.0f, // top-right
-		  extents.x,  extents.y,  extents.z,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, 0.0f, // bottom-right
-		 -extents.x,  extents.y, -extents.z,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, 0.0f, // top-left
-		 -extents.x,  extents.y,  extents.z,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f, 0.0f  // bottom-left
-	};
+    // The table is a cube from -1 to 1, so scaling its positions by extents gives one from -extents to extents
+    Geometry::VertexData cube_vertices[GEOMETRY_CUBE_VERTEX_COUNT];
+    for (uint32_t index = 0; index < GEOMETRY_CUBE_VERTEX_COUNT; index++) {
+        const vec3& position = GEOMETRY_CUBE_VERTICES[index].position;
+        cube_vertices[index] = GEOMETRY_CUBE_VERTICES[index];
+        cube_vertices[index].position = vec3(position.x * extents.x, position.y * extents.y, position.z * extents.z);
+    }
 
     Geometry geometry;
     glGenVertexArrays(1, &geometry.vao);
@@ -55,6 +78,7 @@ siren::Geometry siren::geometry_create_cube(vec3 extents) {
     glGenBuffers(1, &geometry.vbo);
     glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), &cube_vertices[0], GL_STATIC_DRAW);
+    memory_track_alloc(MEMORY_TAG_GEOMETRY, MEMORY_KIND_VERTEX_BUFFER, NULL, sizeof(cube_vertices));
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(vec3), (void*)offsetof(Geometry::VertexData, position));
@@ -63,7 +87,7 @@ siren::Geometry siren::geometry_create_cube(vec3 extents) {
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(vec3), (void*)offsetof(Geometry::VertexData, tex_coord));
 
-    geometry.vertex_count = 36;
+    geometry.vertex_count = GEOMETRY_CUBE_VERTEX_COUNT;
     geometry.material_albedo = 0;
 
     return geometry;
@@ -21,5 +21,9 @@ namespace siren {
         Texture material_albedo;
     };
 
+    static const uint32_t GEOMETRY_CUBE_VERTEX_COUNT = 36;
+    // A cube from -1 to 1 on every axis as a triangle list, built at compile time
+    extern const Geometry::VertexData GEOMETRY_CUBE_VERTICES[GEOMETRY_CUBE_VERTEX_COUNT];
+
     Geometry geometry_create_cube(vec3 extents);
 }
\ No newline at end of file
@@ -0,0 +1,155 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_RENDERER
+
+#include "gpu_timer.h"
+
+#include "core/logger.h"
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+static const uint32_t GPU_TIMER_FRAME_COUNT = 2;
+static const uint32_t GPU_TIMER_MAX_QUERIES = 64;
+
+// One set of queries per frame in flight, so that reading back last frame's results never waits on the GPU
+struct GpuTimerFrame {
+    GLuint queries[GPU_TIMER_MAX_QUERIES];
+    siren::GpuTimerStage query_stages[GPU_TIMER_MAX_QUERIES];
+    uint32_t query_count;
+};
+
+struct GpuTimerState {
+    bool is_supported;
+    GpuTimerFrame frames[GPU_TIMER_FRAME_COUNT];
+    uint32_t frame_index;
+    siren::GpuTimerStage current_stage;
+    bool is_query_open;
+    bool warned_out_of_queries;
+
+    siren::GpuTimings timings;
+};
+
+static bool initialized = false;
+static GpuTimerState state;
+
+void siren::gpu_timer_init() {
+    if (initialized) {
+        return;
+    }
+
+    memset(&state, 0, sizeof(state));
+
+    GLint counter_bits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &counter_bits);
+    state.is_supported = counter_bits != 0;
+    if (!state.is_supported) {
+        SIREN_WARN("GL_TIME_ELAPSED queries are not supported. GPU timings will not be available.");
+        initialized = true;
+        return;
+    }
+
+    for (uint32_t frame = 0; frame < GPU_TIMER_FRAME_COUNT; frame++) {
+        glGenQueries(GPU_TIMER_MAX_QUERIES, state.frames[frame].queries);
+    }
+    state.current_stage = GPU_TIMER_STAGE_NONE;
+
+    initialized = true;
+}
+
+void siren::gpu_timer_quit() {
+    if (!initialized) {
+        return;
+    }
+
+    if (state.is_supported) {
+        for (uint32_t frame = 0; frame < GPU_TIMER_FRAME_COUNT; frame++) {
+            glDeleteQueries(GPU_TIMER_MAX_QUERIES, state.frames[frame].queries);
+        }
+    }
+
+    initialized = false;
+}
+
+void siren::gpu_timer_frame_begin() {
+    if (!initialized || !state.is_supported) {
+        return;
+    }
+
+    // Advance to the oldest frame and collect its results before its queries are reused
+    state.frame_index = (state.frame_index + 1) % GPU_TIMER_FRAME_COUNT;
+    GpuTimerFrame& frame = state.frames[state.frame_index];
+
+    if (frame.query_count != 0) {
+        // Queries complete in order, so if the last one is ready they all are
+        GLint is_available = 0;
+        glGetQueryObjectiv(frame.queries[frame.query_count - 1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+        if (is_available) {
+            float stage_times[GPU_TIMER_STAGE_COUNT];
+            memset(stage_times, 0, sizeof(stage_times));
+            for (uint32_t query = 0; query < frame.query_count; query++) {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(frame.queries[query], GL_QUERY_RESULT, &elapsed);
+                stage_times[frame.query_stages[query]] += (float)((double)elapsed / 1000000.0);
+            }
+
+            state.timings = (GpuTimings) {
+                .scene = stage_times[GPU_TIMER_STAGE_SCENE],
+                .models = stage_times[GPU_TIMER_STAGE_MODELS],
+                .geometry = stage_times[GPU_TIMER_STAGE_GEOMETRY],
+                .text = stage_times[GPU_TIMER_STAGE_TEXT],
+                .resolve = stage_times[GPU_TIMER_STAGE_RESOLVE],
+                .screen = stage_times[GPU_TIMER_STAGE_SCREEN],
+                .total = 0.0f
+            };
+            for (uint32_t stage = 0; stage < GPU_TIMER_STAGE_COUNT; stage++) {
+                state.timings.total += stage_times[stage];
+            }
+        }
+    }
+
+    frame.query_count = 0;
+    state.current_stage = GPU_TIMER_STAGE_NONE;
+    state.is_query_open = false;
+}
+
+void siren::gpu_timer_frame_end() {
+    gpu_timer_set_stage(GPU_TIMER_STAGE_NONE);
+}
+
+void siren::gpu_timer_set_stage(siren::GpuTimerStage stage) {
+    if (!initialized || !state.is_supported || stage == state.current_stage) {
+        return;
+    }
+
+    // Time elapsed queries can't nest, so close the current one before starting the next
+    if (state.is_query_open) {
+        glEndQuery(GL_TIME_ELAPSED);
+        state.is_query_open = false;
+    }
+    state.current_stage = stage;
+    if (stage == GPU_TIMER_STAGE_NONE) {
+        return;
+    }
+
+    GpuTimerFrame& frame = state.frames[state.frame_index];
+    if (frame.query_count == GPU_TIMER_MAX_QUERIES) {
+        if (!state.warned_out_of_queries) {
+            SIREN_WARN("Ran out of GPU timer queries for this frame. Later stages will not be timed.");
+            state.warned_out_of_queries = true;
+        }
+        return;
+    }
+
+    frame.query_stages[frame.query_count] = stage;
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.query_count]);
+    frame.query_count++;
+    state.is_query_open = true;
+}
+
+bool siren::gpu_timer_is_supported() {
+    return initialized && state.is_supported;
+}
+
+siren::GpuTimings siren::gpu_timer_get_timings() {
+    return state.timings;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "defines.h"
+
+namespace siren {
+    // GPU time spent in each renderer stage, in milliseconds. These lag the current frame by one frame.
+    struct GpuTimings {
+        // The clear started in renderer_prepare_frame plus any draws that aren't models, geometry or text
+        float scene;
+        float models;
+        float geometry;
+        float text;
+        // The multisample resolve blit in renderer_present_frame
+        float resolve;
+        // Drawing the resolved frame to the window
+        float screen;
+        float total;
+    };
+
+    enum GpuTimerStage {
+        GPU_TIMER_STAGE_NONE,
+        GPU_TIMER_STAGE_SCENE,
+        GPU_TIMER_STAGE_MODELS,
+        GPU_TIMER_STAGE_GEOMETRY,
+        GPU_TIMER_STAGE_TEXT,
+        GPU_TIMER_STAGE_RESOLVE,
+        GPU_TIMER_STAGE_SCREEN,
+        GPU_TIMER_STAGE_COUNT
+    };
+
+    void gpu_timer_init();
+    void gpu_timer_quit();
+    void gpu_timer_frame_begin();
+    void gpu_timer_frame_end();
+    /*
+     * Attributes all GPU work from now until the next stage change to the given stage.
+     * Consecutive calls with the same stage share a single query.
+     */
+    void gpu_timer_set_stage(GpuTimerStage stage);
+    bool gpu_timer_is_supported();
+    GpuTimings gpu_timer_get_timings();
+}
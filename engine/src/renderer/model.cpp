@@ -1,8 +1,17 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_MODEL
+
 #include "model.h"
 
 #include "core/logger.h"
 #include "core/resource.h"
 #include "core/asserts.h"
+#include "core/profiler.h"
+#include "core/arena.h"
+#include "core/memory.h"
+#include "core/job.h"
+#include "core/asset.h"
+#include "core/slot_map.h"
+#include "renderer/renderer.h"
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -15,42 +24,328 @@
 #include <unordered_map>
 #include <fstream>
 
-static std::vector<siren::Model> models;
+struct ModelSlot {
+    siren::Model model;
+    std::string path;
+    // Set while an async load doesn't have its meshes yet
+    bool is_pending;
+};
+
+// The render thread looks models up while the main thread adds them, which the slot map's fixed pages allow
+static siren::SlotMap<ModelSlot> models;
 static std::unordered_map<std::string, siren::ModelHandle> model_handles;
+// Returned for handles that don't resolve
+static const siren::Model MODEL_EMPTY = siren::Model();
+
+struct ModelVertexData {
+    siren::vec3 position;
+    siren::vec3 normal;
+    siren::vec2 tex_coord;
+    int bone_ids[4];
+    float bone_weights[4];
+};
+
+enum ModelMaterialSlot {
+    MODEL_MATERIAL_ALBEDO,
+    MODEL_MATERIAL_METALLIC_ROUGHNESS,
+    MODEL_MATERIAL_NORMAL,
+    MODEL_MATERIAL_EMISSIVE,
+    MODEL_MATERIAL_OCCLUSION,
+    MODEL_MATERIAL_SLOT_COUNT
+};
+
+// A material slot is either an image embedded in the glb, or a solid color when the material doesn't have one
+struct ModelMaterialSource {
+    int image_index;
+    uint8_t color[4];
+};
+
+struct ModelImageSource {
+    const uint8_t* pixels;
+    int width;
+    int height;
+    int component;
+    int bits;
+};
+
+/*
+ * Sources point at data owned by the load. That's either the vertices built while decoding plus the glb's own buffers,
+ * or the cooked cache file, which stays mapped until the upload is finished.
+ */
+struct ModelMeshSource {
+    std::vector<ModelVertexData> vertex_storage;
+    const ModelVertexData* vertices;
+    uint32_t vertex_count;
+    const uint8_t* indices;
+    uint32_t index_size;
+    uint32_t index_count;
+    uint32_t index_offset;
+    int index_component_type;
+    ModelMaterialSource materials[MODEL_MATERIAL_SLOT_COUNT];
+};
+
+/*
+ * Cooked models are cached as <cache path>/<source hash>.smesh, so an edited glb gets a new file rather than a stale one.
+ * The file is a ModelCacheHeader followed by sections aligned to MODEL_CACHE_ALIGNMENT. Every offset is from the start
+ * of the file. Vertices and keyframes are stored as their in-memory structs, so MODEL_CACHE_VERSION must change whenever
+ * those layouts or the way models are decoded does.
+ */
+static const char MODEL_CACHE_MAGIC[4] = { 'S', 'M', 'S', 'H' };
+static const uint32_t MODEL_CACHE_VERSION = 4;
+static const uint64_t MODEL_CACHE_ALIGNMENT = 16;
+static const size_t MODEL_CACHE_PATH_LENGTH = 1024;
+
+struct ModelCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint32_t mesh_count;
+    uint32_t image_count;
+    uint32_t bone_count;
+    uint32_t animation_count;
+    uint64_t meshes_offset;
+    uint64_t images_offset;
+    uint64_t bones_offset;
+    uint64_t animations_offset;
+};
+
+struct ModelCacheMesh {
+    uint64_t vertices_offset;
+    uint64_t indices_offset;
+    uint32_t vertex_count;
+    uint32_t index_size;
+    uint32_t index_count;
+    uint32_t index_offset;
+    int32_t index_component_type;
+    ModelMaterialSource materials[MODEL_MATERIAL_SLOT_COUNT];
+};
+
+struct ModelCacheImage {
+    uint64_t pixels_offset;
+    int32_t width;
+    int32_t height;
+    int32_t component;
+    int32_t bits;
+};
+
+struct ModelCacheBone {
+    int32_t parent_id;
+    uint32_t keyframes_count;
+    // keyframes_count ModelCacheKeyframes, one per animation
+    uint64_t keyframes_offset;
+    siren::affine3x4 transform;
+    siren::affine3x4 inverse_bind_transform;
+};
+
+struct ModelCacheKeyframes {
+    uint64_t positions_offset;
+    uint64_t rotations_offset;
+    uint64_t scales_offset;
+    uint32_t position_count;
+    uint32_t rotation_count;
+    uint32_t scale_count;
+    uint32_t reserved;
+};
+
+struct ModelCacheAnimation {
+    uint64_t name_offset;
+    uint32_t name_length;
+    float duration;
+};
+
+/*
+ * A model is loaded in three steps. Decoding reads the glb and builds vertex, bone and animation data without touching GL,
+ * so it can run on any thread. Uploading creates the GL objects one mesh at a time on whichever thread owns the context.
+ * Resolving materials shares solid color textures with the rest of the engine, so it runs on the main thread.
+ */
+struct ModelLoad {
+    std::string path;
+    siren::ModelHandle handle;
+    bool is_decoded;
+    tinygltf::Model gltf_model;
+    // Mapped when the model came from the cache, otherwise data is NULL
+    siren::ResourceFile cache_file;
+    std::vector<ModelMeshSource> meshes;
+    std::vector<ModelImageSource> images;
+    siren::Model model;
+};
 
 bool model_load(siren::Model* model, std::string path);
+bool model_decode(ModelLoad* load);
+bool model_decode_gltf(ModelLoad* load, const siren::ResourceFile& file);
+bool model_cache_read(ModelLoad* load, const char* cache_path, uint64_t source_hash, uint64_t source_size);
+bool model_cache_write(const ModelLoad* load, const char* cache_path, uint64_t source_hash, uint64_t source_size);
+bool model_upload_next_mesh(ModelLoad* load);
+void model_resolve_materials(ModelLoad* load);
+size_t model_get_cpu_size(const siren::Model& model);
+
+// Slots are inserted before loading, so that a full slot map fails before any work is done
+siren::ModelHandle model_insert(const std::string& path, bool is_pending) {
+    ModelSlot slot;
+    slot.path = path;
+    slot.is_pending = is_pending;
+    siren::ModelHandle handle = siren::slot_map_insert(&models, std::move(slot));
+    if (handle == siren::MODEL_HANDLE_NULL) {
+        SIREN_ERROR("Unable to load model %s, %u models are already loaded.", path.c_str(), siren::SLOT_MAP_MAX_SLOTS);
+    }
+    return handle;
+}
+
+uint64_t model_get_gpu_size(const siren::Model& model) {
+    uint64_t size = 0;
+    for (const siren::Model::Mesh& mesh : model.meshes) {
+        size += mesh.vertex_buffer_size + mesh.index_buffer_size;
+    }
+    for (const siren::Model::EmbeddedTexture& embedded_texture : model.embedded_textures) {
+        size += siren::texture_get_memory_size(GL_RGBA, embedded_texture.size, 1, 1, 1);
+    }
+    return size;
+}
+
+void model_set_resident(siren::ModelHandle handle, const siren::Model& model) {
+    siren::asset_set_resident(siren::ASSET_TYPE_MODEL, handle, model_get_gpu_size(model), model_get_cpu_size(model));
+}
 
 siren::ModelHandle siren::model_acquire(const char* path) {
     std::string key = std::string(path);
     auto it = model_handles.find(key);
     if (it != model_handles.end()) {
+        asset_reference(ASSET_TYPE_MODEL, it->second);
         return it->second;
     }
 
-    Model model;
-    if (!model_load(&model, resource_get_base_path() + path)) {
-        return RESOURCE_HANDLE_NULL;
+    ModelHandle handle = model_insert(key, false);
+    if (handle == MODEL_HANDLE_NULL) {
+        return MODEL_HANDLE_NULL;
+    }
+    ModelSlot* slot = slot_map_get(&models, handle);
+    if (!model_load(&slot->model, key)) {
+        slot_map_remove(&models, handle);
+        return MODEL_HANDLE_NULL;
     }
 
-    models.push_back(model);
-    ModelHandle handle = models.size() - 1;
     model_handles[key] = handle;
+    model_set_resident(handle, slot->model);
+    asset_reference(ASSET_TYPE_MODEL, handle);
     return handle;
 }
 
+void siren::model_release(siren::ModelHandle handle) {
+    if (slot_map_get(&models, handle) == NULL) {
+        return;
+    }
+    asset_unreference(ASSET_TYPE_MODEL, handle);
+}
+
+void siren::model_evict(uint32_t handle) {
+    ModelSlot* slot = slot_map_get(&models, handle);
+    if (slot == NULL) {
+        return;
+    }
+    const Model& model = slot->model;
+    const char* path = slot->path.c_str();
+    memory_track_free(MEMORY_TAG_MODEL, MEMORY_KIND_CPU, path, model_get_cpu_size(model));
+    for (const Model::Mesh& mesh : model.meshes) {
+        glDeleteVertexArrays(1, &mesh.vao);
+        glDeleteBuffers(1, &mesh.vbo);
+        glDeleteBuffers(1, &mesh.ebo);
+        memory_track_free(MEMORY_TAG_MODEL, MEMORY_KIND_VERTEX_BUFFER, path, mesh.vertex_buffer_size);
+        memory_track_free(MEMORY_TAG_MODEL, MEMORY_KIND_INDEX_BUFFER, path, mesh.index_buffer_size);
+    }
+    // Solid color materials are shared, so only the model's own textures are deleted
+    for (const Model::EmbeddedTexture& embedded_texture : model.embedded_textures) {
+        glDeleteTextures(1, &embedded_texture.texture);
+        texture_track_memory(MEMORY_TAG_MODEL, path, GL_RGBA, embedded_texture.size, 1, 1, 1, true);
+    }
+    SIREN_TRACE("Evicted model %s.", path);
+
+    // The next acquire loads it into a new slot, and this handle stops resolving
+    model_handles.erase(slot->path);
+    slot_map_remove(&models, handle);
+}
+
+bool model_load_upload(void* data) {
+    ModelLoad* load = (ModelLoad*)data;
+    if (!load->is_decoded) {
+        return true;
+    }
+    return model_upload_next_mesh(load);
+}
+
+void model_load_finish(void* data) {
+    ModelLoad* load = (ModelLoad*)data;
+    // Pending models are never evicted, so the slot is still there
+    ModelSlot* slot = siren::slot_map_get(&models, load->handle);
+    if (load->is_decoded) {
+        model_resolve_materials(load);
+        siren::memory_track_alloc(siren::MEMORY_TAG_MODEL, siren::MEMORY_KIND_CPU, load->path.c_str(), model_get_cpu_size(load->model));
+        slot->model = std::move(load->model);
+        slot->is_pending = false;
+        model_set_resident(load->handle, slot->model);
+        SIREN_INFO("Model %s finished loading.", load->path.c_str());
+    } else {
+        // The handle stops resolving, and the next acquire tries again
+        SIREN_ERROR("Model %s failed to load.", load->path.c_str());
+        model_handles.erase(load->path);
+        siren::slot_map_remove(&models, load->handle);
+        siren::asset_forget(siren::ASSET_TYPE_MODEL, load->handle);
+    }
+    siren::resource_close(&load->cache_file);
+    delete load;
+}
+
+void model_load_job(void* data) {
+    ModelLoad* load = (ModelLoad*)data;
+    load->is_decoded = model_decode(load);
+    siren::renderer_queue_upload(model_load_upload, model_load_finish, load);
+}
+
+siren::ModelHandle siren::model_acquire_async(const char* path) {
+    std::string key = std::string(path);
+    auto it = model_handles.find(key);
+    if (it != model_handles.end()) {
+        asset_reference(ASSET_TYPE_MODEL, it->second);
+        return it->second;
+    }
+
+    ModelHandle handle = model_insert(key, true);
+    if (handle == MODEL_HANDLE_NULL) {
+        return MODEL_HANDLE_NULL;
+    }
+    model_handles[key] = handle;
+    asset_reference(ASSET_TYPE_MODEL, handle);
+
+    ModelLoad* load = new ModelLoad();
+    load->path = key;
+    load->handle = handle;
+    load->is_decoded = false;
+    load->cache_file = (ResourceFile) { .data = NULL, .size = 0, .storage = NULL };
+    Job job = (Job) {
+        .function = model_load_job,
+        .data = load
+    };
+    job_run(&job, 1, NULL);
+
+    return handle;
+}
+
+bool siren::model_is_ready(siren::ModelHandle handle) {
+    const ModelSlot* slot = slot_map_get(&models, handle);
+    return slot != NULL && !slot->is_pending;
+}
+
 const siren::Model& siren::model_get(siren::ModelHandle handle) {
-    return models[handle];
+    const ModelSlot* slot = slot_map_get(&models, handle);
+    return slot != NULL ? slot->model : MODEL_EMPTY;
 }
 
-uint32_t texture_create_from_glb(const tinygltf::Model& gltf_model, int texture_index) {
-    const tinygltf::Texture& gltf_texture = gltf_model.textures[texture_index];
-    const tinygltf::Image& image = gltf_model.images[gltf_texture.source];
-    SIREN_TRACE("Loading glb texture %s...", image.name.c_str());
+uint32_t texture_create_from_glb(const ModelImageSource& image, const char* asset) {
+    SIREN_TRACE("Loading glb texture %ix%i...", image.width, image.height);
 
     uint32_t texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -70,21 +365,225 @@ uint32_t texture_create_from_glb(const tinygltf::Model& gltf_model, int texture_
         type = GL_UNSIGNED_SHORT;
     } 
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, format, type, &image.image.at(0));
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, format, type, image.pixels);
+    siren::texture_track_memory(siren::MEMORY_TAG_MODEL, asset, GL_RGBA, siren::ivec2(image.width, image.height), 1, 1, 1);
     SIREN_TRACE("Texture loaded successfully.");
 
     return texture;
 }
 
+// Heap memory held by the model's own containers, not counting allocator overhead
+size_t model_get_cpu_size(const siren::Model& model) {
+    size_t size = model.meshes.capacity() * sizeof(siren::Model::Mesh);
+    size += model.bones.capacity() * sizeof(siren::Model::Bone);
+    size += model.bone_parent_ids.capacity() * sizeof(int);
+    for (const siren::Model::Bone& bone : model.bones) {
+        size += bone.keyframes.capacity() * sizeof(siren::Model::Keyframes);
+        for (const siren::Model::Keyframes& keyframes : bone.keyframes) {
+            size += keyframes.positions.capacity() * sizeof(siren::Model::KeyframeVec3);
+            size += keyframes.rotations.capacity() * sizeof(siren::Model::KeyframeQuat);
+            size += keyframes.scales.capacity() * sizeof(siren::Model::KeyframeVec3);
+        }
+    }
+    size += model.embedded_textures.capacity() * sizeof(siren::Model::EmbeddedTexture);
+    size += model.animations.capacity() * sizeof(siren::Model::Animation);
+    for (const siren::Model::Animation& animation : model.animations) {
+        size += animation.name.capacity();
+    }
+    return size;
+}
+
 bool model_load(siren::Model* model, std::string path) {
-    SIREN_INFO("Loading model %s...", path.c_str());
+    SIREN_PROFILE_SCOPE("model_load");
+    ModelLoad load;
+    load.path = path;
+    load.handle = siren::MODEL_HANDLE_NULL;
+    load.cache_file = (siren::ResourceFile) { .data = NULL, .size = 0, .storage = NULL };
+    load.is_decoded = model_decode(&load);
+    if (!load.is_decoded) {
+        return false;
+    }
+
+    {
+        siren::RendererContextScope context_scope;
+        while (!model_upload_next_mesh(&load)) {
+        }
+    }
+    model_resolve_materials(&load);
+    siren::resource_close(&load.cache_file);
+
+    siren::memory_track_alloc(siren::MEMORY_TAG_MODEL, siren::MEMORY_KIND_CPU, path.c_str(), model_get_cpu_size(load.model));
+    *model = std::move(load.model);
+
+    SIREN_INFO("glb loaded successfully.");
+    return true;
+}
+
+// Materials refer to images rather than glTF textures, since the cache has no textures
+ModelMaterialSource model_material_texture(const tinygltf::Model& gltf_model, int texture_index) {
+    return (ModelMaterialSource) {
+        .image_index = gltf_model.textures[texture_index].source,
+        .color = { 0, 0, 0, 0 }
+    };
+}
+
+ModelMaterialSource model_material_color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    return (ModelMaterialSource) {
+        .image_index = -1,
+        .color = { r, g, b, a }
+    };
+}
+
+/*
+ * Bones are composed in array order, so every parent has to come before its children. glTF doesn't promise that for a
+ * skin's joints, so out of order bones are reordered breadth first from the roots and the vertices' bone ids are
+ * remapped to match.
+ */
+void model_sort_bones(ModelLoad* load) {
+    std::vector<siren::Model::Bone>& bones = load->model.bones;
+    bool is_sorted = true;
+    for (uint32_t bone_index = 0; bone_index < bones.size(); bone_index++) {
+        is_sorted = is_sorted && bones[bone_index].parent_id < (int)bone_index;
+    }
+    if (is_sorted) {
+        return;
+    }
+
+    std::vector<std::vector<int>> children(bones.size());
+    std::vector<bool> is_placed(bones.size(), false);
+    std::vector<int> order;
+    for (int bone_index = 0; bone_index < (int)bones.size(); bone_index++) {
+        if (bones[bone_index].parent_id == -1) {
+            order.push_back(bone_index);
+            is_placed[bone_index] = true;
+        } else {
+            children[bones[bone_index].parent_id].push_back(bone_index);
+        }
+    }
+    for (uint32_t order_index = 0; order_index < bones.size(); order_index++) {
+        if (order_index == order.size()) {
+            // Everything left has a loop in its parents, so the first of them is cut off as a root
+            int bone_index = 0;
+            while (is_placed[bone_index]) {
+                bone_index++;
+            }
+            SIREN_WARN("Bone %i of model %s has a loop in its parents, so it's treated as a root.", bone_index, load->path.c_str());
+            bones[bone_index].parent_id = -1;
+            order.push_back(bone_index);
+            is_placed[bone_index] = true;
+        }
+        for (int child : children[order[order_index]]) {
+            if (!is_placed[child]) {
+                order.push_back(child);
+                is_placed[child] = true;
+            }
+        }
+    }
+
+    std::vector<int> new_index(bones.size());
+    for (uint32_t order_index = 0; order_index < order.size(); order_index++) {
+        new_index[order[order_index]] = (int)order_index;
+    }
+
+    std::vector<siren::Model::Bone> sorted_bones(bones.size());
+    for (uint32_t bone_index = 0; bone_index < bones.size(); bone_index++) {
+        siren::Model::Bone& bone = sorted_bones[new_index[bone_index]];
+        bone = std::move(bones[bone_index]);
+        bone.parent_id = bone.parent_id == -1 ? -1 : new_index[bone.parent_id];
+    }
+    bones = std::move(sorted_bones);
+
+    for (ModelMeshSource& mesh : load->meshes) {
+        for (ModelVertexData& vertex : mesh.vertex_storage) {
+            for (uint32_t influence = 0; influence < SIREN_MAX_BONE_INFLUENCE; influence++) {
+                if (vertex.bone_ids[influence] >= 0 && vertex.bone_ids[influence] < (int)bones.size()) {
+                    vertex.bone_ids[influence] = new_index[vertex.bone_ids[influence]];
+                }
+            }
+        }
+    }
+}
+
+void model_pack_bone_parents(siren::Model* model) {
+    model->bone_parent_ids.resize(model->bones.size());
+    for (uint32_t bone_index = 0; bone_index < model->bones.size(); bone_index++) {
+        model->bone_parent_ids[bone_index] = model->bones[bone_index].parent_id;
+    }
+}
+
+bool model_decode(ModelLoad* load) {
+    SIREN_PROFILE_SCOPE("model_decode");
+    SIREN_INFO("Loading model %s...", load->path.c_str());
+
+    siren::ResourceFile file;
+    if (!siren::resource_open(load->path.c_str(), &file)) {
+        return false;
+    }
+
+    // Caches are keyed by the glb's contents, so hashing it is all it takes to know whether one is still good
+    char cache_path[MODEL_CACHE_PATH_LENGTH];
+    uint64_t source_hash = 0;
+    bool is_cache_enabled = siren::resource_get_cache_path() != NULL;
+    if (is_cache_enabled) {
+        source_hash = siren::resource_hash(file.data, file.size);
+        is_cache_enabled = siren::resource_get_cache_file(source_hash, ".smesh", cache_path, sizeof(cache_path));
+    }
+    if (is_cache_enabled && model_cache_read(load, cache_path, source_hash, file.size)) {
+        siren::resource_close(&file);
+        model_pack_bone_parents(&load->model);
+        return true;
+    }
+
+    bool success = model_decode_gltf(load, file);
+    uint64_t source_size = file.size;
+    siren::resource_close(&file);
+    if (success) {
+        model_sort_bones(load);
+        model_pack_bone_parents(&load->model);
+    }
+    if (success && is_cache_enabled) {
+        model_cache_write(load, cache_path, source_hash, source_size);
+    }
+    return success;
+}
+
+siren::CookResult siren::model_cook(const char* path) {
+    SIREN_PROFILE_SCOPE("model_cook");
+    ModelLoad load;
+    load.path = std::string(path);
+    load.handle = MODEL_HANDLE_NULL;
+    load.cache_file = (ResourceFile) { .data = NULL, .size = 0, .storage = NULL };
+
+    ResourceFile file;
+    if (!resource_open(path, &file)) {
+        return COOK_FAILED;
+    }
+    uint64_t source_hash = resource_hash(file.data, file.size);
+    char cache_path[MODEL_CACHE_PATH_LENGTH];
+    if (!resource_get_cache_file(source_hash, ".smesh", cache_path, sizeof(cache_path))) {
+        resource_close(&file);
+        return COOK_FAILED;
+    }
+
+    CookResult result = COOK_UP_TO_DATE;
+    if (!model_cache_read(&load, cache_path, source_hash, file.size)) {
+        bool success = model_decode_gltf(&load, file) && model_cache_write(&load, cache_path, source_hash, file.size);
+        result = success ? COOK_WRITTEN : COOK_FAILED;
+    }
+    resource_close(&load.cache_file);
+    resource_close(&file);
+    return result;
+}
+
+bool model_decode_gltf(ModelLoad* load, const siren::ResourceFile& file) {
+    const std::string& path = load->path;
+    tinygltf::Model& gltf_model = load->gltf_model;
+    siren::Model* model = &load->model;
 
-    // Read the file
     tinygltf::TinyGLTF loader;
     std::string error;
     std::string warning;
-    tinygltf::Model gltf_model;
-    bool success = loader.LoadBinaryFromFile(&gltf_model, &error, &warning, path);
+    bool success = loader.LoadBinaryFromMemory(&gltf_model, &error, &warning, file.data, (unsigned int)file.size);
     if (!warning.empty()) {
         SIREN_WARN("%s", warning.c_str());
     }
@@ -97,6 +596,17 @@ bool model_load(siren::Model* model, std::string path) {
         return false;
     }
 
+    // The decoded images live as long as gltf_model does
+    for (const tinygltf::Image& image : gltf_model.images) {
+        load->images.push_back((ModelImageSource) {
+            .pixels = image.image.empty() ? NULL : image.image.data(),
+            .width = image.width,
+            .height = image.height,
+            .component = image.component,
+            .bits = image.bits
+        });
+    }
+
     // Create meshes
     const tinygltf::Scene& scene = gltf_model.scenes[gltf_model.defaultScene];
     std::vector<int> node_stack;
@@ -128,116 +638,84 @@ bool model_load(siren::Model* model, std::string path) {
             SIREN_TRACE("Setting up the mesh for primitive %u...", primitive_index);
 
             const tinygltf::Primitive& primitive = gltf_mesh.primitives[primitive_index];
-            std::vector<siren::vec3> positions;
-            std::vector<siren::vec3> normals;
-            std::vector<siren::vec2> tex_coords;
-            std::vector<std::vector<uint8_t>> bone_ids;
-            std::vector<std::vector<float>> bone_weights;
+            // Attribute data only lives until the vertices are interleaved, so it goes in scratch memory
+            siren::ScratchScope scratch;
+            uint32_t vertex_count = 0;
+            siren::vec3* positions = NULL;
+            siren::vec3* normals = NULL;
+            siren::vec2* tex_coords = NULL;
+            uint8_t* bone_ids = NULL;
+            float* bone_weights = NULL;
             for (auto& attribute : primitive.attributes) {
                 const tinygltf::Accessor& accessor = gltf_model.accessors[attribute.second];
                 const tinygltf::BufferView& buffer_view = gltf_model.bufferViews[accessor.bufferView];
                 const tinygltf::Buffer& buffer = gltf_model.buffers[buffer_view.buffer];
+                const uint8_t* data = &buffer.data.at(buffer_view.byteOffset + accessor.byteOffset);
 
                 if (attribute.first == "POSITION") {
-                    for (uint32_t i = buffer_view.byteOffset + accessor.byteOffset; i < buffer_view.byteOffset + accessor.byteOffset + (accessor.count * sizeof(siren::vec3)); i += sizeof(siren::vec3)) {
-                        siren::vec3 v;
-                        std::memcpy(&v, &buffer.data.at(i), sizeof(siren::vec3));
-                        positions.push_back(v);
-                    }
+                    vertex_count = accessor.count;
+                    positions = scratch.push_array<siren::vec3>(accessor.count);
+                    std::memcpy(positions, data, accessor.count * sizeof(siren::vec3));
                 } else if (attribute.first == "NORMAL") {
-                    for (uint32_t i = buffer_view.byteOffset + accessor.byteOffset; i < buffer_view.byteOffset + accessor.byteOffset + (accessor.count * sizeof(siren::vec3)); i += sizeof(siren::vec3)) {
-                        siren::vec3 v;
-                        std::memcpy(&v, &buffer.data.at(i), sizeof(siren::vec3));
-                        normals.push_back(v);
-                    }
+                    normals = scratch.push_array<siren::vec3>(accessor.count);
+                    std::memcpy(normals, data, accessor.count * sizeof(siren::vec3));
                 } else if (attribute.first == "TEXCOORD_0") {
-                    for (uint32_t i = buffer_view.byteOffset + accessor.byteOffset; i < buffer_view.byteOffset + accessor.byteOffset + (accessor.count * sizeof(siren::vec2)); i += sizeof(siren::vec2)) {
-                        siren::vec2 v;
-                        std::memcpy(&v, &buffer.data.at(i), sizeof(siren::vec2));
-                        tex_coords.push_back(v);
-                    }
+                    tex_coords = scratch.push_array<siren::vec2>(accessor.count);
+                    std::memcpy(tex_coords, data, accessor.count * sizeof(siren::vec2));
                 } else if (attribute.first == "JOINTS_0") {
-                    for (uint32_t i = buffer_view.byteOffset + accessor.byteOffset; i < buffer_view.byteOffset + accessor.byteOffset + (accessor.count * 4 * sizeof(uint8_t)); i += 4 * sizeof(uint8_t)) {
-                        std::vector<uint8_t> value(4, 0);
-                        std::memcpy(&value[0], &buffer.data.at(i), 4 * sizeof(unsigned char));
-                        bone_ids.push_back(value);
-                    }
+                    bone_ids = scratch.push_array<uint8_t>(accessor.count * 4);
+                    std::memcpy(bone_ids, data, accessor.count * 4 * sizeof(uint8_t));
                 } else if (attribute.first == "WEIGHTS_0") {
-                    for (uint32_t i = buffer_view.byteOffset + accessor.byteOffset; i < buffer_view.byteOffset + accessor.byteOffset + (accessor.count * 4 * sizeof(float)); i += 4 * sizeof(float)) {
-                        std::vector<float> value(4, 0.0f);
-                        std::memcpy(&value[0], &buffer.data.at(i), 4 * sizeof(float));
-                        bone_weights.push_back(value);
-                    }
+                    bone_weights = scratch.push_array<float>(accessor.count * 4);
+                    std::memcpy(bone_weights, data, accessor.count * 4 * sizeof(float));
                 } else {
                     SIREN_WARN("Unhandled vertex array attribute %s. Skipping...", attribute.first.c_str());
                     continue;
                 }
             } // End for each primitive attribute
 
-            siren::Model::Mesh mesh;
-            glGenVertexArrays(1, &mesh.vao);
-            glBindVertexArray(mesh.vao);
-
-            struct VertexData {
-                siren::vec3 position;
-                siren::vec3 normal;
-                siren::vec2 tex_coord;
-                int bone_ids[4];
-                float bone_weights[4];
-            };
-
-
-            std::vector<VertexData> vertex_data;
-            for (uint32_t i = 0; i < positions.size(); i++) {
-                vertex_data.push_back((VertexData) {
+            ModelMeshSource mesh;
+            mesh.vertex_storage.resize(vertex_count);
+            for (uint32_t i = 0; i < vertex_count; i++) {
+                mesh.vertex_storage[i] = (ModelVertexData) {
                     .position = positions[i],
-                    .normal = normals[i],
-                    .tex_coord = tex_coords[i],
+                    .normal = normals != NULL ? normals[i] : siren::vec3(0.0f),
+                    .tex_coord = tex_coords != NULL ? tex_coords[i] : siren::vec2(0.0f),
                     .bone_ids = { -1, -1, -1, -1 },
                     .bone_weights = { 0.0f, 0.0f, 0.0f, 0.0f }
-                });
+                };
                 // Making this check because bone_ids are optional on a model
                 // Note that bone_ids will still be in the vertex data, they will just have -1 values so that they won't be used
-                if (bone_ids.size() != 0) {
+                if (bone_ids != NULL && bone_weights != NULL) {
                     for (uint32_t b = 0; b < 4; b++) {
-                        vertex_data[vertex_data.size() - 1].bone_ids[b] = bone_ids[i][b];
-                        vertex_data[vertex_data.size() - 1].bone_weights[b] = bone_weights[i][b];
+                        mesh.vertex_storage[i].bone_ids[b] = bone_ids[(i * 4) + b];
+                        mesh.vertex_storage[i].bone_weights[b] = bone_weights[(i * 4) + b];
                     }
                 }
             }
-            glGenBuffers(1, &mesh.vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(VertexData) * vertex_data.size(), &vertex_data[0], GL_STATIC_DRAW);
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)0);
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(3 * sizeof(float)));
-            glEnableVertexAttribArray(2);
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)(6 * sizeof(float)));
-            glEnableVertexAttribArray(3);
-            glVertexAttribIPointer(3, 4, GL_INT, sizeof(VertexData), (void*)offsetof(VertexData, bone_ids));
-            glEnableVertexAttribArray(4);
-            glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, bone_weights));
-
-            // Buffer the indices
+
+            // The vector's buffer stays put when the mesh is moved into the load
+            mesh.vertices = mesh.vertex_storage.data();
+            mesh.vertex_count = vertex_count;
+
+            // The whole buffer view is uploaded and drawn from at index_offset, straight out of the glb's buffer
             const tinygltf::Accessor& index_accessor = gltf_model.accessors[primitive.indices];
             const tinygltf::BufferView& index_buffer_view = gltf_model.bufferViews[index_accessor.bufferView];
             const tinygltf::Buffer& index_buffer = gltf_model.buffers[index_buffer_view.buffer];
+            mesh.indices = &index_buffer.data.at(0) + index_buffer_view.byteOffset;
+            mesh.index_size = index_buffer_view.byteLength;
             mesh.index_count = index_accessor.count;
             mesh.index_offset = index_accessor.byteOffset;
             mesh.index_component_type = index_accessor.componentType;
-            glGenBuffers(1, &mesh.ebo);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_view.byteLength, &index_buffer.data.at(0) + index_buffer_view.byteOffset, GL_STATIC_DRAW);
 
             // Setup the siren material
             // Albedo
             const tinygltf::Material& material = gltf_model.materials[primitive.material];
             if (material.pbrMetallicRoughness.baseColorTexture.index != -1) {
-                mesh.material_albedo = texture_create_from_glb(gltf_model, material.pbrMetallicRoughness.baseColorTexture.index);
+                mesh.materials[MODEL_MATERIAL_ALBEDO] = model_material_texture(gltf_model, material.pbrMetallicRoughness.baseColorTexture.index);
             } else {
                 SIREN_ASSERT(material.pbrMetallicRoughness.baseColorFactor.size() != 0);
-                mesh.material_albedo = siren::texture_acquire_solidcolor(
+                mesh.materials[MODEL_MATERIAL_ALBEDO] = model_material_color(
                     (uint8_t)(255.0f * material.pbrMetallicRoughness.baseColorFactor[0]),
                     (uint8_t)(255.0f * material.pbrMetallicRoughness.baseColorFactor[1]),
                     (uint8_t)(255.0f * material.pbrMetallicRoughness.baseColorFactor[2]),
@@ -245,9 +723,9 @@ bool model_load(siren::Model* model, std::string path) {
             } 
             // Metallic / Roughness
             if (material.pbrMetallicRoughness.metallicRoughnessTexture.index != -1) {
-                mesh.material_metallic_roughness = texture_create_from_glb(gltf_model, material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+                mesh.materials[MODEL_MATERIAL_METALLIC_ROUGHNESS] = model_material_texture(gltf_model, material.pbrMetallicRoughness.metallicRoughnessTexture.index);
             } else {
-                mesh.material_metallic_roughness = siren::texture_acquire_solidcolor(
+                mesh.materials[MODEL_MATERIAL_METALLIC_ROUGHNESS] = model_material_color(
                     0,
                     (uint8_t)(255.0f * material.pbrMetallicRoughness.roughnessFactor),
                     (uint8_t)(255.0f * material.pbrMetallicRoughness.metallicFactor),
@@ -256,30 +734,30 @@ bool model_load(siren::Model* model, std::string path) {
             }
             // Normal
             if (material.normalTexture.index != -1) {
-                mesh.material_normal = texture_create_from_glb(gltf_model, material.normalTexture.index);
+                mesh.materials[MODEL_MATERIAL_NORMAL] = model_material_texture(gltf_model, material.normalTexture.index);
             } else {
-                mesh.material_normal = siren::texture_acquire_solidcolor(128, 128, 255, 0);
+                mesh.materials[MODEL_MATERIAL_NORMAL] = model_material_color(128, 128, 255, 0);
             }
             // Emissive
             if (material.emissiveTexture.index != -1) {
-                mesh.material_emissive = texture_create_from_glb(gltf_model, material.emissiveTexture.index);
+                mesh.materials[MODEL_MATERIAL_EMISSIVE] = model_material_texture(gltf_model, material.emissiveTexture.index);
             } else if (material.emissiveFactor.size() != 0) {
-                mesh.material_emissive = siren::texture_acquire_solidcolor(
+                mesh.materials[MODEL_MATERIAL_EMISSIVE] = model_material_color(
                     (uint8_t)(255.0f * material.emissiveFactor[0]),
                     (uint8_t)(255.0f * material.emissiveFactor[1]),
                     (uint8_t)(255.0f * material.emissiveFactor[2]),
                     0);
             } else {
-                mesh.material_emissive = siren::texture_acquire_solidcolor(0, 0, 0, 0);
+                mesh.materials[MODEL_MATERIAL_EMISSIVE] = model_material_color(0, 0, 0, 0);
             }
             // Occlusion
             if (material.occlusionTexture.index != -1) {
-                mesh.material_occlusion = texture_create_from_glb(gltf_model, material.occlusionTexture.index);
+                mesh.materials[MODEL_MATERIAL_OCCLUSION] = model_material_texture(gltf_model, material.occlusionTexture.index);
             } else {
-                mesh.material_occlusion = siren::texture_acquire_solidcolor(255, 0, 0, 0);
+                mesh.materials[MODEL_MATERIAL_OCCLUSION] = model_material_color(255, 0, 0, 0);
             }
 
-            model->meshes.push_back(mesh);
+            load->meshes.push_back(std::move(mesh));
             SIREN_TRACE("Mesh added successfully.");
         } // End for each primitive
 
@@ -315,8 +793,8 @@ bool model_load(siren::Model* model, std::string path) {
                 model->bones.push_back((siren::Model::Bone) {
                     .parent_id = -1,
                     .keyframes = std::vector<siren::Model::Keyframes>(),
-                    .transform = transform.to_mat4(),
-                    .inverse_bind_transform = inverse_bind_transform
+                    .transform = transform.to_affine3x4(),
+                    .inverse_bind_transform = siren::affine3x4::from_mat4(inverse_bind_transform)
                 });
             } // End for each bone index
             // Determine bone parents
@@ -391,12 +869,380 @@ bool model_load(siren::Model* model, std::string path) {
         } // End if node has skin
     } // End while not node stack empty
 
+    return true;
+}
+
+// Returns the offset of data, which is placed at the next aligned offset of the blob
+uint64_t model_cache_append(std::vector<uint8_t>* blob, const void* data, size_t size) {
+    blob->resize((blob->size() + MODEL_CACHE_ALIGNMENT - 1) / MODEL_CACHE_ALIGNMENT * MODEL_CACHE_ALIGNMENT, 0);
+    uint64_t offset = blob->size();
+    blob->insert(blob->end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    return offset;
+}
+
+size_t model_image_size(const ModelImageSource& image) {
+    return (size_t)image.width * (size_t)image.height * (size_t)image.component * (size_t)(image.bits / 8);
+}
+
+bool model_cache_write(const ModelLoad* load, const char* cache_path, uint64_t source_hash, uint64_t source_size) {
+    SIREN_PROFILE_SCOPE("model_cache_write");
+    const siren::Model& model = load->model;
+    // The header is filled in last, once the section offsets are known
+    std::vector<uint8_t> blob(sizeof(ModelCacheHeader), 0);
+
+    // Records are zeroed first so that padding doesn't make identical models cook to different files
+    std::vector<ModelCacheMesh> meshes(load->meshes.size());
+    memset(meshes.data(), 0, meshes.size() * sizeof(ModelCacheMesh));
+    for (uint32_t mesh_index = 0; mesh_index < load->meshes.size(); mesh_index++) {
+        const ModelMeshSource& source = load->meshes[mesh_index];
+        ModelCacheMesh& mesh = meshes[mesh_index];
+        mesh.vertices_offset = model_cache_append(&blob, source.vertices, source.vertex_count * sizeof(ModelVertexData));
+        mesh.indices_offset = model_cache_append(&blob, source.indices, source.index_size);
+        mesh.vertex_count = source.vertex_count;
+        mesh.index_size = source.index_size;
+        mesh.index_count = source.index_count;
+        mesh.index_offset = source.index_offset;
+        mesh.index_component_type = source.index_component_type;
+        memcpy(mesh.materials, source.materials, sizeof(mesh.materials));
+    }
+
+    std::vector<ModelCacheImage> images(load->images.size());
+    memset(images.data(), 0, images.size() * sizeof(ModelCacheImage));
+    for (uint32_t image_index = 0; image_index < load->images.size(); image_index++) {
+        const ModelImageSource& source = load->images[image_index];
+        images[image_index] = (ModelCacheImage) {
+            .pixels_offset = source.pixels != NULL ? model_cache_append(&blob, source.pixels, model_image_size(source)) : 0,
+            .width = source.width,
+            .height = source.height,
+            .component = source.component,
+            .bits = source.bits
+        };
+    }
+
+    std::vector<ModelCacheBone> bones(model.bones.size());
+    memset((void*)bones.data(), 0, bones.size() * sizeof(ModelCacheBone));
+    std::vector<ModelCacheKeyframes> keyframes;
+    for (uint32_t bone_index = 0; bone_index < model.bones.size(); bone_index++) {
+        const siren::Model::Bone& bone = model.bones[bone_index];
+        keyframes.resize(bone.keyframes.size());
+        memset(keyframes.data(), 0, keyframes.size() * sizeof(ModelCacheKeyframes));
+        for (uint32_t animation_index = 0; animation_index < bone.keyframes.size(); animation_index++) {
+            const siren::Model::Keyframes& source = bone.keyframes[animation_index];
+            keyframes[animation_index].positions_offset = model_cache_append(&blob, source.positions.data(), source.positions.size() * sizeof(siren::Model::KeyframeVec3));
+            keyframes[animation_index].rotations_offset = model_cache_append(&blob, source.rotations.data(), source.rotations.size() * sizeof(siren::Model::KeyframeQuat));
+            keyframes[animation_index].scales_offset = model_cache_append(&blob, source.scales.data(), source.scales.size() * sizeof(siren::Model::KeyframeVec3));
+            keyframes[animation_index].position_count = (uint32_t)source.positions.size();
+            keyframes[animation_index].rotation_count = (uint32_t)source.rotations.size();
+            keyframes[animation_index].scale_count = (uint32_t)source.scales.size();
+        }
+        bones[bone_index].parent_id = bone.parent_id;
+        bones[bone_index].keyframes_count = (uint32_t)bone.keyframes.size();
+        bones[bone_index].keyframes_offset = model_cache_append(&blob, keyframes.data(), keyframes.size() * sizeof(ModelCacheKeyframes));
+        bones[bone_index].transform = bone.transform;
+        bones[bone_index].inverse_bind_transform = bone.inverse_bind_transform;
+    }
+
+    std::vector<ModelCacheAnimation> animations(model.animations.size());
+    memset(animations.data(), 0, animations.size() * sizeof(ModelCacheAnimation));
+    for (uint32_t animation_index = 0; animation_index < model.animations.size(); animation_index++) {
+        const siren::Model::Animation& animation = model.animations[animation_index];
+        animations[animation_index].name_offset = model_cache_append(&blob, animation.name.data(), animation.name.size());
+        animations[animation_index].name_length = (uint32_t)animation.name.size();
+        animations[animation_index].duration = animation.duration;
+    }
+
+    ModelCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MODEL_CACHE_VERSION;
+    header.source_hash = source_hash;
+    header.source_size = source_size;
+    header.mesh_count = (uint32_t)meshes.size();
+    header.image_count = (uint32_t)images.size();
+    header.bone_count = (uint32_t)bones.size();
+    header.animation_count = (uint32_t)animations.size();
+    header.meshes_offset = model_cache_append(&blob, meshes.data(), meshes.size() * sizeof(ModelCacheMesh));
+    header.images_offset = model_cache_append(&blob, images.data(), images.size() * sizeof(ModelCacheImage));
+    header.bones_offset = model_cache_append(&blob, bones.data(), bones.size() * sizeof(ModelCacheBone));
+    header.animations_offset = model_cache_append(&blob, animations.data(), animations.size() * sizeof(ModelCacheAnimation));
+    memcpy(blob.data(), &header, sizeof(header));
+
+    if (!siren::resource_write_file(cache_path, blob.data(), blob.size())) {
+        return false;
+    }
+    SIREN_TRACE("Cached model %s as %s", load->path.c_str(), cache_path);
+    return true;
+}
+
+// Returns a pointer to count elements at offset, or NULL if they run past the end of the file
+const uint8_t* model_cache_section(const siren::ResourceFile& file, uint64_t offset, uint64_t count, size_t element_size) {
+    if (offset > file.size || (file.size - offset) / element_size < count) {
+        return NULL;
+    }
+    return file.data + offset;
+}
+
+// Bytes per index for the index types glTF allows, or 0 for anything else
+uint32_t model_index_element_size(int component_type) {
+    switch (component_type) {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return 1;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            return 2;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+bool model_cache_reject(ModelLoad* load, const char* cache_path) {
+    SIREN_WARN("Model cache %s is corrupt, importing %s again", cache_path, load->path.c_str());
+    load->meshes.clear();
+    load->images.clear();
+    load->model = siren::Model();
+    siren::resource_close(&load->cache_file);
+    return false;
+}
+
+/*
+ * Vertices, indices and pixels are left in the mapping and uploaded straight from it, which is why the cache file is
+ * kept open until the load finishes. Bones and keyframes are copied into the model, since they outlive the load.
+ */
+bool model_cache_read(ModelLoad* load, const char* cache_path, uint64_t source_hash, uint64_t source_size) {
+    SIREN_PROFILE_SCOPE("model_cache_read");
+    siren::ResourceFile& file = load->cache_file;
+    if (!siren::resource_open_file(cache_path, &file)) {
+        return false;
+    }
+
+    ModelCacheHeader header;
+    if (file.size < sizeof(header)) {
+        return model_cache_reject(load, cache_path);
+    }
+    memcpy(&header, file.data, sizeof(header));
+    // A hash collision would also need the same size to slip through
+    if (memcmp(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MODEL_CACHE_VERSION ||
+            header.source_hash != source_hash || header.source_size != source_size) {
+        SIREN_TRACE("Model cache %s is out of date", cache_path);
+        siren::resource_close(&file);
+        return false;
+    }
+
+    const uint8_t* meshes = model_cache_section(file, header.meshes_offset, header.mesh_count, sizeof(ModelCacheMesh));
+    const uint8_t* images = model_cache_section(file, header.images_offset, header.image_count, sizeof(ModelCacheImage));
+    const uint8_t* bones = model_cache_section(file, header.bones_offset, header.bone_count, sizeof(ModelCacheBone));
+    const uint8_t* animations = model_cache_section(file, header.animations_offset, header.animation_count, sizeof(ModelCacheAnimation));
+    if (meshes == NULL || images == NULL || bones == NULL || animations == NULL) {
+        return model_cache_reject(load, cache_path);
+    }
+
+    for (uint32_t image_index = 0; image_index < header.image_count; image_index++) {
+        ModelCacheImage image;
+        memcpy(&image, images + image_index * sizeof(ModelCacheImage), sizeof(image));
+        ModelImageSource source = (ModelImageSource) {
+            .pixels = NULL,
+            .width = image.width,
+            .height = image.height,
+            .component = image.component,
+            .bits = image.bits
+        };
+        if (image.width < 0 || image.height < 0 || image.component < 1 || image.component > 4 || (image.bits != 8 && image.bits != 16)) {
+            return model_cache_reject(load, cache_path);
+        }
+        if (image.pixels_offset != 0) {
+            source.pixels = model_cache_section(file, image.pixels_offset, model_image_size(source), 1);
+            if (source.pixels == NULL) {
+                return model_cache_reject(load, cache_path);
+            }
+        }
+        load->images.push_back(source);
+    }
+
+    for (uint32_t mesh_index = 0; mesh_index < header.mesh_count; mesh_index++) {
+        ModelCacheMesh mesh;
+        memcpy(&mesh, meshes + mesh_index * sizeof(ModelCacheMesh), sizeof(mesh));
+        ModelMeshSource source;
+        source.vertices = (const ModelVertexData*)model_cache_section(file, mesh.vertices_offset, mesh.vertex_count, sizeof(ModelVertexData));
+        source.vertex_count = mesh.vertex_count;
+        source.indices = model_cache_section(file, mesh.indices_offset, mesh.index_size, 1);
+        source.index_size = mesh.index_size;
+        source.index_count = mesh.index_count;
+        source.index_offset = mesh.index_offset;
+        source.index_component_type = mesh.index_component_type;
+        memcpy(source.materials, mesh.materials, sizeof(source.materials));
+        if (source.vertices == NULL || source.indices == NULL) {
+            return model_cache_reject(load, cache_path);
+        }
+        // Draws read index_count indices starting index_offset bytes into the cached indices
+        uint32_t index_element_size = model_index_element_size(source.index_component_type);
+        if (index_element_size == 0 || source.index_offset > source.index_size ||
+                (source.index_size - source.index_offset) / index_element_size < source.index_count) {
+            return model_cache_reject(load, cache_path);
+        }
+        // Unused influences are -1, anything else indexes the bone matrices in the skinning shader
+        for (uint32_t vertex_index = 0; vertex_index < source.vertex_count; vertex_index++) {
+            for (uint32_t influence = 0; influence < SIREN_MAX_BONE_INFLUENCE; influence++) {
+                int bone_id = source.vertices[vertex_index].bone_ids[influence];
+                if (bone_id < -1 || bone_id >= (int)header.bone_count) {
+                    return model_cache_reject(load, cache_path);
+                }
+            }
+        }
+        for (uint32_t slot = 0; slot < MODEL_MATERIAL_SLOT_COUNT; slot++) {
+            if (source.materials[slot].image_index < -1 || source.materials[slot].image_index >= (int)header.image_count) {
+                return model_cache_reject(load, cache_path);
+            }
+        }
+        load->meshes.push_back(std::move(source));
+    }
+
+    siren::Model* model = &load->model;
+    model->bones.resize(header.bone_count);
+    for (uint32_t bone_index = 0; bone_index < header.bone_count; bone_index++) {
+        ModelCacheBone bone;
+        memcpy(&bone, bones + bone_index * sizeof(ModelCacheBone), sizeof(bone));
+        // Animating indexes every bone's keyframes by animation, so they have to line up
+        const uint8_t* keyframes = model_cache_section(file, bone.keyframes_offset, bone.keyframes_count, sizeof(ModelCacheKeyframes));
+        // Bones are cached already sorted, parents first
+        if (keyframes == NULL || bone.keyframes_count != header.animation_count || bone.parent_id < -1 || bone.parent_id >= (int)bone_index) {
+            return model_cache_reject(load, cache_path);
+        }
+
+        siren::Model::Bone& target = model->bones[bone_index];
+        target.parent_id = bone.parent_id;
+        target.transform = bone.transform;
+        target.inverse_bind_transform = bone.inverse_bind_transform;
+        target.keyframes.resize(bone.keyframes_count);
+        for (uint32_t animation_index = 0; animation_index < bone.keyframes_count; animation_index++) {
+            ModelCacheKeyframes source;
+            memcpy(&source, keyframes + animation_index * sizeof(ModelCacheKeyframes), sizeof(source));
+            const uint8_t* positions = model_cache_section(file, source.positions_offset, source.position_count, sizeof(siren::Model::KeyframeVec3));
+            const uint8_t* rotations = model_cache_section(file, source.rotations_offset, source.rotation_count, sizeof(siren::Model::KeyframeQuat));
+            const uint8_t* scales = model_cache_section(file, source.scales_offset, source.scale_count, sizeof(siren::Model::KeyframeVec3));
+            if (positions == NULL || rotations == NULL || scales == NULL) {
+                return model_cache_reject(load, cache_path);
+            }
+            siren::Model::Keyframes& target_keyframes = target.keyframes[animation_index];
+            target_keyframes.positions.resize(source.position_count);
+            target_keyframes.rotations.resize(source.rotation_count);
+            target_keyframes.scales.resize(source.scale_count);
+            memcpy(target_keyframes.positions.data(), positions, source.position_count * sizeof(siren::Model::KeyframeVec3));
+            memcpy(target_keyframes.rotations.data(), rotations, source.rotation_count * sizeof(siren::Model::KeyframeQuat));
+            memcpy(target_keyframes.scales.data(), scales, source.scale_count * sizeof(siren::Model::KeyframeVec3));
+        }
+    }
+
+    for (uint32_t animation_index = 0; animation_index < header.animation_count; animation_index++) {
+        ModelCacheAnimation animation;
+        memcpy(&animation, animations + animation_index * sizeof(ModelCacheAnimation), sizeof(animation));
+        const uint8_t* name = model_cache_section(file, animation.name_offset, animation.name_length, 1);
+        if (name == NULL) {
+            return model_cache_reject(load, cache_path);
+        }
+        model->animations.push_back((siren::Model::Animation) {
+            .name = std::string((const char*)name, animation.name_length),
+            .duration = animation.duration
+        });
+        model->animation_id_lookup[model->animations.back().name] = (int)animation_index;
+    }
+
+    SIREN_TRACE("Loaded model %s from cache %s", load->path.c_str(), cache_path);
+    return true;
+}
+
+void model_mesh_set_material(siren::Model::Mesh* mesh, uint32_t slot, siren::Texture texture) {
+    switch (slot) {
+        case MODEL_MATERIAL_ALBEDO:
+            mesh->material_albedo = texture;
+            break;
+        case MODEL_MATERIAL_METALLIC_ROUGHNESS:
+            mesh->material_metallic_roughness = texture;
+            break;
+        case MODEL_MATERIAL_NORMAL:
+            mesh->material_normal = texture;
+            break;
+        case MODEL_MATERIAL_EMISSIVE:
+            mesh->material_emissive = texture;
+            break;
+        case MODEL_MATERIAL_OCCLUSION:
+            mesh->material_occlusion = texture;
+            break;
+    }
+}
+
+bool model_upload_next_mesh(ModelLoad* load) {
+    if (load->model.meshes.size() == load->meshes.size()) {
+        return true;
+    }
+    SIREN_PROFILE_SCOPE("model_upload_mesh");
+    const ModelMeshSource& source = load->meshes[load->model.meshes.size()];
+    const char* path = load->path.c_str();
+
+    siren::Model::Mesh mesh;
+    glGenVertexArrays(1, &mesh.vao);
+    glBindVertexArray(mesh.vao);
+
+    glGenBuffers(1, &mesh.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    mesh.vertex_buffer_size = sizeof(ModelVertexData) * source.vertex_count;
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertex_buffer_size, source.vertices, GL_STATIC_DRAW);
+    siren::memory_track_alloc(siren::MEMORY_TAG_MODEL, siren::MEMORY_KIND_VERTEX_BUFFER, path, mesh.vertex_buffer_size);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ModelVertexData), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ModelVertexData), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ModelVertexData), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 4, GL_INT, sizeof(ModelVertexData), (void*)offsetof(ModelVertexData, bone_ids));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(ModelVertexData), (void*)offsetof(ModelVertexData, bone_weights));
+
+    // Buffer the indices
+    mesh.index_count = source.index_count;
+    mesh.index_offset = source.index_offset;
+    mesh.index_component_type = source.index_component_type;
+    glGenBuffers(1, &mesh.ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+    mesh.index_buffer_size = source.index_size;
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.index_buffer_size, source.indices, GL_STATIC_DRAW);
+    siren::memory_track_alloc(siren::MEMORY_TAG_MODEL, siren::MEMORY_KIND_INDEX_BUFFER, path, mesh.index_buffer_size);
+
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-    SIREN_INFO("glb loaded successfully.");
-    return true;
+    // Embedded textures are uploaded with the mesh, solid colors are filled in by model_resolve_materials
+    for (uint32_t slot = 0; slot < MODEL_MATERIAL_SLOT_COUNT; slot++) {
+        int image_index = source.materials[slot].image_index;
+        if (image_index == -1) {
+            model_mesh_set_material(&mesh, slot, 0);
+            continue;
+        }
+        const ModelImageSource& image = load->images[image_index];
+        siren::Texture texture = texture_create_from_glb(image, path);
+        load->model.embedded_textures.push_back((siren::Model::EmbeddedTexture) {
+            .texture = texture,
+            .size = siren::ivec2(image.width, image.height)
+        });
+        model_mesh_set_material(&mesh, slot, texture);
+    }
+
+    load->model.meshes.push_back(mesh);
+    return load->model.meshes.size() == load->meshes.size();
+}
+
+void model_resolve_materials(ModelLoad* load) {
+    for (uint32_t mesh_index = 0; mesh_index < load->model.meshes.size(); mesh_index++) {
+        for (uint32_t slot = 0; slot < MODEL_MATERIAL_SLOT_COUNT; slot++) {
+            const ModelMaterialSource& source = load->meshes[mesh_index].materials[slot];
+            if (source.image_index != -1) {
+                continue;
+            }
+            model_mesh_set_material(&load->model.meshes[mesh_index], slot, siren::texture_acquire_solidcolor(source.color[0], source.color[1], source.color[2], source.color[3]));
+        }
+    }
 }
 
 siren::ModelTransform::ModelTransform() {
@@ -406,6 +1252,7 @@ siren::ModelTransform::ModelTransform() {
 siren::ModelTransform::ModelTransform(siren::ModelHandle handle) {
     this->handle = handle;
     root = Transform::identity();
+    previous_root = root;
 
     const Model& model = model_get(handle);
     for (uint32_t bone_index = 0; bone_index < model.bones.size(); bone_index++) {
@@ -418,16 +1265,43 @@ siren::ModelTransform::ModelTransform(siren::ModelHandle handle) {
     animation_playing = false;
 }
 
-const siren::mat4& siren::ModelTransform::get_bone_transform(uint32_t index) const {
+const siren::affine3x4& siren::ModelTransform::get_bone_transform(uint32_t index) const {
+    // The model finished loading after this transform was made and it hasn't been animated since, so use the bind pose
+    if (index >= bone_transform.size()) {
+        return model_get(handle).bones[index].transform;
+    }
     return bone_transform[index];
 }
 
+const siren::affine3x4* siren::ModelTransform::get_bone_transforms() const {
+    if (bone_transform.empty() || bone_transform.size() != model_get(handle).bones.size()) {
+        return NULL;
+    }
+    return bone_transform.data();
+}
+
+void siren::ModelTransform::store_previous_root() {
+    previous_root = root;
+}
+
+siren::Transform siren::ModelTransform::get_interpolated_root(float alpha) const {
+    if (alpha >= 1.0f) {
+        return root;
+    }
+    return Transform::lerp(previous_root, root, alpha);
+}
+
 std::string siren::ModelTransform::get_animation() const {
     const Model& model = model_get(handle);
     return model.animations[animation].name;
 }
 
 void siren::ModelTransform::set_animation(std::string name, bool loop) {
+    if (!model_is_ready(handle)) {
+        SIREN_WARN("called model_transform_set_animation() but the model is still loading.");
+        animation = -1;
+        return;
+    }
     const Model& model = model_get(handle);
 
     auto animation_id_it = model.animation_id_lookup.find(name);
@@ -444,7 +1318,14 @@ void siren::ModelTransform::set_animation(std::string name, bool loop) {
 }
 
 void siren::ModelTransform::update_animation(float delta) {
+    SIREN_PROFILE_SCOPE("ModelTransform::update_animation");
     const Model& model = model_get(handle);
+    if (bone_transform.size() != model.bones.size()) {
+        bone_transform.clear();
+        for (uint32_t bone_index = 0; bone_index < model.bones.size(); bone_index++) {
+            bone_transform.push_back(model.bones[bone_index].transform);
+        }
+    }
 
     if (!animation_playing) {
         return;
@@ -469,17 +1350,24 @@ void siren::ModelTransform::update_animation(float delta) {
         animation_timer -= model.animations[animation].duration;
     }
 
-    // Compute transforms for each bone
-    for (uint32_t bone_index = 0; bone_index < bone_transform.size(); bone_index++) {
+    // Sample each bone's keyframes into one array per component, then build every matrix in one batch
+    uint32_t bone_count = (uint32_t)bone_transform.size();
+    ScratchScope scratch;
+    float* position_x = scratch.push_array<float>(bone_count);
+    float* position_y = scratch.push_array<float>(bone_count);
+    float* position_z = scratch.push_array<float>(bone_count);
+    float* rotation_x = scratch.push_array<float>(bone_count);
+    float* rotation_y = scratch.push_array<float>(bone_count);
+    float* rotation_z = scratch.push_array<float>(bone_count);
+    float* rotation_w = scratch.push_array<float>(bone_count);
+    float* scale_x = scratch.push_array<float>(bone_count);
+    float* scale_y = scratch.push_array<float>(bone_count);
+    float* scale_z = scratch.push_array<float>(bone_count);
+    for (uint32_t bone_index = 0; bone_index < bone_count; bone_index++) {
         const Model::Keyframes& bone_keyframes = model.bones[bone_index].keyframes[animation];
 
-        if (bone_keyframes.positions.size() == 0) {
-            bone_transform[bone_index] = model.bones[bone_index].transform;
-            continue;
-        }
-
         vec3 bone_position;
-        for (uint32_t position_index = 0; position_index < bone_keyframes.positions.size() - 1; position_index++) {
+        for (uint32_t position_index = 0; position_index + 1 < bone_keyframes.positions.size(); position_index++) {
             if (animation_timer < bone_keyframes.positions[position_index + 1].time) {
                 float percent = (animation_timer - bone_keyframes.positions[position_index].time) / (bone_keyframes.positions[position_index + 1].time - bone_keyframes.positions[position_index].time);
                 bone_position = vec3::lerp(bone_keyframes.positions[position_index].value, bone_keyframes.positions[position_index + 1].value, percent);
@@ -488,7 +1376,7 @@ void siren::ModelTransform::update_animation(float delta) {
         }
 
         quat bone_rotation;
-        for (uint32_t rotation_index = 0; rotation_index < bone_keyframes.rotations.size() - 1; rotation_index++) {
+        for (uint32_t rotation_index = 0; rotation_index + 1 < bone_keyframes.rotations.size(); rotation_index++) {
             if (animation_timer < bone_keyframes.rotations[rotation_index + 1].time) {
                 float percent = (animation_timer - bone_keyframes.rotations[rotation_index].time) / (bone_keyframes.rotations[rotation_index + 1].time - bone_keyframes.rotations[rotation_index].time);
                 bone_rotation = quat::slerp(bone_keyframes.rotations[rotation_index].value, bone_keyframes.rotations[rotation_index + 1].value, percent);
@@ -497,7 +1385,7 @@ void siren::ModelTransform::update_animation(float delta) {
         }
 
         vec3 bone_scale;
-        for (uint32_t scale_index = 0; scale_index < bone_keyframes.scales.size() - 1; scale_index++) {
+        for (uint32_t scale_index = 0; scale_index + 1 < bone_keyframes.scales.size(); scale_index++) {
             if (animation_timer < bone_keyframes.scales[scale_index + 1].time) {
                 float percent = (animation_timer - bone_keyframes.scales[scale_index].time) / (bone_keyframes.scales[scale_index + 1].time - bone_keyframes.scales[scale_index].time);
                 bone_scale = vec3::lerp(bone_keyframes.scales[scale_index].value, bone_keyframes.scales[scale_index + 1].value, percent);
@@ -505,10 +1393,36 @@ void siren::ModelTransform::update_animation(float delta) {
             }
         }
 
-        bone_transform[bone_index] = ((Transform) {
-            .position = bone_position,
-            .rotation = bone_rotation,
-            .scale = bone_scale
-        }).to_mat4();
+        position_x[bone_index] = bone_position.x;
+        position_y[bone_index] = bone_position.y;
+        position_z[bone_index] = bone_position.z;
+        rotation_x[bone_index] = bone_rotation.x;
+        rotation_y[bone_index] = bone_rotation.y;
+        rotation_z[bone_index] = bone_rotation.z;
+        rotation_w[bone_index] = bone_rotation.w;
+        scale_x[bone_index] = bone_scale.x;
+        scale_y[bone_index] = bone_scale.y;
+        scale_z[bone_index] = bone_scale.z;
     } // End for each bone
+
+    transform_batch_to_affine3x4((TransformBatch) {
+        .position_x = position_x,
+        .position_y = position_y,
+        .position_z = position_z,
+        .rotation_x = rotation_x,
+        .rotation_y = rotation_y,
+        .rotation_z = rotation_z,
+        .rotation_w = rotation_w,
+        .scale_x = scale_x,
+        .scale_y = scale_y,
+        .scale_z = scale_z,
+        .count = bone_count
+    }, bone_transform.data());
+
+    // Bones the animation doesn't move stay in their bind pose
+    for (uint32_t bone_index = 0; bone_index < bone_count; bone_index++) {
+        if (model.bones[bone_index].keyframes[animation].positions.size() == 0) {
+            bone_transform[bone_index] = model.bones[bone_index].transform;
+        }
+    }
 }
\ No newline at end of file
@@ -10,8 +10,10 @@
 #include "math/vector3.h"
 #include "math/vector4.h"
 #include "math/matrix.h"
+#include "math/affine.h"
 #include "math/transform.h"
 #include "texture.h"
+#include "core/cook.h"
 
 #include <vector>
 #include <unordered_map>
@@ -26,6 +28,8 @@ namespace siren {
             uint32_t index_count;
             uint32_t index_offset;
             int index_component_type;
+            uint32_t vertex_buffer_size;
+            uint32_t index_buffer_size;
 
             Texture material_albedo;
             Texture material_metallic_roughness;
@@ -53,8 +57,8 @@ namespace siren {
         struct Bone {
             int parent_id;
             std::vector<Keyframes> keyframes;
-            mat4 transform;
-            mat4 inverse_bind_transform;
+            affine3x4 transform;
+            affine3x4 inverse_bind_transform;
         };
 
         struct Animation {
@@ -62,17 +66,46 @@ namespace siren {
             float duration;
         };
 
+        // Textures embedded in the glb belong to the model. Solid color materials are shared and aren't listed here.
+        struct EmbeddedTexture {
+            Texture texture;
+            ivec2 size;
+        };
+
         std::vector<Mesh> meshes;
+        std::vector<EmbeddedTexture> embedded_textures;
+        // Sorted so that every bone comes after its parent
         std::vector<Bone> bones;
+        // Each bone's parent_id packed together, for transform_compose_hierarchy
+        std::vector<int> bone_parent_ids;
         std::vector<Animation> animations;
         std::unordered_map<std::string, int> animation_id_lookup;
     };
 
+    // A slot map handle, see slot_map.h. Handles to an evicted model stop resolving rather than aliasing another model.
     typedef uint32_t ModelHandle;
     static const ModelHandle MODEL_HANDLE_NULL = UINT32_MAX;
 
     SIREN_API ModelHandle model_acquire(const char* path);
+    /*
+     * Starts loading a model on a worker thread and returns its handle straight away. It draws nothing until it's ready,
+     * and its meshes are uploaded a few at a time under the renderer's upload budget.
+     */
+    SIREN_API ModelHandle model_acquire_async(const char* path);
+    // False while an async load of the model is still in flight, or if the handle doesn't resolve. A load that failed is ready, with no meshes.
+    SIREN_API bool model_is_ready(ModelHandle handle);
+    /*
+     * Drops a reference taken by model_acquire or model_acquire_async. A model with no references stays loaded until
+     * it's evicted to stay under the memory budgets, see asset.h, after which acquiring it again loads it under a new
+     * handle.
+     */
+    SIREN_API void model_release(ModelHandle handle);
+    // Deletes a model's GL objects and data and frees its slot, called by the asset system
+    void model_evict(uint32_t handle);
+    // A model with no meshes or bones if the handle doesn't resolve
     const Model& model_get(ModelHandle handle);
+    // Writes the cached copy of a glb without loading it, see cook.h. Safe to call from any thread.
+    SIREN_API CookResult model_cook(const char* path);
 
     class ModelTransform {
         public:
@@ -81,16 +114,26 @@ namespace siren {
             SIREN_API ModelTransform();
             SIREN_API ModelTransform(ModelHandle handle);
 
-            SIREN_API const mat4& get_bone_transform(uint32_t index) const;
+            SIREN_API const affine3x4& get_bone_transform(uint32_t index) const;
+            // Every bone's local transform, or NULL until the transform has been updated since its model loaded
+            SIREN_API const affine3x4* get_bone_transforms() const;
 
             SIREN_API std::string get_animation() const;
             SIREN_API void set_animation(std::string name, bool loop = false);
             SIREN_API void update_animation(float delta);
 
+            /*
+             * Saves the root transform as the previous simulation state.
+             * Call this at the start of each update when using a fixed timestep.
+             */
+            SIREN_API void store_previous_root();
+            SIREN_API Transform get_interpolated_root(float alpha) const;
+
             Transform root;
+            Transform previous_root;
         private:
             ModelHandle handle;
-            std::vector<mat4> bone_transform;
+            std::vector<affine3x4> bone_transform;
 
             int animation;
             float animation_timer;
@@ -1,15 +1,93 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_RENDERER
+
 #include "renderer.h"
 
 #include "core/logger.h"
+#include "core/profiler.h"
+#include "core/arena.h"
+#include "core/memory.h"
+#include "core/asset.h"
+#include "core/input.h"
 #include "math/math.h"
 #include "shader.h"
 #include "font.h"
 #include "geometry.h"
+#include "gpu_timer.h"
+#include "texture.h"
 
 #include <SDL2/SDL.h>
 #include <glad/glad.h>
 
 #include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <cstdio>
+
+// Matches the size of the light arrays in the model and geometry shaders
+static const uint32_t RENDERER_MAX_SHADED_LIGHTS = 4;
+// Distinct cameras that can be used in one frame, each gets a slot in the FrameData uniform buffer
+static const uint32_t RENDERER_MAX_CAMERAS = 16;
+static const uint32_t RENDERER_FRAME_DATA_BINDING = 0;
+static const uint32_t RENDERER_LATE_LATCH_MAX_EVENTS = 256;
+static const float RENDERER_DEFAULT_UPLOAD_BUDGET = 0.002f;
+// Texture names kept ready for each target, so that starting an async load doesn't have to borrow the GL context
+static const uint32_t RENDERER_RESERVED_TEXTURE_COUNT = 8;
+
+enum RenderCommandType {
+    RENDER_COMMAND_BEGIN_FRAME,
+    RENDER_COMMAND_TEXT,
+    RENDER_COMMAND_TEXTURE,
+    RENDER_COMMAND_SET_LIGHTS,
+    RENDER_COMMAND_LIGHT,
+    RENDER_COMMAND_MODEL,
+    RENDER_COMMAND_GEOMETRY
+};
+
+// Everything a draw needs, captured when it's recorded so that replaying it never touches game state
+struct RenderCommand {
+    RenderCommandType type = RENDER_COMMAND_BEGIN_FRAME;
+    // Font, texture or model
+    uint32_t handle = 0;
+    // Text, bone matrices or lights stored in the list's data
+    uint32_t data_offset = 0;
+    uint32_t data_count = 0;
+    siren::ivec2 position = siren::ivec2();
+    siren::vec3 color = siren::vec3();
+    // Index into the list's cameras
+    uint32_t camera_index = 0;
+    siren::mat4 model = siren::mat4(1.0f);
+};
+
+// Matches the std140 layout of the FrameData block in the shaders
+struct RenderFrameData {
+    siren::mat4 view;
+    float view_position[4];
+};
+
+struct RenderCamera {
+    const siren::Camera* source;
+    siren::Camera camera;
+    // The view when the draws were recorded, and the one actually used after late latching
+    siren::mat4 recorded_view;
+    siren::mat4 view;
+};
+
+struct RenderCommandList {
+    std::vector<RenderCommand> commands;
+    std::vector<uint8_t> data;
+    std::vector<RenderCamera> cameras;
+};
+
+struct RenderUpload {
+    siren::RendererUploadFunction upload;
+    siren::RendererUploadFinishFunction finish;
+    void* data;
+};
 
 struct RendererState {
     SDL_Window* window;
@@ -17,6 +95,9 @@ struct RendererState {
 
     siren::ivec2 screen_size;
     siren::ivec2 window_size;
+    bool headless;
+    GLsync headless_frame_fences[2];
+    uint32_t headless_frame_index;
 
     GLuint screen_framebuffer;
     GLuint screen_texture;
@@ -33,18 +114,47 @@ struct RendererState {
     siren::Shader geometry_shader;
     siren::Shader light_shader;
 
-    siren::vec3 light_position;
+    std::vector<siren::Light> lights;
     siren::Geometry geometry;
+
+    // One list is recorded by the game while the other is replayed. Without a render thread they are replayed at present.
+    RenderCommandList command_lists[2];
+    uint32_t record_list_index;
+    uint32_t submitted_list_index;
+    siren::GpuTimings gpu_timings;
+
+    GLuint frame_data_buffer;
+    uint32_t frame_data_stride;
+    uint32_t bound_camera_index;
+    bool warned_out_of_cameras;
+
+    // Queued by any thread, run by the context owner, and finished by the main thread
+    std::mutex upload_mutex;
+    std::deque<RenderUpload> uploads;
+    std::vector<RenderUpload> finished_uploads;
+    float upload_budget;
+    std::vector<GLuint> reserved_textures;
+    std::vector<GLuint> reserved_texture_arrays;
+
+    bool threaded;
+    std::thread thread;
+    std::mutex thread_mutex;
+    std::condition_variable thread_condition;
+    bool is_thread_running;
+    bool is_thread_quitting;
+    bool is_frame_submitted;
+    bool is_context_requested;
+    bool is_context_released;
+    uint32_t context_borrow_depth;
 };
 
 static RendererState state;
 static bool initialized = false;
 
-bool siren::renderer_init(RendererConfig config) {
-    if (initialized) {
-        return false;
-    }
+void renderer_thread_main();
+void renderer_refill_reserved_textures();
 
+bool renderer_create_window_and_context(const siren::RendererConfig& config) {
     // Set GL version
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 1);
@@ -52,20 +162,66 @@ bool siren::renderer_init(RendererConfig config) {
     SDL_GL_LoadLibrary(NULL);
 
     // Create window
-    state.window = SDL_CreateWindow(config.window_name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, config.window_size.x, config.window_size.y, SDL_WINDOW_OPENGL);
+    Uint32 window_flags = SDL_WINDOW_OPENGL;
+    if (config.headless) {
+        window_flags |= SDL_WINDOW_HIDDEN;
+    }
+    state.window = SDL_CreateWindow(config.window_name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, config.window_size.x, config.window_size.y, window_flags);
     if (state.window == NULL) {
         SIREN_ERROR("Error creating window: %s", SDL_GetError());
         return false;
     }
-    state.screen_size = config.screen_size;
-    state.window_size = config.window_size;
 
     // Create GL context
     state.context = SDL_GL_CreateContext(state.window);
     if (state.context == NULL) {
         SIREN_ERROR("Error creating GL context: %s", SDL_GetError());
+        SDL_DestroyWindow(state.window);
+        state.window = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+bool siren::renderer_init(RendererConfig config) {
+    if (initialized) {
         return false;
     }
+    SIREN_PROFILE_SCOPE("renderer_init");
+
+    if (!renderer_create_window_and_context(config)) {
+        // The offscreen video driver needs EGL, so if that isn't available fall back to a hidden window on the default driver
+        const char* video_driver = SDL_GetCurrentVideoDriver();
+        if (!config.headless || video_driver == NULL || strcmp(video_driver, "offscreen") != 0) {
+            return false;
+        }
+
+        SIREN_WARN("Unable to create an offscreen GL context. Falling back to a hidden window.");
+        SDL_VideoQuit();
+        // SDL_VideoInit reads the driver hint again, so clear it or the offscreen driver comes back
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "");
+        if (SDL_VideoInit(NULL) != 0) {
+            SIREN_ERROR("SDL video failed to initialize: %s", SDL_GetError());
+            return false;
+        }
+        if (!renderer_create_window_and_context(config)) {
+            return false;
+        }
+    }
+    state.screen_size = config.screen_size;
+    state.window_size = config.window_size;
+    state.headless = config.headless;
+
+    // Set vsync mode
+    if (SDL_GL_SetSwapInterval(config.swap_interval) != 0) {
+        if (config.swap_interval == -1) {
+            SIREN_WARN("Adaptive vsync not supported, falling back to vsync: %s", SDL_GetError());
+            SDL_GL_SetSwapInterval(1);
+        } else {
+            SIREN_WARN("Unable to set swap interval %i: %s", config.swap_interval, SDL_GetError());
+        }
+    }
 
     // Setup GLAD
     gladLoadGLLoader(SDL_GL_GetProcAddress);
@@ -73,6 +229,8 @@ bool siren::renderer_init(RendererConfig config) {
         SIREN_ERROR("Error loading OpenGL.");
         return false;
     }
+    // Every upload is tightly packed, and RGB, single channel and small mip rows often aren't a multiple of 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
     // Setup quad VAO
     float quad_vertices[] = {
@@ -92,6 +250,7 @@ bool siren::renderer_init(RendererConfig config) {
 	glBindVertexArray(state.quad_vao);
 	glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), &quad_vertices, GL_STATIC_DRAW);
+    memory_track_alloc(MEMORY_TAG_RENDERER, MEMORY_KIND_VERTEX_BUFFER, NULL, sizeof(quad_vertices));
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
@@ -117,6 +276,7 @@ bool siren::renderer_init(RendererConfig config) {
     glBindVertexArray(state.glyph_vao);
     glBindBuffer(GL_ARRAY_BUFFER, glyph_vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(glyph_vertices), &glyph_vertices, GL_STATIC_DRAW);
+    memory_track_alloc(MEMORY_TAG_RENDERER, MEMORY_KIND_VERTEX_BUFFER, NULL, sizeof(glyph_vertices));
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
@@ -124,64 +284,21 @@ bool siren::renderer_init(RendererConfig config) {
 	glBindVertexArray(0);
 
     // Setup cube vao
-	float cube_vertices[] = {
-		// back face
-		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-		 1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
-		 1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-		-1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-		-1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
-		// front face
-		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-		 1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
-		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-		 1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-		-1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
-		-1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-		// left face
-		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-		-1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
-		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-		-1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
-		-1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-		-1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
-		// right face
-		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-		 1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right         
-		 1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
-		 1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
-		 1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left     
-		 // bottom face
-		 -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-		  1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
-		  1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-		  1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
-		 -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
-		 -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
-		 // top face
-		 -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-		  1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-		  1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right     
-		  1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-		 -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-		 -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left        
-	};
-
 	GLuint cube_vbo;
 	glGenVertexArrays(1, &state.cube_vao);
 	glGenBuffers(1, &cube_vbo);
 	glBindVertexArray(state.cube_vao);
 	glBindBuffer(GL_ARRAY_BUFFER, cube_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GEOMETRY_CUBE_VERTICES), GEOMETRY_CUBE_VERTICES, GL_STATIC_DRAW);
+    memory_track_alloc(MEMORY_TAG_RENDERER, MEMORY_KIND_VERTEX_BUFFER, NULL, sizeof(GEOMETRY_CUBE_VERTICES));
 
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::VertexData), (void*)offsetof(Geometry::VertexData, position));
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::VertexData), (void*)offsetof(Geometry::VertexData, normal));
 	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	// Only the first two texture coordinates are read
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Geometry::VertexData), (void*)offsetof(Geometry::VertexData, tex_coord));
 
 	glBindVertexArray(0);
 
@@ -193,6 +310,7 @@ bool siren::renderer_init(RendererConfig config) {
 	glGenTextures(1, &state.screen_texture);
 	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, state.screen_texture);
 	glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, state.screen_size.x, state.screen_size.y, GL_TRUE);
+    texture_track_memory(MEMORY_TAG_RENDERER, "screen framebuffer", GL_RGB, state.screen_size, 1, 1, 4);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, state.screen_texture, 0);
 	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
 
@@ -200,6 +318,7 @@ bool siren::renderer_init(RendererConfig config) {
 	glGenRenderbuffers(1, &rbo);
 	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
 	glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, state.screen_size.x, state.screen_size.y);
+    memory_track_alloc(MEMORY_TAG_RENDERER, MEMORY_KIND_RENDERBUFFER, "screen framebuffer", (size_t)state.screen_size.x * state.screen_size.y * 4 * 4);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
@@ -213,6 +332,7 @@ bool siren::renderer_init(RendererConfig config) {
 	glGenTextures(1, &state.screen_intermediate_texture);
 	glBindTexture(GL_TEXTURE_2D, state.screen_intermediate_texture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, state.screen_size.x, state.screen_size.y, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    texture_track_memory(MEMORY_TAG_RENDERER, "screen framebuffer", GL_RGB, state.screen_size, 1, 1, 1);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, state.screen_intermediate_texture, 0);
@@ -263,6 +383,27 @@ bool siren::renderer_init(RendererConfig config) {
     shader_use(state.light_shader);
     shader_set_uniform_mat4(state.light_shader, "projection", &projection);
 
+    // Camera data lives in a uniform buffer, so the view can be patched once per frame after the draws are recorded
+    shader_set_uniform_block_binding(state.model_shader, "FrameData", RENDERER_FRAME_DATA_BINDING);
+    shader_set_uniform_block_binding(state.geometry_shader, "FrameData", RENDERER_FRAME_DATA_BINDING);
+    shader_set_uniform_block_binding(state.light_shader, "FrameData", RENDERER_FRAME_DATA_BINDING);
+    GLint uniform_buffer_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_alignment);
+    if (uniform_buffer_alignment <= 0) {
+        uniform_buffer_alignment = 256;
+    }
+    state.frame_data_stride = (uint32_t)(((sizeof(RenderFrameData) + uniform_buffer_alignment - 1) / uniform_buffer_alignment) * uniform_buffer_alignment);
+    glGenBuffers(1, &state.frame_data_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, state.frame_data_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, state.frame_data_stride * RENDERER_MAX_CAMERAS, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    memory_track_alloc(MEMORY_TAG_RENDERER, MEMORY_KIND_UNIFORM_BUFFER, NULL, state.frame_data_stride * RENDERER_MAX_CAMERAS);
+
+    gpu_timer_init();
+
+    state.upload_budget = config.upload_budget > 0.0f ? config.upload_budget : RENDERER_DEFAULT_UPLOAD_BUDGET;
+    renderer_refill_reserved_textures();
+
     SIREN_INFO("Renderer subsystem initialized: %s", glGetString(GL_VERSION));
     
     initialized = true;
@@ -273,7 +414,22 @@ bool siren::renderer_init(RendererConfig config) {
     textures.push_back("texture/tile/white_wall_state.png");
     state.geometry = geometry_create_cube(vec3(2.0f, 0.5f, 1.0f));
     state.geometry.material_albedo = texture_array_create("test", textures);
-    state.light_position = vec3(-1.0f, 1.0f, 2.0f);
+    state.lights.clear();
+    state.lights.push_back((Light) {
+        .position = vec3(-1.0f, 1.0f, 2.0f),
+        .color = vec3(25.0f)
+    });
+
+    state.record_list_index = 0;
+    state.warned_out_of_cameras = false;
+    state.threaded = config.threaded;
+    if (state.threaded) {
+        // From here on the render thread owns the context
+        SDL_GL_MakeCurrent(state.window, NULL);
+        state.is_thread_running = true;
+        state.thread = std::thread(renderer_thread_main);
+        SIREN_INFO("Renderer is using a render thread.");
+    }
 
     return true;
 }
@@ -283,13 +439,460 @@ void siren::renderer_quit() {
         return;
     }
 
+    if (state.threaded) {
+        {
+            std::unique_lock<std::mutex> lock(state.thread_mutex);
+            state.thread_condition.wait(lock, []() {
+                return !state.is_frame_submitted;
+            });
+            state.is_thread_quitting = true;
+        }
+        state.thread_condition.notify_all();
+        state.thread.join();
+        state.is_thread_running = false;
+        SDL_GL_MakeCurrent(state.window, state.context);
+    }
+
+    // Uploads still queued at shutdown are dropped along with their data
+    if (!state.uploads.empty()) {
+        SIREN_WARN("%u asset uploads were still queued at shutdown.", (uint32_t)state.uploads.size());
+    }
+    state.uploads.clear();
+    state.finished_uploads.clear();
+    glDeleteTextures((GLsizei)state.reserved_textures.size(), state.reserved_textures.data());
+    glDeleteTextures((GLsizei)state.reserved_texture_arrays.size(), state.reserved_texture_arrays.data());
+    state.reserved_textures.clear();
+    state.reserved_texture_arrays.clear();
+
+    gpu_timer_quit();
+    glDeleteBuffers(1, &state.frame_data_buffer);
+    memory_track_free(MEMORY_TAG_RENDERER, MEMORY_KIND_UNIFORM_BUFFER, NULL, state.frame_data_stride * RENDERER_MAX_CAMERAS);
+    for (uint32_t index = 0; index < 2; index++) {
+        if (state.headless_frame_fences[index] != NULL) {
+            glDeleteSync(state.headless_frame_fences[index]);
+            state.headless_frame_fences[index] = NULL;
+        }
+    }
     SDL_GL_DeleteContext(state.context);
     SDL_DestroyWindow(state.window);
 
     initialized = false;
 }
 
+void siren::renderer_context_acquire() {
+    // Uploads already run on the render thread, which owns the context
+    if (!state.threaded || !state.is_thread_running || std::this_thread::get_id() == state.thread.get_id()) {
+        return;
+    }
+    state.context_borrow_depth++;
+    if (state.context_borrow_depth > 1) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(state.thread_mutex);
+    state.is_context_requested = true;
+    state.thread_condition.notify_all();
+    state.thread_condition.wait(lock, []() {
+        return state.is_context_released;
+    });
+    SDL_GL_MakeCurrent(state.window, state.context);
+}
+
+void siren::renderer_context_release() {
+    if (!state.threaded || !state.is_thread_running || std::this_thread::get_id() == state.thread.get_id()) {
+        return;
+    }
+    state.context_borrow_depth--;
+    if (state.context_borrow_depth > 0) {
+        return;
+    }
+
+    SDL_GL_MakeCurrent(state.window, NULL);
+    {
+        std::lock_guard<std::mutex> lock(state.thread_mutex);
+        state.is_context_requested = false;
+    }
+    state.thread_condition.notify_all();
+}
+
+// Asset uploads
+
+GLuint renderer_create_placeholder_texture(GLenum target) {
+    static const uint8_t PLACEHOLDER_COLOR[4] = { 128, 128, 128, 255 };
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_COLOR);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_COLOR);
+    }
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(target, 0);
+    return texture;
+}
+
+// Called by the context owner
+void renderer_refill_reserved_textures() {
+    uint32_t texture_count;
+    uint32_t texture_array_count;
+    {
+        std::lock_guard<std::mutex> lock(state.upload_mutex);
+        texture_count = (uint32_t)state.reserved_textures.size();
+        texture_array_count = (uint32_t)state.reserved_texture_arrays.size();
+    }
+    if (texture_count == RENDERER_RESERVED_TEXTURE_COUNT && texture_array_count == RENDERER_RESERVED_TEXTURE_COUNT) {
+        return;
+    }
+
+    std::vector<GLuint> textures;
+    std::vector<GLuint> texture_arrays;
+    for (uint32_t index = texture_count; index < RENDERER_RESERVED_TEXTURE_COUNT; index++) {
+        textures.push_back(renderer_create_placeholder_texture(GL_TEXTURE_2D));
+    }
+    for (uint32_t index = texture_array_count; index < RENDERER_RESERVED_TEXTURE_COUNT; index++) {
+        texture_arrays.push_back(renderer_create_placeholder_texture(GL_TEXTURE_2D_ARRAY));
+    }
+
+    std::lock_guard<std::mutex> lock(state.upload_mutex);
+    state.reserved_textures.insert(state.reserved_textures.end(), textures.begin(), textures.end());
+    state.reserved_texture_arrays.insert(state.reserved_texture_arrays.end(), texture_arrays.begin(), texture_arrays.end());
+}
+
+uint32_t siren::renderer_reserve_texture(uint32_t target) {
+    {
+        std::lock_guard<std::mutex> lock(state.upload_mutex);
+        std::vector<GLuint>& reserved = target == GL_TEXTURE_2D_ARRAY ? state.reserved_texture_arrays : state.reserved_textures;
+        if (!reserved.empty()) {
+            GLuint texture = reserved.back();
+            reserved.pop_back();
+            return texture;
+        }
+    }
+
+    // More loads were started this frame than there were names ready
+    RendererContextScope context_scope;
+    return renderer_create_placeholder_texture(target);
+}
+
+void siren::renderer_queue_upload(siren::RendererUploadFunction upload, siren::RendererUploadFinishFunction finish, void* data) {
+    std::lock_guard<std::mutex> lock(state.upload_mutex);
+    state.uploads.push_back((RenderUpload) {
+        .upload = upload,
+        .finish = finish,
+        .data = data
+    });
+}
+
+// Runs queued uploads on the context owner until the budget is spent
+void renderer_run_uploads() {
+    SIREN_PROFILE_SCOPE("renderer_run_uploads");
+    renderer_refill_reserved_textures();
+
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    const uint64_t budget = (uint64_t)((double)state.upload_budget * (double)frequency);
+    const uint64_t start_time = SDL_GetPerformanceCounter();
+    while (true) {
+        RenderUpload upload;
+        {
+            std::lock_guard<std::mutex> lock(state.upload_mutex);
+            if (state.uploads.empty()) {
+                return;
+            }
+            upload = state.uploads.front();
+        }
+
+        // Only this thread pops, so the front is still the same upload afterwards
+        bool is_done = upload.upload(upload.data);
+        if (is_done) {
+            std::lock_guard<std::mutex> lock(state.upload_mutex);
+            state.uploads.pop_front();
+            state.finished_uploads.push_back(upload);
+        }
+
+        if (SDL_GetPerformanceCounter() - start_time >= budget) {
+            return;
+        }
+    }
+}
+
+// Called on the main thread while nothing is being replayed
+void renderer_finish_uploads() {
+    std::vector<RenderUpload> finished_uploads;
+    {
+        std::lock_guard<std::mutex> lock(state.upload_mutex);
+        if (state.finished_uploads.empty()) {
+            return;
+        }
+        finished_uploads.swap(state.finished_uploads);
+    }
+
+    SIREN_PROFILE_SCOPE("renderer_finish_uploads");
+    for (const RenderUpload& upload : finished_uploads) {
+        upload.finish(upload.data);
+    }
+}
+
+siren::GpuTimings siren::renderer_get_gpu_timings() {
+    std::lock_guard<std::mutex> lock(state.thread_mutex);
+    return state.gpu_timings;
+}
+
+// Command recording
+
+RenderCommandList& renderer_get_record_list() {
+    return state.command_lists[state.record_list_index];
+}
+
+// Copies data into the list being recorded and returns its offset. Offsets are kept 16 byte aligned for the matrices.
+uint32_t renderer_push_command_data(const void* data, size_t size) {
+    std::vector<uint8_t>& list_data = renderer_get_record_list().data;
+    uint32_t offset = (uint32_t)((list_data.size() + 15) & ~(size_t)15);
+    list_data.resize(offset + size);
+    if (data != NULL) {
+        memcpy(list_data.data() + offset, data, size);
+    }
+    return offset;
+}
+
+void renderer_push_command(const RenderCommand& command) {
+    renderer_get_record_list().commands.push_back(command);
+}
+
+// Draws from the same camera in the same state share a slot in the frame data buffer
+uint32_t renderer_get_camera_index(siren::Camera* camera) {
+    std::vector<RenderCamera>& cameras = renderer_get_record_list().cameras;
+    siren::mat4 view = camera->get_view_matrix();
+    for (uint32_t index = 0; index < cameras.size(); index++) {
+        if (cameras[index].source == camera && memcmp(&cameras[index].recorded_view, &view, sizeof(view)) == 0) {
+            return index;
+        }
+    }
+
+    if (cameras.size() == RENDERER_MAX_CAMERAS) {
+        if (!state.warned_out_of_cameras) {
+            SIREN_WARN("More than %u cameras used in one frame. Reusing the last camera.", RENDERER_MAX_CAMERAS);
+            state.warned_out_of_cameras = true;
+        }
+        return RENDERER_MAX_CAMERAS - 1;
+    }
+    cameras.push_back((RenderCamera) {
+        .source = camera,
+        .camera = *camera,
+        .recorded_view = view,
+        .view = view
+    });
+    return (uint32_t)cameras.size() - 1;
+}
+
+/*
+ * Re-evaluates late latched cameras with mouse motion that no update has applied to them yet. That's motion SDL has
+ * received since events were last polled, plus any that was polled on frames that didn't run a fixed update.
+ * The events are only peeked, so the game still gets them next frame, at which point they're part of the camera itself.
+ */
+void renderer_late_latch_cameras(RenderCommandList& list) {
+    bool has_late_latched_camera = false;
+    for (const RenderCamera& camera : list.cameras) {
+        has_late_latched_camera = has_late_latched_camera || camera.camera.is_late_latched();
+    }
+    if (!has_late_latched_camera || !SDL_GetRelativeMouseMode()) {
+        return;
+    }
+
+    SIREN_PROFILE_SCOPE("renderer_late_latch");
+    SDL_PumpEvents();
+    SDL_Event events[RENDERER_LATE_LATCH_MAX_EVENTS];
+    int event_count = SDL_PeepEvents(events, RENDERER_LATE_LATCH_MAX_EVENTS, SDL_PEEKEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION);
+    siren::ivec2 motion = siren::input_get_pending_mouse_relative_position();
+    for (int index = 0; index < event_count; index++) {
+        motion = motion + siren::ivec2(events[index].motion.xrel, events[index].motion.yrel);
+    }
+    if (motion.x == 0 && motion.y == 0) {
+        return;
+    }
+
+    for (RenderCamera& camera : list.cameras) {
+        if (!camera.camera.is_late_latched()) {
+            continue;
+        }
+        camera.view = camera.camera.get_view_matrix_with_offset(
+            (float)motion.y * camera.camera.get_late_latch_pitch_per_pixel(),
+            (float)motion.x * camera.camera.get_late_latch_yaw_per_pixel());
+    }
+}
+
 void siren::renderer_prepare_frame() {
+    renderer_push_command((RenderCommand) {
+        .type = RENDER_COMMAND_BEGIN_FRAME
+    });
+}
+
+void renderer_execute_command_list(const RenderCommandList& list);
+
+void siren::renderer_present_frame() {
+    if (!state.threaded) {
+        renderer_late_latch_cameras(state.command_lists[state.record_list_index]);
+        renderer_execute_command_list(state.command_lists[state.record_list_index]);
+        renderer_finish_uploads();
+        asset_evict_unused();
+        state.gpu_timings = gpu_timer_get_timings();
+        state.command_lists[state.record_list_index].commands.clear();
+        state.command_lists[state.record_list_index].data.clear();
+        state.command_lists[state.record_list_index].cameras.clear();
+        return;
+    }
+
+    {
+        // Wait for the render thread to finish the previous frame, then hand it this one and record into the other list
+        SIREN_PROFILE_SCOPE("renderer_wait");
+        std::unique_lock<std::mutex> lock(state.thread_mutex);
+        state.thread_condition.wait(lock, []() {
+            return !state.is_frame_submitted;
+        });
+
+        // The render thread stays idle until it's handed the next frame, so resources can be swapped out under it
+        lock.unlock();
+        renderer_finish_uploads();
+        asset_evict_unused();
+        // Latched only now so the view doesn't go stale while waiting on the render thread
+        renderer_late_latch_cameras(state.command_lists[state.record_list_index]);
+        lock.lock();
+
+        state.submitted_list_index = state.record_list_index;
+        state.is_frame_submitted = true;
+        state.record_list_index = (state.record_list_index + 1) % 2;
+    }
+    state.thread_condition.notify_all();
+
+    state.command_lists[state.record_list_index].commands.clear();
+    state.command_lists[state.record_list_index].data.clear();
+    state.command_lists[state.record_list_index].cameras.clear();
+}
+
+void siren::renderer_render_text(const char* text, siren::FontHandle font_handle, siren::ivec2 position, siren::vec3 color) {
+    size_t length = strlen(text);
+    RenderCommand command;
+    command.type = RENDER_COMMAND_TEXT;
+    command.handle = font_handle;
+    command.data_offset = renderer_push_command_data(text, length + 1);
+    command.data_count = (uint32_t)length;
+    command.position = position;
+    command.color = color;
+    renderer_push_command(command);
+}
+
+void siren::renderer_render_texture(siren::Texture texture) {
+    RenderCommand command;
+    command.type = RENDER_COMMAND_TEXTURE;
+    command.handle = texture;
+    renderer_push_command(command);
+}
+
+void siren::renderer_set_lights(const siren::Light* lights, uint32_t light_count) {
+    if (light_count > RENDERER_MAX_SHADED_LIGHTS) {
+        SIREN_TRACE("renderer_set_lights given %u lights but only the first %u are shaded.", light_count, RENDERER_MAX_SHADED_LIGHTS);
+    }
+    RenderCommand command;
+    command.type = RENDER_COMMAND_SET_LIGHTS;
+    command.data_offset = renderer_push_command_data(lights, sizeof(Light) * light_count);
+    command.data_count = light_count;
+    renderer_push_command(command);
+}
+
+void siren::renderer_render_light(siren::Camera* camera) {
+    RenderCommand command;
+    command.type = RENDER_COMMAND_LIGHT;
+    command.camera_index = renderer_get_camera_index(camera);
+    renderer_push_command(command);
+}
+
+void siren::renderer_render_model(siren::Camera* camera, siren::ModelHandle model_handle, siren::ModelTransform& transform, float alpha) {
+    SIREN_PROFILE_SCOPE("renderer_render_model");
+    // Models still loading draw nothing
+    if (!model_is_ready(model_handle)) {
+        return;
+    }
+    const Model& model = model_get(model_handle);
+
+    RenderCommand command;
+    command.type = RENDER_COMMAND_MODEL;
+    command.handle = model_handle;
+    command.model = transform.get_interpolated_root(alpha).to_mat4();
+    command.camera_index = renderer_get_camera_index(camera);
+
+    // bone matrices
+    // The final matrices are written straight into the command list, so the render thread never reads the transform
+    // Bones are affine, so they're uploaded as 3x4 matrices
+    command.data_offset = renderer_push_command_data(NULL, sizeof(affine3x4) * model.bones.size());
+    command.data_count = (uint32_t)model.bones.size();
+    affine3x4* bone_final_matrix = (affine3x4*)(renderer_get_record_list().data.data() + command.data_offset);
+    ScratchScope scratch;
+    affine3x4* bone_matrix = scratch.push_array<affine3x4>(model.bones.size());
+    const affine3x4* bone_local_matrix = transform.get_bone_transforms();
+    if (bone_local_matrix == NULL) {
+        // The model finished loading after this transform was made and it hasn't been animated since, so use the bind pose
+        for (uint32_t bone_id = 0; bone_id < model.bones.size(); bone_id++) {
+            bone_matrix[bone_id] = model.bones[bone_id].transform;
+        }
+        bone_local_matrix = bone_matrix;
+    }
+    transform_compose_hierarchy(bone_local_matrix, model.bone_parent_ids.data(), (uint32_t)model.bones.size(), bone_matrix);
+    for (uint32_t bone_id = 0; bone_id < model.bones.size(); bone_id++) {
+        bone_final_matrix[bone_id] = bone_matrix[bone_id] * model.bones[bone_id].inverse_bind_transform;
+    }
+
+    renderer_push_command(command);
+}
+
+void siren::renderer_render_geometry(siren::Camera* camera, siren::Transform transform) {
+    RenderCommand command;
+    command.type = RENDER_COMMAND_GEOMETRY;
+    command.model = transform.to_mat4();
+    command.camera_index = renderer_get_camera_index(camera);
+    renderer_push_command(command);
+}
+
+// Command execution, on whichever thread owns the GL context
+
+void renderer_upload_cameras(const RenderCommandList& list) {
+    if (list.cameras.empty()) {
+        return;
+    }
+
+    uint8_t frame_data[RENDERER_MAX_CAMERAS * 256];
+    uint32_t upload_size = state.frame_data_stride * (uint32_t)list.cameras.size();
+    SIREN_ASSERT(upload_size <= sizeof(frame_data));
+    for (uint32_t index = 0; index < list.cameras.size(); index++) {
+        const RenderCamera& camera = list.cameras[index];
+        siren::vec3 position = camera.camera.get_position();
+        RenderFrameData data = (RenderFrameData) {
+            .view = camera.view,
+            .view_position = { position.x, position.y, position.z, 1.0f }
+        };
+        memcpy(&frame_data[index * state.frame_data_stride], &data, sizeof(data));
+    }
+
+    // Orphan last frame's storage so that the upload doesn't wait on draws that still use it
+    glBindBuffer(GL_UNIFORM_BUFFER, state.frame_data_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, state.frame_data_stride * RENDERER_MAX_CAMERAS, NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, upload_size, frame_data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    state.bound_camera_index = UINT32_MAX;
+}
+
+void renderer_bind_camera(uint32_t camera_index) {
+    if (camera_index == state.bound_camera_index) {
+        return;
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, RENDERER_FRAME_DATA_BINDING, state.frame_data_buffer, camera_index * state.frame_data_stride, sizeof(RenderFrameData));
+    state.bound_camera_index = camera_index;
+}
+
+void renderer_execute_begin_frame() {
+    siren::gpu_timer_frame_begin();
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_SCENE);
+
     glBindFramebuffer(GL_FRAMEBUFFER, state.screen_framebuffer);
     glViewport(0, 0, state.screen_size.x, state.screen_size.y);
     glEnable(GL_DEPTH_TEST);
@@ -299,13 +902,29 @@ void siren::renderer_prepare_frame() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void siren::renderer_present_frame() {
+void renderer_execute_present() {
     // Blit multisample buffer to intermediate buffer
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_RESOLVE);
     glBindFramebuffer(GL_READ_FRAMEBUFFER, state.screen_framebuffer);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, state.screen_intermediate_framebuffer);
     glBlitFramebuffer(0, 0, state.screen_size.x, state.screen_size.y, 0, 0, state.screen_size.x, state.screen_size.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
+    if (state.headless) {
+        // There's no swap to throttle us, so keep at most two frames in flight like a swap chain would
+        siren::gpu_timer_frame_end();
+        GLsync& fence = state.headless_frame_fences[state.headless_frame_index];
+        if (fence != NULL) {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+            glDeleteSync(fence);
+        }
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        state.headless_frame_index = (state.headless_frame_index + 1) % 2;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+
     // Render framebuffer to screen
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_SCREEN);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(0, 0, state.window_size.x, state.window_size.y);
     glBlendFunc(GL_ONE, GL_ZERO);
@@ -313,40 +932,47 @@ void siren::renderer_present_frame() {
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    shader_use(state.screen_shader);
+    siren::shader_use(state.screen_shader);
     glBindVertexArray(state.quad_vao);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, state.screen_intermediate_texture);
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
 
+    siren::gpu_timer_frame_end();
     SDL_GL_SwapWindow(state.window);
 }
 
-void siren::renderer_render_text(const char* text, siren::FontHandle font_handle, siren::ivec2 position, siren::vec3 color) {
-    const Font& font = font_get(font_handle);
+void renderer_execute_text(const RenderCommand& command, const RenderCommandList& list) {
+    const siren::Font& font = siren::font_get(command.handle);
+    // Fonts still loading have no atlas yet
+    if (font.atlas == 0) {
+        return;
+    }
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_TEXT);
 
     // TODO some sort of state to prevent making this call for each text?
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    vec2 glyph_size = vec2((float)font.glyph_width, (float)font.glyph_height);
+    siren::vec2 glyph_size = siren::vec2((float)font.glyph_width, (float)font.glyph_height);
 
-    shader_use(state.text_shader);
-    shader_set_uniform_vec2(state.text_shader, "glyph_size", glyph_size);
-    shader_set_uniform_vec3(state.text_shader, "text_color", color);
+    siren::shader_use(state.text_shader);
+    siren::shader_set_uniform_vec2(state.text_shader, "glyph_size", glyph_size);
+    siren::shader_set_uniform_vec3(state.text_shader, "text_color", command.color);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, font.atlas);
     glBindVertexArray(state.glyph_vao);
 
-    vec2 render_position = vec2((float)position.x, (float)position.y);
-    vec2 glyph_offset = vec2(0.0f, 0.0f);
+    siren::vec2 render_position = siren::vec2((float)command.position.x, (float)command.position.y);
+    siren::vec2 glyph_offset = siren::vec2(0.0f, 0.0f);
+    const char* text = (const char*)(list.data.data() + command.data_offset);
     for (const char* c = text; *c != '\0'; c++) {
-        int glyph_index = ((int)*c) - Font::FIRST_CHAR;
+        int glyph_index = ((int)*c) - siren::Font::FIRST_CHAR;
         glyph_offset.x = (float)(font.glyph_width * glyph_index);
 
-        shader_set_uniform_vec2(state.text_shader, "render_position", render_position);
-        shader_set_uniform_vec2(state.text_shader, "glyph_offset", glyph_offset);
+        siren::shader_set_uniform_vec2(state.text_shader, "render_position", render_position);
+        siren::shader_set_uniform_vec2(state.text_shader, "glyph_offset", glyph_offset);
 
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
@@ -357,67 +983,74 @@ void siren::renderer_render_text(const char* text, siren::FontHandle font_handle
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void siren::renderer_render_texture(siren::Texture texture) {
+void renderer_execute_texture(const RenderCommand& command) {
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_SCENE);
     glUseProgram(state.screen_shader);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D, command.handle);
     glBindVertexArray(state.quad_vao);
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void siren::renderer_render_light(siren::Camera* camera) {
-    mat4 model = ((Transform) {
-        .position = state.light_position,
-        .rotation = quat(),
-        .scale = vec3(0.1f)
-    }).to_mat4();
+void renderer_set_light_uniforms(siren::Shader shader) {
+    uint32_t light_count = std::min((uint32_t)state.lights.size(), RENDERER_MAX_SHADED_LIGHTS);
+    char uniform_name[32];
+    for (uint32_t light_index = 0; light_index < light_count; light_index++) {
+        snprintf(uniform_name, sizeof(uniform_name), "light_positions[%u]", light_index);
+        siren::shader_set_uniform_vec3(shader, uniform_name, state.lights[light_index].position);
+        snprintf(uniform_name, sizeof(uniform_name), "light_colors[%u]", light_index);
+        siren::shader_set_uniform_vec3(shader, uniform_name, state.lights[light_index].color);
+    }
+    siren::shader_set_uniform_int(shader, "light_count", (int)light_count);
+}
 
-    shader_use(state.light_shader);
+void renderer_execute_set_lights(const RenderCommand& command, const RenderCommandList& list) {
+    const siren::Light* lights = (const siren::Light*)(list.data.data() + command.data_offset);
+    state.lights.assign(lights, lights + command.data_count);
+}
 
-    mat4 view = camera->get_view_matrix();
-    shader_set_uniform_mat4(state.light_shader, "model", &model);
-    shader_set_uniform_mat4(state.light_shader, "view", &view);
+void renderer_execute_light(const RenderCommand& command) {
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_SCENE);
+    siren::shader_use(state.light_shader);
+    renderer_bind_camera(command.camera_index);
 
     glBindVertexArray(state.cube_vao);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    for (const siren::Light& light : state.lights) {
+        siren::mat4 model = ((siren::Transform) {
+            .position = light.position,
+            .rotation = siren::quat(),
+            .scale = siren::vec3(0.1f)
+        }).to_mat4();
+        siren::shader_set_uniform_mat4(state.light_shader, "model", &model);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
     glBindVertexArray(0);
 }
 
-void siren::renderer_render_model(siren::Camera* camera, siren::ModelHandle model_handle, siren::ModelTransform& transform) {
-    const Model& model = model_get(model_handle);
-    mat4 model_matrix = transform.root.to_mat4();
+void renderer_execute_model(const RenderCommand& command, const RenderCommandList& list) {
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_MODELS);
+    const siren::Model& model = siren::model_get(command.handle);
 
-    shader_use(state.model_shader);
+    siren::shader_use(state.model_shader);
 
-    mat4 view = camera->get_view_matrix();
-    vec3 camera_position = camera->get_position();
-    shader_set_uniform_mat4(state.model_shader, "view", &view);
-    shader_set_uniform_vec3(state.model_shader, "view_position", camera_position);
+    renderer_bind_camera(command.camera_index);
 
-    shader_set_uniform_vec3(state.model_shader, "light_positions[0]", state.light_position);
-    shader_set_uniform_vec3(state.model_shader, "light_colors[0]", vec3(25.0f));
-    shader_set_uniform_int(state.model_shader, "light_count", 1);
+    renderer_set_light_uniforms(state.model_shader);
 
-    // bone matrices
-    mat4 bone_matrix[100];
-    mat4 bone_final_matrix[100];
-    struct BoneNode {
-        int id;
-        mat4 parent_transform;
-    };
-    for (int bone_id = 0; bone_id < model.bones.size(); bone_id++) {
-        mat4 parent_transform = model.bones[bone_id].parent_id == -1 ? mat4(1.0f) : bone_matrix[model.bones[bone_id].parent_id];
-        bone_matrix[bone_id] = parent_transform * transform.get_bone_transform(bone_id); 
-        bone_final_matrix[bone_id] = bone_matrix[bone_id] * model.bones[bone_id].inverse_bind_transform;
+    // Models without bones have no matrices in the list to upload
+    if (command.data_count != 0) {
+        siren::shader_set_uniform_affine3x4(state.model_shader, "bone_matrix", (siren::affine3x4*)(list.data.data() + command.data_offset), command.data_count);
     }
-    shader_set_uniform_mat4(state.model_shader, "bone_matrix", bone_final_matrix, model.bones.size());
+    // Models are affine, so normals get their inverse transpose from the cheap affine inverse rather than a 4x4 one per vertex
+    siren::affine3x4 inverse_model = siren::affine3x4::from_mat4(command.model).inversed();
+    siren::shader_set_uniform_affine3x4(state.model_shader, "inverse_model", &inverse_model);
 
     for (uint32_t mesh_index = 0; mesh_index < model.meshes.size(); mesh_index++) {
-        const Model::Mesh& mesh = model.meshes[mesh_index];
+        const siren::Model::Mesh& mesh = model.meshes[mesh_index];
 
-        shader_set_uniform_mat4(state.model_shader, "model", &model_matrix);
+        siren::shader_set_uniform_mat4(state.model_shader, "model", (siren::mat4*)&command.model);
 
         // material textures
         glActiveTexture(GL_TEXTURE0);
@@ -440,21 +1073,17 @@ void siren::renderer_render_model(siren::Camera* camera, siren::ModelHandle mode
     glBindVertexArray(0);
 }
 
-void siren::renderer_render_geometry(siren::Camera* camera) {
-    const Geometry& geometry = state.geometry;
-
-    shader_use(state.geometry_shader);
-    mat4 model = mat4(1.0f);
-    shader_set_uniform_mat4(state.geometry_shader, "model", &model);
+void renderer_execute_geometry(const RenderCommand& command) {
+    siren::gpu_timer_set_stage(siren::GPU_TIMER_STAGE_GEOMETRY);
+    const siren::Geometry& geometry = state.geometry;
 
-    mat4 view = camera->get_view_matrix();
-    vec3 camera_position = camera->get_position();
-    shader_set_uniform_mat4(state.geometry_shader, "view", &view);
-    shader_set_uniform_vec3(state.geometry_shader, "view_position", camera_position);
+    siren::shader_use(state.geometry_shader);
+    siren::shader_set_uniform_mat4(state.geometry_shader, "model", (siren::mat4*)&command.model);
+    siren::affine3x4 inverse_model = siren::affine3x4::from_mat4(command.model).inversed();
+    siren::shader_set_uniform_affine3x4(state.geometry_shader, "inverse_model", &inverse_model);
+    renderer_bind_camera(command.camera_index);
 
-    shader_set_uniform_vec3(state.geometry_shader, "light_positions[0]", state.light_position);
-    shader_set_uniform_vec3(state.geometry_shader, "light_colors[0]", vec3(25.0f));
-    shader_set_uniform_int(state.geometry_shader, "light_count", 1);
+    renderer_set_light_uniforms(state.geometry_shader);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D_ARRAY, geometry.material_albedo);
@@ -462,4 +1091,80 @@ void siren::renderer_render_geometry(siren::Camera* camera) {
     glDrawArrays(GL_TRIANGLES, 0, geometry.vertex_count);
 
     glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+void renderer_execute_command_list(const RenderCommandList& list) {
+    SIREN_PROFILE_SCOPE("renderer_execute_command_list");
+    renderer_run_uploads();
+    renderer_upload_cameras(list);
+    for (const RenderCommand& command : list.commands) {
+        switch (command.type) {
+            case RENDER_COMMAND_BEGIN_FRAME:
+                renderer_execute_begin_frame();
+                break;
+            case RENDER_COMMAND_TEXT:
+                renderer_execute_text(command, list);
+                break;
+            case RENDER_COMMAND_TEXTURE:
+                renderer_execute_texture(command);
+                break;
+            case RENDER_COMMAND_SET_LIGHTS:
+                renderer_execute_set_lights(command, list);
+                break;
+            case RENDER_COMMAND_LIGHT:
+                renderer_execute_light(command);
+                break;
+            case RENDER_COMMAND_MODEL:
+                renderer_execute_model(command, list);
+                break;
+            case RENDER_COMMAND_GEOMETRY:
+                renderer_execute_geometry(command);
+                break;
+        }
+    }
+    renderer_execute_present();
+}
+
+void renderer_thread_main() {
+    siren::profiler_set_thread_name("render");
+    SDL_GL_MakeCurrent(state.window, state.context);
+
+    std::unique_lock<std::mutex> lock(state.thread_mutex);
+    while (true) {
+        state.thread_condition.wait(lock, []() {
+            return state.is_frame_submitted || state.is_context_requested || state.is_thread_quitting;
+        });
+
+        if (state.is_context_requested) {
+            // Lend the context to the main thread so that it can create GL resources, then take it back once it's done
+            SDL_GL_MakeCurrent(state.window, NULL);
+            state.is_context_released = true;
+            state.thread_condition.notify_all();
+            state.thread_condition.wait(lock, []() {
+                return !state.is_context_requested;
+            });
+            state.is_context_released = false;
+            SDL_GL_MakeCurrent(state.window, state.context);
+            continue;
+        }
+
+        if (state.is_frame_submitted) {
+            const RenderCommandList& list = state.command_lists[state.submitted_list_index];
+            lock.unlock();
+            renderer_execute_command_list(list);
+            siren::GpuTimings gpu_timings = siren::gpu_timer_get_timings();
+            lock.lock();
+
+            state.gpu_timings = gpu_timings;
+            state.is_frame_submitted = false;
+            state.thread_condition.notify_all();
+            continue;
+        }
+
+        if (state.is_thread_quitting) {
+            break;
+        }
+    }
+
+    SDL_GL_MakeCurrent(state.window, NULL);
+}
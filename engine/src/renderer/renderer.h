@@ -7,24 +7,81 @@
 #include "math/transform.h"
 #include "renderer/font.h"
 #include "scene/camera.h"
+#include "scene/scene.h"
 #include "renderer/texture.h"
 #include "renderer/model.h"
+#include "renderer/gpu_timer.h"
 
 namespace siren {
     struct RendererConfig {
         const char* window_name;
         siren::ivec2 screen_size;
         siren::ivec2 window_size;
+        // 0 for immediate, 1 for vsync, -1 for adaptive vsync
+        int swap_interval;
+        // Render only into offscreen framebuffers and never present to the window
+        bool headless;
+        // Replay draw commands on a render thread that owns the GL context
+        bool threaded;
+        // Seconds per frame spent on queued asset uploads. At least one upload step always runs.
+        float upload_budget;
     };
 
     bool renderer_init(RendererConfig config);
     void renderer_quit();
 
+    /*
+     * The render functions below record commands into a list rather than calling GL directly.
+     * renderer_present_frame() submits the list, either replaying it immediately or handing it to the render thread.
+     * With a render thread, frame N is recorded while frame N-1 is replayed.
+     */
     void renderer_prepare_frame();
     void renderer_present_frame();
+    GpuTimings renderer_get_gpu_timings();
+
+    /*
+     * Code outside the renderer must borrow the GL context before making GL calls, since the render thread may own it.
+     * Borrowing waits for the render thread to go idle. It nests, and does nothing without a render thread.
+     */
+    SIREN_API void renderer_context_acquire();
+    SIREN_API void renderer_context_release();
+
+    // Returns true once the upload is finished. Until then it's called again on a later frame, so big uploads can be split into steps.
+    typedef bool (*RendererUploadFunction)(void* data);
+    typedef void (*RendererUploadFinishFunction)(void* data);
+
+    /*
+     * Queues GL work from any thread. Uploads run on whichever thread owns the context, at the start of each frame's replay,
+     * until the frame's upload budget is spent. Once an upload is done its finish function runs on the main thread at the next
+     * frame handoff, while nothing is being replayed, so it can safely publish the result to resources that draws read.
+     */
+    void renderer_queue_upload(RendererUploadFunction upload, RendererUploadFinishFunction finish, void* data);
+    /*
+     * Hands out a texture name for an asset that is still loading. It already has 1x1 placeholder storage on target
+     * (GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY), so it can be drawn with straight away. Can only be called from the main thread.
+     */
+    uint32_t renderer_reserve_texture(uint32_t target);
+
+    class RendererContextScope {
+        public:
+            SIREN_INLINE RendererContextScope() {
+                renderer_context_acquire();
+            }
+
+            SIREN_INLINE ~RendererContextScope() {
+                renderer_context_release();
+            }
+    };
+
     SIREN_API void renderer_render_text(const char* text, FontHandle font_handle, ivec2 position, vec3 color);
     SIREN_API void renderer_render_texture(Texture texture);
+    /*
+     * Replaces the scene lights. Every light gets a marker from renderer_render_light,
+     * but only the first four are used for shading models and geometry.
+     */
+    SIREN_API void renderer_set_lights(const Light* lights, uint32_t light_count);
     SIREN_API void renderer_render_light(Camera* camera);
-    SIREN_API void renderer_render_model(Camera* camera, ModelHandle model_handle, ModelTransform& transform);
-    SIREN_API void renderer_render_geometry(Camera* camera);
+    // alpha interpolates between the transform's previous and current root, see ModelTransform::store_previous_root()
+    SIREN_API void renderer_render_model(Camera* camera, ModelHandle model_handle, ModelTransform& transform, float alpha = 1.0f);
+    SIREN_API void renderer_render_geometry(Camera* camera, Transform transform = Transform::identity());
 }
\ No newline at end of file
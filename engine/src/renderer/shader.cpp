@@ -1,40 +1,29 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_RENDERER
+
 #include "shader.h"
 
 #include "core/logger.h"
 #include "core/resource.h"
+#include "core/profiler.h"
 
 #include <glad/glad.h>
 
-#include <fstream>
-#include <string>
-
 bool shader_compile(siren::Shader* id, GLenum shader_type, const char* path) {
-    // determine full path
-    std::string full_path = siren::resource_get_base_path() + std::string(path);
-
     // read the shader file
-    std::string shader_source;
-    std::ifstream shader_file;
-    std::string line;
-
-    shader_file.open(full_path);
-    if (!shader_file.is_open()) {
-        SIREN_ERROR("Error opening shader file at path %s", full_path.c_str());
+    siren::ResourceFile shader_file;
+    if (!siren::resource_open(path, &shader_file)) {
+        SIREN_ERROR("Error opening shader file at path %s", path);
         return false;
     }
 
-    while (std::getline(shader_file, line)) {
-        shader_source += line + "\n";
-    }
-
-    shader_file.close();
-    
-    // compile the shader
-    const char* shader_source_cstr = shader_source.c_str();
+    // compile the shader, passing the length since the file contents aren't null terminated
+    const char* shader_source = (const char*)shader_file.data;
+    GLint shader_source_length = (GLint)shader_file.size;
     int success;
     *id = glCreateShader(shader_type);
-    glShaderSource(*id, 1, &shader_source_cstr, NULL);
+    glShaderSource(*id, 1, &shader_source, &shader_source_length);
     glCompileShader(*id);
+    siren::resource_close(&shader_file);
     glGetShaderiv(*id, GL_COMPILE_STATUS, &success);
     if (!success) {
         char info_log[512];
@@ -47,6 +36,7 @@ bool shader_compile(siren::Shader* id, GLenum shader_type, const char* path) {
 }
 
 bool siren::shader_load(siren::Shader* id, const char* vertex_path, const char* fragment_path) {
+    SIREN_PROFILE_SCOPE("shader_load");
     // Compile shaders
     GLuint vertex_shader;
     if (!shader_compile(&vertex_shader, GL_VERTEX_SHADER, vertex_path)) {
@@ -118,4 +108,16 @@ void siren::shader_set_uniform_vec4(siren::Shader id, const char* name, siren::v
 
 void siren::shader_set_uniform_mat4(siren::Shader id, const char* name, siren::mat4* value, uint32_t size) {
     glUniformMatrix4fv(glGetUniformLocation(id, name), size, GL_FALSE, (float*)value);
-}
\ No newline at end of file
+}
+
+void siren::shader_set_uniform_affine3x4(siren::Shader id, const char* name, siren::affine3x4* value, uint32_t size) {
+    glUniformMatrix3x4fv(glGetUniformLocation(id, name), size, GL_FALSE, (float*)value);
+}
+
+void siren::shader_set_uniform_block_binding(siren::Shader id, const char* name, uint32_t binding) {
+    GLuint block_index = glGetUniformBlockIndex(id, name);
+    if (block_index == GL_INVALID_INDEX) {
+        return;
+    }
+    glUniformBlockBinding(id, block_index, binding);
+}
@@ -3,6 +3,7 @@
 #include "math/vector2.h"
 #include "math/vector3.h"
 #include "math/matrix.h"
+#include "math/affine.h"
 
 namespace siren {
     typedef uint32_t Shader;
@@ -18,4 +19,8 @@ namespace siren {
     void shader_set_uniform_vec3(Shader id, const char* name, vec3 value);
     void shader_set_uniform_vec4(Shader id, const char* name, vec4 value);
     void shader_set_uniform_mat4(Shader id, const char* name, mat4* value, uint32_t size = 1);
+    // Uploads to a GLSL mat3x4, whose columns are the rows of an affine3x4
+    void shader_set_uniform_affine3x4(Shader id, const char* name, affine3x4* value, uint32_t size = 1);
+    // Points a uniform block at a uniform buffer binding. Does nothing if the shader doesn't use the block.
+    void shader_set_uniform_block_binding(Shader id, const char* name, uint32_t binding);
 }
\ No newline at end of file
@@ -1,3 +1,5 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_TEXTURE
+
 #include "texture.h"
 
 #define SIREN_VTF_MAX_SUPPORTED_RESOURCES 32
@@ -5,6 +7,11 @@
 #include "core/logger.h"
 #include "core/resource.h"
 #include "core/asserts.h"
+#include "core/profiler.h"
+#include "core/job.h"
+#include "core/asset.h"
+#include "core/slot_map.h"
+#include "renderer/renderer.h"
 
 #include <glad/glad.h>
 
@@ -12,81 +19,511 @@
 #include <stb_image.h>
 
 #include <unordered_map>
+#include <vector>
 #include <cstdio>
+#include <cstring>
+
+struct TextureSlot {
+    siren::Texture texture;
+    // Key in texture_handles, the path or the array's name
+    std::string key;
+    // Storage, for freeing its memory tracking once it's loaded
+    uint32_t format;
+    siren::ivec2 size;
+    uint32_t layers;
+    uint32_t mip_count;
+    // Set while an async load is still showing its placeholder
+    bool is_pending;
+    // Empty unless this is a texture array that has finished loading
+    std::vector<siren::TextureArrayInfo> array_info;
+};
+
+/*
+ * Texture values are GL names, which the renderer and model meshes bind directly, so the slot map handles stay inside
+ * this file. They're what the asset system refers to textures by, and texture_slots finds a texture's slot from its name.
+ */
+static siren::SlotMap<TextureSlot> textures;
+static std::unordered_map<std::string, uint32_t> texture_handles;
+static std::unordered_map<siren::Texture, uint32_t> texture_slots;
+static const std::vector<siren::TextureArrayInfo> TEXTURE_ARRAY_INFO_EMPTY;
+
+static const uint32_t TEXTURE_MAX_MIP_COUNT = 16;
+
+/*
+ * Cooked textures are cached as <cache path>/<source hash>.stex. A TextureCookedHeader is followed by every mip level,
+ * largest first, tightly packed and each aligned to TEXTURE_COOKED_ALIGNMENT.
+ */
+static const char TEXTURE_COOKED_MAGIC[4] = { 'S', 'T', 'E', 'X' };
+static const uint32_t TEXTURE_COOKED_VERSION = 1;
+static const uint64_t TEXTURE_COOKED_ALIGNMENT = 16;
+static const size_t TEXTURE_COOKED_PATH_LENGTH = 1024;
+
+struct TextureCookedHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t source_size;
+    int32_t width;
+    int32_t height;
+    int32_t component_count;
+    uint32_t mip_count;
+    uint64_t mip_offsets[TEXTURE_MAX_MIP_COUNT];
+};
+
+struct TextureImage {
+    int width;
+    int height;
+    int component_count;
+    // Decoded images only have the first level, cooked ones have the whole chain
+    uint32_t mip_count;
+    const uint8_t* levels[TEXTURE_MAX_MIP_COUNT];
+    // Owns the pixels of a decoded image
+    stbi_uc* decoded;
+    // Mapped when the image came from the cache
+    siren::ResourceFile cooked_file;
+};
+
+struct TextureLoad {
+    std::string path;
+    uint32_t handle;
+    siren::Texture texture;
+    TextureImage image;
+    bool is_decoded;
+};
+
+struct TextureArrayLoad {
+    std::string name;
+    std::vector<std::string> paths;
+    uint32_t handle;
+    siren::Texture texture;
+    std::vector<TextureImage> images;
+    siren::ivec2 max_size;
+    bool is_decoded;
+};
+
+siren::Texture texture_load(const char* path, uint32_t handle);
+
+// Slots are inserted before loading, so that a full slot map fails before any work is done. Returns SLOT_MAP_HANDLE_NULL then.
+uint32_t texture_insert(const std::string& key, siren::Texture texture, bool is_pending) {
+    TextureSlot slot;
+    slot.texture = texture;
+    slot.key = key;
+    slot.format = 0;
+    slot.size = siren::ivec2(0, 0);
+    slot.layers = 0;
+    slot.mip_count = 0;
+    slot.is_pending = is_pending;
+    uint32_t handle = siren::slot_map_insert(&textures, std::move(slot));
+    if (handle == siren::SLOT_MAP_HANDLE_NULL) {
+        SIREN_ERROR("Unable to load texture %s, %u textures are already loaded.", key.c_str(), siren::SLOT_MAP_MAX_SLOTS);
+        return handle;
+    }
+    texture_handles[key] = handle;
+    if (texture != 0) {
+        texture_slots[texture] = handle;
+    }
+    return handle;
+}
 
-static std::unordered_map<std::string, siren::Texture> textures;
-static std::unordered_map<siren::Texture, std::vector<siren::TextureArrayInfo>> texture_array_info;
+void texture_remove(uint32_t handle) {
+    TextureSlot* slot = siren::slot_map_get(&textures, handle);
+    // A failed load has already handed its key to the retry
+    auto it = texture_handles.find(slot->key);
+    if (it != texture_handles.end() && it->second == handle) {
+        texture_handles.erase(it);
+    }
+    texture_slots.erase(slot->texture);
+    siren::slot_map_remove(&textures, handle);
+}
+
+TextureSlot* texture_find_slot(siren::Texture texture) {
+    auto it = texture_slots.find(texture);
+    if (it == texture_slots.end()) {
+        return NULL;
+    }
+    return siren::slot_map_get(&textures, it->second);
+}
 
-siren::Texture texture_load(const char* path);
+// Called once a texture has its storage, which makes it a candidate for eviction
+void texture_set_resident(uint32_t handle, siren::Texture texture, uint32_t format, siren::ivec2 size, uint32_t layers) {
+    TextureSlot* slot = siren::slot_map_get(&textures, handle);
+    slot->texture = texture;
+    slot->format = format;
+    slot->size = size;
+    slot->layers = layers;
+    slot->mip_count = siren::texture_get_mip_count(size);
+    texture_slots[texture] = handle;
+    siren::asset_set_resident(siren::ASSET_TYPE_TEXTURE, handle, siren::texture_get_memory_size(format, size, layers, slot->mip_count, 1), 0);
+}
 
 siren::Texture siren::texture_acquire(const char* path) {
     std::string key = std::string(path);
-
-    // determine full path
-    std::string full_path = resource_get_base_path() + key;
-    SIREN_TRACE("Loading texture %s...", full_path.c_str());
+    SIREN_TRACE("Loading texture %s...", path);
 
     // check if texture has been loaded
-    auto it = textures.find(key);
-    if (it != textures.end()) {
+    auto it = texture_handles.find(key);
+    if (it != texture_handles.end()) {
         SIREN_TRACE("Texture already loaded, returning copy.");
-        return it->second;
+        asset_reference(ASSET_TYPE_TEXTURE, it->second);
+        return slot_map_get(&textures, it->second)->texture;
     }
 
-    Texture texture = texture_load(full_path.c_str());
+    uint32_t handle = texture_insert(key, 0, false);
+    if (handle == SLOT_MAP_HANDLE_NULL) {
+        return 0;
+    }
 
-    if (texture != 0) {
-        textures[key] = texture;
-        SIREN_TRACE("Texture loaded successfully.");
+    RendererContextScope context_scope;
+    Texture texture = texture_load(path, handle);
+    if (texture == 0) {
+        texture_remove(handle);
+        return 0;
     }
 
+    asset_reference(ASSET_TYPE_TEXTURE, handle);
+    SIREN_TRACE("Texture loaded successfully.");
     return texture;
 }
 
-siren::Texture texture_load(const char* path) {
+void siren::texture_release(siren::Texture texture) {
+    // Solid colors are shared by every model that uses them and are never evicted, so they have no slot
+    auto it = texture_slots.find(texture);
+    if (it == texture_slots.end()) {
+        return;
+    }
+    asset_unreference(ASSET_TYPE_TEXTURE, it->second);
+}
+
+void siren::texture_evict(uint32_t handle) {
+    TextureSlot* slot = slot_map_get(&textures, handle);
+    if (slot == NULL) {
+        return;
+    }
+    texture_track_memory(MEMORY_TAG_TEXTURE, slot->key.c_str(), slot->format, slot->size, slot->layers, slot->mip_count, 1, true);
+    glDeleteTextures(1, &slot->texture);
+    SIREN_TRACE("Evicted texture %s.", slot->key.c_str());
+
+    // GL may hand the name out again, so the next acquire gets a new slot
+    texture_remove(handle);
+}
+
+void texture_image_free(TextureImage* image) {
+    if (image->decoded != NULL) {
+        stbi_image_free(image->decoded);
+    }
+    siren::resource_close(&image->cooked_file);
+    image->decoded = NULL;
+    image->mip_count = 0;
+}
+
+size_t texture_get_level_size(int width, int height, int component_count, uint32_t level) {
+    size_t level_width = (size_t)(width >> level > 0 ? width >> level : 1);
+    size_t level_height = (size_t)(height >> level > 0 ? height >> level : 1);
+    return level_width * level_height * (size_t)component_count;
+}
+
+// Box filters a level down to the next one. Odd edges repeat their last texel.
+void texture_build_mip(const uint8_t* source, int width, int height, int component_count, uint8_t* destination) {
+    int destination_width = width / 2 > 0 ? width / 2 : 1;
+    int destination_height = height / 2 > 0 ? height / 2 : 1;
+    for (int y = 0; y < destination_height; y++) {
+        int y0 = y * 2 < height ? y * 2 : height - 1;
+        int y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+        for (int x = 0; x < destination_width; x++) {
+            int x0 = x * 2 < width ? x * 2 : width - 1;
+            int x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+            for (int component = 0; component < component_count; component++) {
+                uint32_t sum = (uint32_t)source[(y0 * width + x0) * component_count + component] +
+                               (uint32_t)source[(y0 * width + x1) * component_count + component] +
+                               (uint32_t)source[(y1 * width + x0) * component_count + component] +
+                               (uint32_t)source[(y1 * width + x1) * component_count + component];
+                destination[(y * destination_width + x) * component_count + component] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+// Writes the image and a full mip chain built from its first level
+bool texture_write_cooked(const TextureImage* image, const char* cooked_path, uint64_t source_hash, uint64_t source_size) {
+    SIREN_PROFILE_SCOPE("texture_write_cooked");
+    uint32_t mip_count = siren::texture_get_mip_count(siren::ivec2(image->width, image->height));
+    if (mip_count > TEXTURE_MAX_MIP_COUNT) {
+        return false;
+    }
+
+    TextureCookedHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEXTURE_COOKED_MAGIC, sizeof(header.magic));
+    header.version = TEXTURE_COOKED_VERSION;
+    header.source_hash = source_hash;
+    header.source_size = source_size;
+    header.width = image->width;
+    header.height = image->height;
+    header.component_count = image->component_count;
+    header.mip_count = mip_count;
+
+    uint64_t size = sizeof(header);
+    for (uint32_t level = 0; level < mip_count; level++) {
+        size = (size + TEXTURE_COOKED_ALIGNMENT - 1) / TEXTURE_COOKED_ALIGNMENT * TEXTURE_COOKED_ALIGNMENT;
+        header.mip_offsets[level] = size;
+        size += texture_get_level_size(image->width, image->height, image->component_count, level);
+    }
+
+    std::vector<uint8_t> blob((size_t)size, 0);
+    memcpy(blob.data(), &header, sizeof(header));
+    memcpy(blob.data() + header.mip_offsets[0], image->levels[0], texture_get_level_size(image->width, image->height, image->component_count, 0));
+    for (uint32_t level = 1; level < mip_count; level++) {
+        int width = image->width >> (level - 1) > 0 ? image->width >> (level - 1) : 1;
+        int height = image->height >> (level - 1) > 0 ? image->height >> (level - 1) : 1;
+        texture_build_mip(blob.data() + header.mip_offsets[level - 1], width, height, image->component_count, blob.data() + header.mip_offsets[level]);
+    }
+
+    return siren::resource_write_file(cooked_path, blob.data(), blob.size());
+}
+
+// Maps a cooked image, or returns false if there isn't an up to date one
+bool texture_read_cooked(TextureImage* image, const char* cooked_path, uint64_t source_hash, uint64_t source_size) {
+    siren::ResourceFile& file = image->cooked_file;
+    if (!siren::resource_open_file(cooked_path, &file)) {
+        return false;
+    }
+
+    TextureCookedHeader header;
+    bool is_valid = file.size >= sizeof(header);
+    if (is_valid) {
+        memcpy(&header, file.data, sizeof(header));
+        is_valid = memcmp(header.magic, TEXTURE_COOKED_MAGIC, sizeof(header.magic)) == 0 && header.version == TEXTURE_COOKED_VERSION &&
+                   header.source_hash == source_hash && header.source_size == source_size &&
+                   header.width > 0 && header.height > 0 && header.component_count >= 1 && header.component_count <= 4 &&
+                   header.mip_count >= 1 && header.mip_count <= TEXTURE_MAX_MIP_COUNT;
+    }
+    for (uint32_t level = 0; is_valid && level < header.mip_count; level++) {
+        size_t level_size = texture_get_level_size(header.width, header.height, header.component_count, level);
+        is_valid = header.mip_offsets[level] <= file.size && file.size - header.mip_offsets[level] >= level_size;
+    }
+    if (!is_valid) {
+        siren::resource_close(&file);
+        return false;
+    }
+
+    image->width = header.width;
+    image->height = header.height;
+    image->component_count = header.component_count;
+    image->mip_count = header.mip_count;
+    for (uint32_t level = 0; level < header.mip_count; level++) {
+        image->levels[level] = file.data + header.mip_offsets[level];
+    }
+    return true;
+}
+
+bool texture_decode_source(const siren::ResourceFile& file, TextureImage* image) {
+    image->decoded = stbi_load_from_memory(file.data, (int)file.size, &image->width, &image->height, &image->component_count, 0);
+    if (image->decoded == NULL) {
+        return false;
+    }
+    image->levels[0] = image->decoded;
+    image->mip_count = 1;
+    return true;
+}
+
+// Reads the cooked copy of an image if there is an up to date one, and otherwise decodes it and cooks it for next time
+bool texture_read_image(const char* path, TextureImage* image) {
+    image->mip_count = 0;
+    image->decoded = NULL;
+    image->cooked_file = (siren::ResourceFile) { .data = NULL, .size = 0, .storage = NULL };
+    siren::ResourceFile file;
+    if (!siren::resource_open(path, &file)) {
+        return false;
+    }
+
+    char cooked_path[TEXTURE_COOKED_PATH_LENGTH];
+    uint64_t source_hash = 0;
+    bool is_cache_enabled = siren::resource_get_cache_path() != NULL;
+    if (is_cache_enabled) {
+        source_hash = siren::resource_hash(file.data, file.size);
+        is_cache_enabled = siren::resource_get_cache_file(source_hash, ".stex", cooked_path, sizeof(cooked_path));
+    }
+    if (is_cache_enabled && texture_read_cooked(image, cooked_path, source_hash, file.size)) {
+        siren::resource_close(&file);
+        return true;
+    }
+
+    bool success = texture_decode_source(file, image);
+    if (success && is_cache_enabled) {
+        texture_write_cooked(image, cooked_path, source_hash, file.size);
+    }
+    siren::resource_close(&file);
+    return success;
+}
+
+siren::CookResult siren::texture_cook(const char* path) {
+    SIREN_PROFILE_SCOPE("texture_cook");
+    ResourceFile file;
+    if (!resource_open(path, &file)) {
+        return COOK_FAILED;
+    }
+    uint64_t source_hash = resource_hash(file.data, file.size);
+    char cooked_path[TEXTURE_COOKED_PATH_LENGTH];
+    if (!resource_get_cache_file(source_hash, ".stex", cooked_path, sizeof(cooked_path))) {
+        resource_close(&file);
+        return COOK_FAILED;
+    }
+
+    TextureImage image;
+    image.mip_count = 0;
+    image.decoded = NULL;
+    image.cooked_file = (ResourceFile) { .data = NULL, .size = 0, .storage = NULL };
+    CookResult result = COOK_UP_TO_DATE;
+    if (!texture_read_cooked(&image, cooked_path, source_hash, file.size)) {
+        bool success = texture_decode_source(file, &image) && texture_write_cooked(&image, cooked_path, source_hash, file.size);
+        result = success ? COOK_WRITTEN : COOK_FAILED;
+    }
+    texture_image_free(&image);
+    resource_close(&file);
+    return result;
+}
+
+// Reads and decodes an image. Touches no GL state, so it can run on any thread.
+bool texture_decode(const char* path, TextureImage* image) {
+    SIREN_PROFILE_SCOPE("texture_decode");
     // TODO, call this only once?
     stbi_set_flip_vertically_on_load(false);
-    int width;
-    int height;
-    int number_of_components;
-    stbi_uc* data = stbi_load(path, &width, &height, &number_of_components, 0);
-    if (!data) {
+    if (!texture_read_image(path, image)) {
         SIREN_ERROR("Could not load texture %s", path);
-        return 0;
+        return false;
     }
 
-    GLenum texture_format;
-    if (number_of_components == 1) {
-        texture_format = GL_RED;
-    } else if (number_of_components == 3) {
-        texture_format = GL_RGB;
-    } else if (number_of_components == 4) {
-        texture_format = GL_RGBA;
-    } else {
+    if (image->component_count != 1 && image->component_count != 3 && image->component_count != 4) {
         SIREN_ERROR("Texture format of texture %s not recognized.", path);
-        return 0;
+        texture_image_free(image);
+        return false;
     }
 
-    uint32_t texture;
-    glGenTextures(1, &texture);
+    return true;
+}
+
+GLenum texture_get_format(int component_count) {
+    if (component_count == 1) {
+        return GL_RED;
+    } else if (component_count == 3) {
+        return GL_RGB;
+    }
+    return GL_RGBA;
+}
+
+// Gives texture the image as its storage and frees the image. Images without a cooked mip chain have theirs generated.
+void texture_upload(siren::Texture texture, const char* path, TextureImage* image) {
+    SIREN_PROFILE_SCOPE("texture_upload");
+    GLenum texture_format = texture_get_format(image->component_count);
+
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, texture_format, width, height, GL_FALSE, texture_format, GL_UNSIGNED_BYTE, data);
-    // glGenerateMipmap(GL_TEXTURE_2D);
+    for (uint32_t level = 0; level < image->mip_count; level++) {
+        int width = image->width >> level > 0 ? image->width >> level : 1;
+        int height = image->height >> level > 0 ? image->height >> level : 1;
+        glTexImage2D(GL_TEXTURE_2D, level, texture_format, width, height, GL_FALSE, texture_format, GL_UNSIGNED_BYTE, image->levels[level]);
+    }
+    if (image->mip_count == 1) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    siren::ivec2 size = siren::ivec2(image->width, image->height);
+    siren::texture_track_memory(siren::MEMORY_TAG_TEXTURE, path, texture_format, size, 1, siren::texture_get_mip_count(size), 1);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    stbi_image_free(data);
+    texture_image_free(image);
+}
+
+siren::Texture texture_load(const char* path, uint32_t handle) {
+    SIREN_PROFILE_SCOPE("texture_load");
+    TextureImage image;
+    if (!texture_decode(path, &image)) {
+        return 0;
+    }
+
+    uint32_t texture;
+    glGenTextures(1, &texture);
+    texture_upload(texture, path, &image);
+    // The image is freed, but keeps its size
+    texture_set_resident(handle, texture, texture_get_format(image.component_count), siren::ivec2(image.width, image.height), 1);
 
     return texture;
 }
 
+bool texture_load_upload(void* data) {
+    TextureLoad* load = (TextureLoad*)data;
+    // A texture that failed to decode keeps its placeholder
+    if (load->is_decoded) {
+        texture_upload(load->texture, load->path.c_str(), &load->image);
+    }
+    return true;
+}
+
+void texture_load_finish(void* data) {
+    TextureLoad* load = (TextureLoad*)data;
+    if (load->is_decoded) {
+        texture_set_resident(load->handle, load->texture, texture_get_format(load->image.component_count), siren::ivec2(load->image.width, load->image.height), 1);
+    } else {
+        /*
+         * Whoever acquired it keeps drawing the placeholder until they release it, then it's evicted like any other texture.
+         * The path is detached from the slot, so the next acquire tries again.
+         */
+        SIREN_ERROR("Texture %s failed to load.", load->path.c_str());
+        siren::texture_track_memory(siren::MEMORY_TAG_TEXTURE, load->path.c_str(), GL_RGBA, siren::ivec2(1, 1), 1, 1, 1);
+        texture_set_resident(load->handle, load->texture, GL_RGBA, siren::ivec2(1, 1), 1);
+        texture_handles.erase(load->path);
+    }
+    siren::slot_map_get(&textures, load->handle)->is_pending = false;
+    delete load;
+}
+
+void texture_load_job(void* data) {
+    TextureLoad* load = (TextureLoad*)data;
+    load->is_decoded = texture_decode(load->path.c_str(), &load->image);
+    siren::renderer_queue_upload(texture_load_upload, texture_load_finish, load);
+}
+
+siren::Texture siren::texture_acquire_async(const char* path) {
+    std::string key = std::string(path);
+    auto it = texture_handles.find(key);
+    if (it != texture_handles.end()) {
+        asset_reference(ASSET_TYPE_TEXTURE, it->second);
+        return slot_map_get(&textures, it->second)->texture;
+    }
+
+    Texture texture = renderer_reserve_texture(GL_TEXTURE_2D);
+    uint32_t handle = texture_insert(key, texture, true);
+    if (handle == SLOT_MAP_HANDLE_NULL) {
+        RendererContextScope context_scope;
+        glDeleteTextures(1, &texture);
+        return 0;
+    }
+    asset_reference(ASSET_TYPE_TEXTURE, handle);
+
+    TextureLoad* load = new TextureLoad();
+    load->path = key;
+    load->handle = handle;
+    load->texture = texture;
+    load->is_decoded = false;
+    Job job = (Job) {
+        .function = texture_load_job,
+        .data = load
+    };
+    job_run(&job, 1, NULL);
+
+    return texture;
+}
+
+bool siren::texture_is_ready(siren::Texture texture) {
+    const TextureSlot* slot = texture_find_slot(texture);
+    return slot == NULL || !slot->is_pending;
+}
+
 static std::unordered_map<uint32_t, siren::Texture> solidcolor_textures;
 
 siren::Texture siren::texture_acquire_solidcolor(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
@@ -99,11 +536,13 @@ siren::Texture siren::texture_acquire_solidcolor(uint8_t r, uint8_t g, uint8_t b
     }
 
     // Otherwise create a new one
+    RendererContextScope context_scope;
     uint32_t texture;
     glGenTextures(1, &texture);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, GL_FALSE, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+    texture_track_memory(MEMORY_TAG_TEXTURE, NULL, GL_RGBA, ivec2(1, 1), 1, 1, 1);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -120,63 +559,221 @@ siren::Texture siren::texture_acquire_solidcolor(uint8_t r, uint8_t g, uint8_t b
 #include <fstream>
 #include <unordered_map>
 #include <math.h>
-siren::Texture siren::texture_array_create(std::string name, const std::vector<std::string>& texture_paths) {
-    // Load all the image data first so that we can get the max width and height of a texture
-    std::vector<stbi_uc*> texture_data;
-    std::vector<TextureArrayInfo> texture_info;
-    int max_texture_width = 0;
-    int max_texture_height = 0;
-    for (uint32_t i = 0; i < texture_paths.size(); i++) {
-        std::string full_path = resource_get_base_path() + texture_paths[i];
-        SIREN_TRACE("Loading texture %s...", full_path.c_str());
-
-        int texture_width;
-        int texture_height;
-        int texture_component_count;
-
-        stbi_uc* data = stbi_load(full_path.c_str(), &texture_width, &texture_height, &texture_component_count, 0);
-        if (!data) {
-            SIREN_ERROR("Could not load texture %s.", full_path.c_str());
-            return 0;
+
+// Load all the image data first so that we can get the max width and height of a texture
+bool texture_array_decode(const std::vector<std::string>& paths, std::vector<TextureImage>* images, siren::ivec2* max_size) {
+    SIREN_PROFILE_SCOPE("texture_array_decode");
+    *max_size = siren::ivec2(0, 0);
+    for (uint32_t i = 0; i < paths.size(); i++) {
+        SIREN_TRACE("Loading texture %s...", paths[i].c_str());
+
+        TextureImage image;
+        if (!texture_read_image(paths[i].c_str(), &image)) {
+            SIREN_ERROR("Could not load texture %s.", paths[i].c_str());
+            for (TextureImage& decoded_image : *images) {
+                texture_image_free(&decoded_image);
+            }
+            images->clear();
+            return false;
         }
-        max_texture_width = std::max(texture_width, max_texture_width);
-        max_texture_height = std::max(texture_height, max_texture_height);
+        max_size->x = std::max(image.width, max_size->x);
+        max_size->y = std::max(image.height, max_size->y);
 
-        texture_data.push_back(data);
-        texture_info.push_back((TextureArrayInfo) {
-            .size = ivec2(texture_width, texture_height)
-        });
+        images->push_back(image);
     }
 
-    // Create the texture array
-    siren::Texture texture;
-    glGenTextures(1, &texture);
+    return true;
+}
+
+// Gives texture the decoded images as its layers and frees them
+void texture_array_upload(siren::Texture texture, const char* name, std::vector<TextureImage>& images, siren::ivec2 max_size) {
+    SIREN_PROFILE_SCOPE("texture_array_upload");
     glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, max_texture_width, max_texture_height, texture_paths.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    for (uint32_t i = 0; i < texture_data.size(); i++) {
-        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, texture_info[i].size.x, texture_info[i].size.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, texture_data[i]);
-        stbi_image_free(texture_data[i]);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, max_size.x, max_size.y, images.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    for (uint32_t i = 0; i < images.size(); i++) {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, images[i].width, images[i].height, 1, GL_RGBA, GL_UNSIGNED_BYTE, images[i].levels[0]);
+        texture_image_free(&images[i]);
     }
 
     glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    siren::texture_track_memory(siren::MEMORY_TAG_TEXTURE, name, GL_RGBA, max_size, (uint32_t)images.size(), siren::texture_get_mip_count(max_size), 1);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+std::vector<siren::TextureArrayInfo> texture_array_get_info(const std::vector<TextureImage>& images) {
+    std::vector<siren::TextureArrayInfo> texture_info;
+    for (const TextureImage& image : images) {
+        texture_info.push_back((siren::TextureArrayInfo) {
+            .size = siren::ivec2(image.width, image.height)
+        });
+    }
+    return texture_info;
+}
+
+siren::Texture siren::texture_array_create(std::string name, const std::vector<std::string>& texture_paths) {
+    SIREN_PROFILE_SCOPE("texture_array_create");
+    uint32_t handle = texture_insert(name, 0, false);
+    if (handle == SLOT_MAP_HANDLE_NULL) {
+        return 0;
+    }
+
+    RendererContextScope context_scope;
+    std::vector<TextureImage> images;
+    ivec2 max_size;
+    if (!texture_array_decode(texture_paths, &images, &max_size)) {
+        texture_remove(handle);
+        return 0;
+    }
+
+    // Create the texture array
+    siren::Texture texture;
+    glGenTextures(1, &texture);
+    texture_array_upload(texture, name.c_str(), images, max_size);
 
-    textures[name] = texture;
-    texture_array_info[texture] = texture_info;
+    slot_map_get(&textures, handle)->array_info = texture_array_get_info(images);
+    texture_set_resident(handle, texture, GL_RGBA, max_size, (uint32_t)images.size());
+    asset_reference(ASSET_TYPE_TEXTURE, handle);
 
     SIREN_INFO("Texture array loaded successfully.");
     return texture;
 }
 
+bool texture_array_load_upload(void* data) {
+    TextureArrayLoad* load = (TextureArrayLoad*)data;
+    if (load->is_decoded) {
+        texture_array_upload(load->texture, load->name.c_str(), load->images, load->max_size);
+    }
+    return true;
+}
+
+void texture_array_load_finish(void* data) {
+    TextureArrayLoad* load = (TextureArrayLoad*)data;
+    TextureSlot* slot = siren::slot_map_get(&textures, load->handle);
+    if (load->is_decoded) {
+        slot->array_info = texture_array_get_info(load->images);
+        texture_set_resident(load->handle, load->texture, GL_RGBA, load->max_size, (uint32_t)load->images.size());
+    }
+    slot->is_pending = false;
+    delete load;
+}
+
+void texture_array_load_job(void* data) {
+    TextureArrayLoad* load = (TextureArrayLoad*)data;
+    load->is_decoded = texture_array_decode(load->paths, &load->images, &load->max_size);
+    siren::renderer_queue_upload(texture_array_load_upload, texture_array_load_finish, load);
+}
+
+siren::Texture siren::texture_array_create_async(std::string name, const std::vector<std::string>& texture_paths) {
+    auto it = texture_handles.find(name);
+    if (it != texture_handles.end()) {
+        asset_reference(ASSET_TYPE_TEXTURE, it->second);
+        return slot_map_get(&textures, it->second)->texture;
+    }
+
+    Texture texture = renderer_reserve_texture(GL_TEXTURE_2D_ARRAY);
+    uint32_t handle = texture_insert(name, texture, true);
+    if (handle == SLOT_MAP_HANDLE_NULL) {
+        RendererContextScope context_scope;
+        glDeleteTextures(1, &texture);
+        return 0;
+    }
+    asset_reference(ASSET_TYPE_TEXTURE, handle);
+
+    TextureArrayLoad* load = new TextureArrayLoad();
+    load->name = name;
+    load->paths = texture_paths;
+    load->handle = handle;
+    load->texture = texture;
+    load->is_decoded = false;
+    Job job = (Job) {
+        .function = texture_array_load_job,
+        .data = load
+    };
+    job_run(&job, 1, NULL);
+
+    return texture;
+}
 bool siren::texture_is_texture_array(siren::Texture texture) {
-    return texture_array_info.find(texture) != texture_array_info.end();
+    const TextureSlot* slot = texture_find_slot(texture);
+    return slot != NULL && !slot->array_info.empty();
 }
 
 const std::vector<siren::TextureArrayInfo>& siren::texture_array_info_get(siren::Texture texture) {
-    return texture_array_info[texture];
-}
\ No newline at end of file
+    const TextureSlot* slot = texture_find_slot(texture);
+    return slot != NULL ? slot->array_info : TEXTURE_ARRAY_INFO_EMPTY;
+}
+
+uint32_t siren::texture_get_mip_count(siren::ivec2 size) {
+    uint32_t mip_count = 1;
+    int largest = size.x > size.y ? size.x : size.y;
+    while (largest > 1) {
+        largest /= 2;
+        mip_count++;
+    }
+    return mip_count;
+}
+
+// Drivers pad three component formats out to four bytes, so RGB is counted as 4
+uint32_t texture_get_bytes_per_texel(uint32_t internal_format, const char** format_name) {
+    switch (internal_format) {
+        case GL_RED:
+        case GL_R8:
+            *format_name = "R8";
+            return 1;
+        case GL_RG:
+        case GL_RG8:
+            *format_name = "RG8";
+            return 2;
+        case GL_RGB:
+        case GL_RGB8:
+            *format_name = "RGB8";
+            return 4;
+        case GL_RGBA:
+        case GL_RGBA8:
+            *format_name = "RGBA8";
+            return 4;
+        case GL_RGBA16:
+            *format_name = "RGBA16";
+            return 8;
+        case GL_DEPTH24_STENCIL8:
+            *format_name = "D24S8";
+            return 4;
+        default:
+            *format_name = "other";
+            return 4;
+    }
+}
+
+size_t texture_get_level_memory_size(uint64_t bytes_per_texel, siren::ivec2 size, uint32_t level, uint32_t layers, uint32_t samples) {
+    uint64_t width = (uint64_t)(size.x >> level > 0 ? size.x >> level : 1);
+    uint64_t height = (uint64_t)(size.y >> level > 0 ? size.y >> level : 1);
+    return (size_t)(width * height * layers * samples * bytes_per_texel);
+}
+
+uint64_t siren::texture_get_memory_size(uint32_t internal_format, siren::ivec2 size, uint32_t layers, uint32_t mip_count, uint32_t samples) {
+    const char* format_name;
+    uint64_t bytes_per_texel = texture_get_bytes_per_texel(internal_format, &format_name);
+    uint64_t bytes = 0;
+    for (uint32_t level = 0; level < mip_count; level++) {
+        bytes += texture_get_level_memory_size(bytes_per_texel, size, level, layers, samples);
+    }
+    return bytes;
+}
+
+void siren::texture_track_memory(siren::MemoryTag tag, const char* asset, uint32_t internal_format, siren::ivec2 size, uint32_t layers, uint32_t mip_count, uint32_t samples, bool is_free) {
+    const char* format_name;
+    uint64_t bytes_per_texel = texture_get_bytes_per_texel(internal_format, &format_name);
+    for (uint32_t level = 0; level < mip_count; level++) {
+        size_t bytes = texture_get_level_memory_size(bytes_per_texel, size, level, layers, samples);
+        if (is_free) {
+            memory_track_texture_free(tag, asset, format_name, level, bytes);
+        } else {
+            memory_track_texture_alloc(tag, asset, format_name, level, bytes);
+        }
+    }
+}
@@ -3,6 +3,8 @@
 #include "defines.h"
 
 #include "math/vector2.h"
+#include "core/memory.h"
+#include "core/cook.h"
 
 #include <vector>
 #include <string>
@@ -12,12 +14,37 @@ namespace siren {
 
     SIREN_API Texture texture_acquire(const char* path);
     SIREN_API Texture texture_acquire_solidcolor(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+    /*
+     * Starts loading a texture on a worker thread and returns it straight away. It's a 1x1 grey placeholder until the load
+     * finishes, and stays one if the load fails. Acquiring a path that is still loading returns the same placeholder.
+     */
+    SIREN_API Texture texture_acquire_async(const char* path);
+    // False while an async load of the texture is still in flight
+    SIREN_API bool texture_is_ready(Texture texture);
+    /*
+     * Drops a reference taken by texture_acquire, texture_acquire_async or either texture_array_create. A texture with no
+     * references stays loaded until it's evicted to stay under the VRAM budget, see asset.h. Acquiring it again after
+     * that loads it again, under a new name. Releasing a solid color does nothing, they're shared and never evicted.
+     */
+    SIREN_API void texture_release(Texture texture);
+    // Deletes a loaded texture, called by the asset system
+    void texture_evict(uint32_t handle);
+    // Writes the cached copy of an image, with its full mip chain, without loading it. See cook.h. Safe to call from any thread.
+    SIREN_API CookResult texture_cook(const char* path);
 
     struct TextureArrayInfo {
         ivec2 size;
     };
 
     SIREN_API Texture texture_array_create(std::string name, const std::vector<std::string>& texture_paths);
+    // Like texture_acquire_async, but for texture_array_create. Array info is empty until the load finishes.
+    SIREN_API Texture texture_array_create_async(std::string name, const std::vector<std::string>& texture_paths);
     SIREN_API bool texture_is_texture_array(siren::Texture texture);
     SIREN_API const std::vector<TextureArrayInfo>& texture_array_info_get(siren::Texture texture);
+
+    uint32_t texture_get_mip_count(ivec2 size);
+    // Bytes of storage a texture with these levels holds, counted the same way as texture_track_memory
+    uint64_t texture_get_memory_size(uint32_t internal_format, ivec2 size, uint32_t layers, uint32_t mip_count, uint32_t samples);
+    // Records a texture's storage with the memory tracker, one entry per mip level. Call again with is_free set when the texture is deleted.
+    void texture_track_memory(MemoryTag tag, const char* asset, uint32_t internal_format, ivec2 size, uint32_t layers, uint32_t mip_count, uint32_t samples, bool is_free = false);
 }
\ No newline at end of file
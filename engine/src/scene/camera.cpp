@@ -7,6 +7,9 @@ siren::Camera::Camera() {
     pitch = 0.0f;
     yaw = -90.0f;
     view_matrix = mat4(1.0f);
+    late_latch = false;
+    late_latch_pitch_per_pixel = 0.0f;
+    late_latch_yaw_per_pixel = 0.0f;
     // default to true to force an initial calculation when we first render
     dirty = true;
 }
@@ -76,4 +79,34 @@ siren::mat4 siren::Camera::get_view_matrix() {
         dirty = false;
     }
     return view_matrix;
-}
\ No newline at end of file
+}
+
+siren::mat4 siren::Camera::get_view_matrix_with_offset(float pitch_offset, float yaw_offset) const {
+    float yaw_radians = deg_to_rad(yaw + yaw_offset);
+    float pitch_radians = deg_to_rad(clampf(pitch + pitch_offset, -89.0f, 89.0f));
+
+    vec3 offset_forward = vec3(
+        cos(yaw_radians) * cos(pitch_radians),
+        sin(pitch_radians),
+        sin(yaw_radians) * cos(pitch_radians)
+    ).normalized();
+    return mat4::look_at(position, position + offset_forward, up);
+}
+
+void siren::Camera::set_late_latch(bool enabled, float pitch_per_pixel, float yaw_per_pixel) {
+    late_latch = enabled;
+    late_latch_pitch_per_pixel = pitch_per_pixel;
+    late_latch_yaw_per_pixel = yaw_per_pixel;
+}
+
+bool siren::Camera::is_late_latched() const {
+    return late_latch;
+}
+
+float siren::Camera::get_late_latch_pitch_per_pixel() const {
+    return late_latch_pitch_per_pixel;
+}
+
+float siren::Camera::get_late_latch_yaw_per_pixel() const {
+    return late_latch_yaw_per_pixel;
+}
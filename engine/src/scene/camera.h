@@ -31,6 +31,18 @@ namespace siren {
          * This will recalculate the matrix if the camera's values have changed.
          */
         SIREN_API mat4 get_view_matrix();
+        // Returns the view matrix as if pitch and yaw (in degrees) were offset by the given amounts, without changing the camera
+        SIREN_API mat4 get_view_matrix_with_offset(float pitch_offset, float yaw_offset) const;
+
+        /*
+         * With late latching on, the renderer adds any mouse motion that arrived after the frame's update to the pitch and yaw
+         * just before the frame is submitted. The sensitivities should match what the game passes to apply_pitch() and apply_yaw() per pixel.
+         * Only applies while the mouse is in relative mode.
+         */
+        SIREN_API void set_late_latch(bool enabled, float pitch_per_pixel, float yaw_per_pixel);
+        SIREN_API bool is_late_latched() const;
+        SIREN_API float get_late_latch_pitch_per_pixel() const;
+        SIREN_API float get_late_latch_yaw_per_pixel() const;
     private:
         vec3 position;
         vec3 forward;
@@ -40,5 +52,9 @@ namespace siren {
 
         bool dirty;
         mat4 view_matrix;
+
+        bool late_latch;
+        float late_latch_pitch_per_pixel;
+        float late_latch_yaw_per_pixel;
     };
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include <core/logger.h>
+
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+static const size_t DECODER_LINE_LENGTH = 2048;
+
+static const char* DECODER_LEVEL_NAMES[4] = { "error", "warn", "info", "trace" };
+
+struct DecoderOptions {
+    const char* input_path;
+    const char* output_path;
+    siren::LogLevel max_level;
+    // Bit per LogCategory, everything when no --category is given
+    uint32_t category_mask;
+};
+
+bool decoder_parse_level(const char* name, siren::LogLevel* level) {
+    for (uint32_t index = 0; index < 4; index++) {
+        if (strcmp(name, DECODER_LEVEL_NAMES[index]) == 0) {
+            *level = (siren::LogLevel)index;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool decoder_parse_category(const char* name, siren::LogCategory* category) {
+    for (uint32_t index = 0; index < siren::LOG_CATEGORY_COUNT; index++) {
+        if (strcmp(name, siren::logger_category_name((siren::LogCategory)index)) == 0) {
+            *category = (siren::LogCategory)index;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool decoder_run(const DecoderOptions& options) {
+    FILE* input = fopen(options.input_path, "rb");
+    if (input == NULL) {
+        printf("Unable to open %s\n", options.input_path);
+        return false;
+    }
+    FILE* output = stdout;
+    if (options.output_path != NULL) {
+        output = fopen(options.output_path, "w");
+        if (output == NULL) {
+            printf("Unable to open %s for writing\n", options.output_path);
+            fclose(input);
+            return false;
+        }
+    }
+
+    char magic[sizeof(siren::LOG_BINARY_MAGIC)];
+    uint32_t version;
+    if (fread(magic, 1, sizeof(magic), input) != sizeof(magic) || memcmp(magic, siren::LOG_BINARY_MAGIC, sizeof(magic)) != 0 ||
+            fread(&version, sizeof(version), 1, input) != 1) {
+        printf("%s is not a binary log\n", options.input_path);
+        fclose(input);
+        return false;
+    }
+    if (version != siren::LOG_BINARY_VERSION) {
+        printf("%s is version %u, expected version %u\n", options.input_path, version, siren::LOG_BINARY_VERSION);
+        fclose(input);
+        return false;
+    }
+
+    std::unordered_map<uint64_t, std::string> messages;
+    std::vector<uint8_t> args;
+    char line[DECODER_LINE_LENGTH];
+    uint32_t record_count = 0;
+    bool is_truncated = false;
+
+    while (true) {
+        uint8_t entry;
+        if (fread(&entry, sizeof(entry), 1, input) != 1) {
+            break;
+        }
+
+        if (entry == siren::LOG_BINARY_ENTRY_FORMAT) {
+            siren::LogBinaryFormat format;
+            if (fread(&format, sizeof(format), 1, input) != 1) {
+                is_truncated = true;
+                break;
+            }
+            std::string message(format.length, '\0');
+            if (fread(&message[0], 1, format.length, input) != format.length) {
+                is_truncated = true;
+                break;
+            }
+            messages[format.message_id] = message;
+        } else if (entry == siren::LOG_BINARY_ENTRY_RECORD) {
+            siren::LogBinaryRecord record;
+            if (fread(&record, sizeof(record), 1, input) != 1) {
+                is_truncated = true;
+                break;
+            }
+            args.resize(record.args_size);
+            if (record.args_size != 0 && fread(args.data(), 1, record.args_size, input) != record.args_size) {
+                is_truncated = true;
+                break;
+            }
+
+            auto it = messages.find(record.message_id);
+            if (it == messages.end() || record.level > siren::LOG_LEVEL_TRACE || record.category >= siren::LOG_CATEGORY_COUNT) {
+                printf("Record %u is not valid, the log is corrupt\n", record_count);
+                break;
+            }
+            if (record.level > options.max_level || (options.category_mask & (1u << record.category)) == 0) {
+                continue;
+            }
+            siren::logger_format_record(line, sizeof(line), (siren::LogLevel)record.level, (siren::LogCategory)record.category, it->second.c_str(), args.data(), args.size());
+            fputs(line, output);
+            record_count++;
+        } else {
+            printf("Unknown entry type %u, the log is corrupt\n", entry);
+            break;
+        }
+    }
+
+    // A log from a process that crashed can end partway through an entry
+    if (is_truncated) {
+        printf("%s ends partway through an entry, the last record was lost\n", options.input_path);
+    }
+
+    fclose(input);
+    if (output != stdout) {
+        fclose(output);
+        printf("Decoded %u records into %s\n", record_count, options.output_path);
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    DecoderOptions options = (DecoderOptions) {
+        .input_path = "console.bin",
+        .output_path = NULL,
+        .max_level = siren::LOG_LEVEL_TRACE,
+        .category_mask = 0
+    };
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--out") == 0 && arg + 1 < argc) {
+            options.output_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--level") == 0 && arg + 1 < argc) {
+            if (!decoder_parse_level(argv[++arg], &options.max_level)) {
+                printf("Unknown level %s\n", argv[arg]);
+                return -1;
+            }
+        } else if (strcmp(argv[arg], "--category") == 0 && arg + 1 < argc) {
+            siren::LogCategory category;
+            if (!decoder_parse_category(argv[++arg], &category)) {
+                printf("Unknown category %s\n", argv[arg]);
+                return -1;
+            }
+            options.category_mask |= 1u << category;
+        } else if (argv[arg][0] != '-') {
+            options.input_path = argv[arg];
+        } else {
+            printf("Usage: log-decoder [console.bin] [--out console.log] [--level error|warn|info|trace] [--category name]...\n");
+            return -1;
+        }
+    }
+    if (options.category_mask == 0) {
+        options.category_mask = UINT32_MAX;
+    }
+
+    return decoder_run(options) ? 0 : -1;
+}
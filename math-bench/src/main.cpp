@@ -0,0 +1,828 @@
+#include <math/math.h>
+#include <math/vector3.h>
+#include <math/vector4.h>
+#include <math/matrix.h>
+#include <math/quaternion.h>
+#include <math/affine.h>
+#include <math/transform.h>
+#include <math/simd.h>
+#include <core/resource.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const double MATH_BENCH_NANOSECONDS = 1000000000.0;
+/*
+ * Hash of the kernel results from bench_kernel_hash. Every SIMD path does the same IEEE operations in the same order as
+ * the scalar one, so SSE, AVX2, NEON and SIREN_SIMD_DISABLE builds must all give exactly this. When a kernel changes on
+ * purpose, check that a SIREN_SIMD_DISABLE build and a SIMD build agree on the new hash before updating it.
+ */
+static const uint64_t MATH_BENCH_KERNEL_HASH = 0xe7872beb9c6a38ffULL;
+// Not a multiple of 4, so the batch functions' leftover path is hashed too
+static const uint32_t MATH_BENCH_KERNEL_INPUT_COUNT = 259;
+
+struct MathBenchOptions {
+    // Random inputs per operation, which is also how many results are checked
+    uint32_t count;
+    // Timed passes over the inputs for siren and glm each. The fastest is reported, since slower ones were interrupted.
+    uint32_t passes;
+    uint32_t seed;
+    const char* output_path;
+    // Results of an earlier run to compare timings against
+    const char* baseline_path;
+    // Fraction siren's time may grow by over the baseline before it counts as a regression
+    double time_tolerance;
+    // Only check the kernel hash, skipping the comparison against glm
+    bool is_kernel_check_only;
+};
+
+enum MathBenchOutput {
+    MATH_BENCH_OUTPUT_MAT4,
+    // Checked against the top three rows of the glm mat4 results
+    MATH_BENCH_OUTPUT_AFFINE,
+    MATH_BENCH_OUTPUT_QUAT,
+    MATH_BENCH_OUTPUT_VEC3,
+    MATH_BENCH_OUTPUT_VEC4
+};
+
+struct MathBenchOp {
+    const char* name;
+    MathBenchOutput output;
+    void (*run_siren)();
+    void (*run_glm)();
+    // Largest error against glm that still passes, in ULPs of the result's largest component
+    float max_ulps;
+};
+
+struct MathBenchResult {
+    const MathBenchOp* op;
+    double siren_ns;
+    double glm_ns;
+    float max_ulps;
+    float mean_ulps;
+    uint32_t worst_index;
+    bool is_accurate;
+    // Only set when a baseline was given and has this op
+    double baseline_ns;
+    bool is_regressed;
+};
+
+// Every input exists in both libraries' types with the same values
+struct MathBenchState {
+    uint32_t count;
+
+    std::vector<siren::mat4> siren_matrices_a;
+    std::vector<siren::mat4> siren_matrices_b;
+    std::vector<siren::affine3x4> siren_affines_a;
+    std::vector<siren::affine3x4> siren_affines_b;
+    std::vector<siren::quat> siren_quats_a;
+    std::vector<siren::quat> siren_quats_b;
+    std::vector<siren::vec3> siren_vectors_a;
+    std::vector<siren::vec3> siren_vectors_b;
+    std::vector<siren::vec4> siren_vectors4;
+    std::vector<siren::Transform> siren_transforms;
+    std::vector<glm::mat4> glm_matrices_a;
+    std::vector<glm::mat4> glm_matrices_b;
+    std::vector<glm::quat> glm_quats_a;
+    std::vector<glm::quat> glm_quats_b;
+    std::vector<glm::vec3> glm_vectors_a;
+    std::vector<glm::vec3> glm_vectors_b;
+    std::vector<glm::vec4> glm_vectors4;
+    // Interpolation percentages, angles and projection parameters
+    std::vector<float> scalars_a;
+    std::vector<float> scalars_b;
+    std::vector<float> scalars_c;
+    std::vector<float> scalars_d;
+    // The transforms again, split into components for transform_batch_to_mat4
+    std::vector<float> batch_components[10];
+
+    std::vector<siren::mat4> siren_mat4_results;
+    std::vector<siren::affine3x4> siren_affine_results;
+    std::vector<siren::quat> siren_quat_results;
+    std::vector<siren::vec3> siren_vec3_results;
+    std::vector<siren::vec4> siren_vec4_results;
+    std::vector<glm::mat4> glm_mat4_results;
+    std::vector<glm::quat> glm_quat_results;
+    std::vector<glm::vec3> glm_vec3_results;
+    std::vector<glm::vec4> glm_vec4_results;
+};
+static MathBenchState state;
+
+glm::mat4 bench_to_glm(const siren::mat4& matrix) {
+    glm::mat4 result;
+    for (uint32_t column = 0; column < 4; column++) {
+        for (uint32_t row = 0; row < 4; row++) {
+            result[column][row] = matrix[column][row];
+        }
+    }
+    return result;
+}
+
+// glm takes w first
+glm::quat bench_to_glm(const siren::quat& rotation) {
+    return glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+}
+
+glm::vec3 bench_to_glm(const siren::vec3& vector) {
+    return glm::vec3(vector.x, vector.y, vector.z);
+}
+
+glm::vec4 bench_to_glm(const siren::vec4& vector) {
+    return glm::vec4(vector.x, vector.y, vector.z, vector.w);
+}
+
+void bench_generate_inputs(uint32_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> percentage(0.0f, 1.0f);
+
+    state.count = count;
+    for (uint32_t index = 0; index < count; index++) {
+        // Matrices are built from transforms so that they're invertible and not badly conditioned
+        siren::Transform transforms[2];
+        for (uint32_t side = 0; side < 2; side++) {
+            transforms[side] = (siren::Transform) {
+                .position = siren::vec3(unit(random), unit(random), unit(random)) * 10.0f,
+                .rotation = siren::quat(unit(random), unit(random), unit(random), unit(random)).normalized(),
+                .scale = siren::vec3(1.25f + (unit(random) * 0.75f), 1.25f + (unit(random) * 0.75f), 1.25f + (unit(random) * 0.75f))
+            };
+        }
+        state.siren_transforms.push_back(transforms[0]);
+        state.siren_matrices_a.push_back(transforms[0].to_mat4());
+        state.siren_matrices_b.push_back(transforms[1].to_mat4());
+        state.siren_affines_a.push_back(siren::affine3x4::from_mat4(state.siren_matrices_a.back()));
+        state.siren_affines_b.push_back(siren::affine3x4::from_mat4(state.siren_matrices_b.back()));
+        state.siren_quats_a.push_back(transforms[0].rotation);
+        state.siren_quats_b.push_back(transforms[1].rotation);
+        state.siren_vectors_a.push_back(transforms[0].position);
+        state.siren_vectors_b.push_back(transforms[1].position);
+        state.siren_vectors4.push_back(siren::vec4(unit(random), unit(random), unit(random), unit(random)) * 10.0f);
+
+        state.scalars_a.push_back(percentage(random));
+        state.scalars_b.push_back(0.1f + percentage(random));
+        state.scalars_c.push_back(0.01f + percentage(random));
+        state.scalars_d.push_back(10.0f + (percentage(random) * 990.0f));
+
+        float batch_values[10] = {
+            transforms[0].position.x, transforms[0].position.y, transforms[0].position.z,
+            transforms[0].rotation.x, transforms[0].rotation.y, transforms[0].rotation.z, transforms[0].rotation.w,
+            transforms[0].scale.x, transforms[0].scale.y, transforms[0].scale.z
+        };
+        for (uint32_t component = 0; component < 10; component++) {
+            state.batch_components[component].push_back(batch_values[component]);
+        }
+    }
+
+    for (uint32_t index = 0; index < count; index++) {
+        state.glm_matrices_a.push_back(bench_to_glm(state.siren_matrices_a[index]));
+        state.glm_matrices_b.push_back(bench_to_glm(state.siren_matrices_b[index]));
+        state.glm_quats_a.push_back(bench_to_glm(state.siren_quats_a[index]));
+        state.glm_quats_b.push_back(bench_to_glm(state.siren_quats_b[index]));
+        state.glm_vectors_a.push_back(bench_to_glm(state.siren_vectors_a[index]));
+        state.glm_vectors_b.push_back(bench_to_glm(state.siren_vectors_b[index]));
+        state.glm_vectors4.push_back(bench_to_glm(state.siren_vectors4[index]));
+    }
+
+    state.siren_mat4_results.resize(count);
+    state.siren_affine_results.resize(count);
+    state.siren_quat_results.resize(count);
+    state.siren_vec3_results.resize(count);
+    state.siren_vec4_results.resize(count);
+    state.glm_mat4_results.resize(count);
+    state.glm_quat_results.resize(count);
+    state.glm_vec3_results.resize(count);
+    state.glm_vec4_results.resize(count);
+}
+
+void bench_siren_mat4_multiply() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = state.siren_matrices_a[index] * state.siren_matrices_b[index];
+    }
+}
+
+void bench_glm_mat4_multiply() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = state.glm_matrices_a[index] * state.glm_matrices_b[index];
+    }
+}
+
+void bench_siren_mat4_inverse() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = state.siren_matrices_a[index].inversed();
+    }
+}
+
+void bench_glm_mat4_inverse() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = glm::inverse(state.glm_matrices_a[index]);
+    }
+}
+
+void bench_siren_affine_multiply() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_affine_results[index] = state.siren_affines_a[index] * state.siren_affines_b[index];
+    }
+}
+
+void bench_siren_affine_inverse() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_affine_results[index] = state.siren_affines_a[index].inversed();
+    }
+}
+
+void bench_siren_mat4_perspective() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = siren::mat4::perspective(state.scalars_a[index] + 0.5f, state.scalars_b[index] * 2.0f, state.scalars_c[index], state.scalars_d[index]);
+    }
+}
+
+void bench_glm_mat4_perspective() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = glm::perspective(state.scalars_a[index] + 0.5f, state.scalars_b[index] * 2.0f, state.scalars_c[index], state.scalars_d[index]);
+    }
+}
+
+void bench_siren_mat4_look_at() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = siren::mat4::look_at(state.siren_vectors_a[index], state.siren_vectors_b[index], siren::vec3(0.0f, 1.0f, 0.0f));
+    }
+}
+
+void bench_glm_mat4_look_at() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = glm::lookAt(state.glm_vectors_a[index], state.glm_vectors_b[index], glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+}
+
+void bench_siren_mat4_translate() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = siren::mat4::translate(state.siren_vectors_a[index]);
+    }
+}
+
+void bench_glm_mat4_translate() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = glm::translate(glm::mat4(1.0f), state.glm_vectors_a[index]);
+    }
+}
+
+void bench_siren_mat4_scale() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = siren::mat4::scale(state.siren_vectors_a[index]);
+    }
+}
+
+void bench_glm_mat4_scale() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = glm::scale(glm::mat4(1.0f), state.glm_vectors_a[index]);
+    }
+}
+
+void bench_siren_mat4_rotate() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = siren::mat4::rotate(state.scalars_a[index] * SIREN_PI, state.siren_vectors_a[index].normalized());
+    }
+}
+
+void bench_glm_mat4_rotate() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = glm::rotate(glm::mat4(1.0f), state.scalars_a[index] * SIREN_PI, glm::normalize(state.glm_vectors_a[index]));
+    }
+}
+
+void bench_siren_quat_multiply() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_quat_results[index] = state.siren_quats_a[index] * state.siren_quats_b[index];
+    }
+}
+
+void bench_glm_quat_multiply() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_quat_results[index] = state.glm_quats_a[index] * state.glm_quats_b[index];
+    }
+}
+
+void bench_siren_quat_to_mat4() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = state.siren_quats_a[index].to_mat4();
+    }
+}
+
+void bench_glm_quat_to_mat4() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_mat4_results[index] = glm::mat4_cast(state.glm_quats_a[index]);
+    }
+}
+
+// Matrices are rebuilt from the quaternions, so there's no scale for either side to take out
+void bench_siren_quat_from_mat4() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_quat_results[index] = siren::quat::from_mat4(state.siren_quats_b[index].to_mat4());
+    }
+}
+
+void bench_glm_quat_from_mat4() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_quat_results[index] = glm::quat_cast(glm::mat4_cast(state.glm_quats_b[index]));
+    }
+}
+
+void bench_siren_quat_slerp() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_quat_results[index] = siren::quat::slerp(state.siren_quats_a[index], state.siren_quats_b[index], state.scalars_a[index]);
+    }
+}
+
+void bench_glm_quat_slerp() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_quat_results[index] = glm::slerp(state.glm_quats_a[index], state.glm_quats_b[index], state.scalars_a[index]);
+    }
+}
+
+void bench_siren_quat_from_axis_angle() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_quat_results[index] = siren::quat::from_axis_angle(state.siren_vectors_a[index].normalized(), state.scalars_a[index] * SIREN_PI, false);
+    }
+}
+
+void bench_glm_quat_from_axis_angle() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_quat_results[index] = glm::angleAxis(state.scalars_a[index] * SIREN_PI, glm::normalize(state.glm_vectors_a[index]));
+    }
+}
+
+void bench_siren_quat_from_euler() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        const siren::vec3& angles = state.siren_vectors_a[index];
+        state.siren_quat_results[index] = siren::quat::from_euler(angles.x * 0.3f, angles.y * 0.3f, angles.z * 0.3f);
+    }
+}
+
+void bench_glm_quat_from_euler() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_quat_results[index] = glm::quat(state.glm_vectors_a[index] * 0.3f);
+    }
+}
+
+void bench_siren_vec3_normalize() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_vec3_results[index] = state.siren_vectors_a[index].normalized();
+    }
+}
+
+void bench_glm_vec3_normalize() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_vec3_results[index] = glm::normalize(state.glm_vectors_a[index]);
+    }
+}
+
+void bench_siren_vec3_cross() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_vec3_results[index] = siren::vec3::cross(state.siren_vectors_a[index], state.siren_vectors_b[index]);
+    }
+}
+
+void bench_glm_vec3_cross() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_vec3_results[index] = glm::cross(state.glm_vectors_a[index], state.glm_vectors_b[index]);
+    }
+}
+
+void bench_siren_vec4_normalize() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_vec4_results[index] = state.siren_vectors4[index].normalized();
+    }
+}
+
+void bench_glm_vec4_normalize() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.glm_vec4_results[index] = glm::normalize(state.glm_vectors4[index]);
+    }
+}
+
+void bench_siren_transform_to_mat4() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        state.siren_mat4_results[index] = state.siren_transforms[index].to_mat4();
+    }
+}
+
+void bench_siren_transform_batch_to_mat4() {
+    siren::TransformBatch batch = (siren::TransformBatch) {
+        .position_x = state.batch_components[0].data(),
+        .position_y = state.batch_components[1].data(),
+        .position_z = state.batch_components[2].data(),
+        .rotation_x = state.batch_components[3].data(),
+        .rotation_y = state.batch_components[4].data(),
+        .rotation_z = state.batch_components[5].data(),
+        .rotation_w = state.batch_components[6].data(),
+        .scale_x = state.batch_components[7].data(),
+        .scale_y = state.batch_components[8].data(),
+        .scale_z = state.batch_components[9].data(),
+        .count = state.count
+    };
+    siren::transform_batch_to_mat4(batch, state.siren_mat4_results.data());
+}
+
+void bench_siren_transform_batch_to_affine3x4() {
+    siren::TransformBatch batch = (siren::TransformBatch) {
+        .position_x = state.batch_components[0].data(),
+        .position_y = state.batch_components[1].data(),
+        .position_z = state.batch_components[2].data(),
+        .rotation_x = state.batch_components[3].data(),
+        .rotation_y = state.batch_components[4].data(),
+        .rotation_z = state.batch_components[5].data(),
+        .rotation_w = state.batch_components[6].data(),
+        .scale_x = state.batch_components[7].data(),
+        .scale_y = state.batch_components[8].data(),
+        .scale_z = state.batch_components[9].data(),
+        .count = state.count
+    };
+    siren::transform_batch_to_affine3x4(batch, state.siren_affine_results.data());
+}
+
+void bench_glm_transform_to_mat4() {
+    for (uint32_t index = 0; index < state.count; index++) {
+        const siren::Transform& transform = state.siren_transforms[index];
+        state.glm_mat4_results[index] = glm::translate(glm::mat4(1.0f), bench_to_glm(transform.position)) * glm::mat4_cast(bench_to_glm(transform.rotation)) * glm::scale(glm::mat4(1.0f), bench_to_glm(transform.scale));
+    }
+}
+
+// xorshift32 scaled to [-1, 1) with exact float math, so the kernel inputs don't depend on the standard library
+float bench_kernel_random(uint32_t* seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return ((float)(*seed >> 8) * (2.0f / 16777216.0f)) - 1.0f;
+}
+
+template <typename T>
+void bench_kernel_append(std::vector<uint8_t>* results, const T& value) {
+    const uint8_t* bytes = (const uint8_t*)&value;
+    results->insert(results->end(), bytes, bytes + sizeof(value));
+}
+
+// Runs every SIMD kernel over fixed inputs and hashes the exact bits that come out
+uint64_t bench_kernel_hash() {
+    uint32_t seed = 0x12345678;
+    std::vector<uint8_t> results;
+    std::vector<float> batch_components[10];
+    for (uint32_t index = 0; index < MATH_BENCH_KERNEL_INPUT_COUNT; index++) {
+        // The diagonal keeps the matrices well away from singular
+        siren::mat4 matrices[2];
+        for (uint32_t side = 0; side < 2; side++) {
+            for (uint32_t element = 0; element < 16; element++) {
+                matrices[side][element / 4][element % 4] = bench_kernel_random(&seed) + (element % 5 == 0 ? 2.0f : 0.0f);
+            }
+        }
+        siren::quat rotations[2];
+        for (uint32_t side = 0; side < 2; side++) {
+            rotations[side] = siren::quat(bench_kernel_random(&seed), bench_kernel_random(&seed), bench_kernel_random(&seed), bench_kernel_random(&seed));
+        }
+        siren::vec4 vectors[2];
+        for (uint32_t side = 0; side < 2; side++) {
+            vectors[side] = siren::vec4(bench_kernel_random(&seed), bench_kernel_random(&seed), bench_kernel_random(&seed), bench_kernel_random(&seed));
+        }
+        float scalar = bench_kernel_random(&seed) + 2.0f;
+        siren::Transform transform = (siren::Transform) {
+            .position = siren::vec3(bench_kernel_random(&seed), bench_kernel_random(&seed), bench_kernel_random(&seed)),
+            .rotation = rotations[0].normalized(),
+            .scale = siren::vec3(bench_kernel_random(&seed), bench_kernel_random(&seed), bench_kernel_random(&seed)) + siren::vec3(2.0f)
+        };
+        float batch_values[10] = {
+            transform.position.x, transform.position.y, transform.position.z,
+            transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w,
+            transform.scale.x, transform.scale.y, transform.scale.z
+        };
+        for (uint32_t component = 0; component < 10; component++) {
+            batch_components[component].push_back(batch_values[component]);
+        }
+
+        siren::affine3x4 affines[2] = { siren::affine3x4::from_mat4(transform.to_mat4()), siren::affine3x4::from_mat4(matrices[1]) };
+        bench_kernel_append(&results, matrices[0] * matrices[1]);
+        bench_kernel_append(&results, matrices[0].inversed());
+        bench_kernel_append(&results, rotations[0] * rotations[1]);
+        bench_kernel_append(&results, rotations[0].to_mat4());
+        bench_kernel_append(&results, vectors[0] + vectors[1]);
+        bench_kernel_append(&results, vectors[0] - vectors[1]);
+        bench_kernel_append(&results, vectors[0] * scalar);
+        bench_kernel_append(&results, vectors[0] / scalar);
+        bench_kernel_append(&results, vectors[0].normalized());
+        bench_kernel_append(&results, transform.to_mat4());
+        bench_kernel_append(&results, affines[0] * affines[1]);
+        bench_kernel_append(&results, affines[0].inversed());
+        bench_kernel_append(&results, affines[1].to_mat4());
+    }
+
+    siren::TransformBatch batch = (siren::TransformBatch) {
+        .position_x = batch_components[0].data(),
+        .position_y = batch_components[1].data(),
+        .position_z = batch_components[2].data(),
+        .rotation_x = batch_components[3].data(),
+        .rotation_y = batch_components[4].data(),
+        .rotation_z = batch_components[5].data(),
+        .rotation_w = batch_components[6].data(),
+        .scale_x = batch_components[7].data(),
+        .scale_y = batch_components[8].data(),
+        .scale_z = batch_components[9].data(),
+        .count = MATH_BENCH_KERNEL_INPUT_COUNT
+    };
+    std::vector<siren::mat4> batch_matrices(MATH_BENCH_KERNEL_INPUT_COUNT);
+    std::vector<siren::affine3x4> batch_affines(MATH_BENCH_KERNEL_INPUT_COUNT);
+    siren::transform_batch_to_mat4(batch, batch_matrices.data());
+    siren::transform_batch_to_affine3x4(batch, batch_affines.data());
+    for (uint32_t index = 0; index < MATH_BENCH_KERNEL_INPUT_COUNT; index++) {
+        bench_kernel_append(&results, batch_matrices[index]);
+        bench_kernel_append(&results, batch_affines[index]);
+    }
+
+    return siren::resource_hash(results.data(), results.size());
+}
+
+const char* bench_simd_path() {
+#if defined(SIREN_SIMD_AVX2)
+    return "avx2";
+#elif defined(SIREN_SIMD_SSE)
+    return "sse";
+#elif defined(SIREN_SIMD_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+// Limits are about twice the worst error the current kernels show over several seeds, so that only real changes fail
+static const MathBenchOp MATH_BENCH_OPS[] = {
+    { "mat4_multiply", MATH_BENCH_OUTPUT_MAT4, &bench_siren_mat4_multiply, &bench_glm_mat4_multiply, 2.0f },
+    { "mat4_inverse", MATH_BENCH_OUTPUT_MAT4, &bench_siren_mat4_inverse, &bench_glm_mat4_inverse, 16.0f },
+    { "affine_multiply", MATH_BENCH_OUTPUT_AFFINE, &bench_siren_affine_multiply, &bench_glm_mat4_multiply, 2.0f },
+    { "affine_inverse", MATH_BENCH_OUTPUT_AFFINE, &bench_siren_affine_inverse, &bench_glm_mat4_inverse, 16.0f },
+    { "mat4_perspective", MATH_BENCH_OUTPUT_MAT4, &bench_siren_mat4_perspective, &bench_glm_mat4_perspective, 8.0f },
+    { "mat4_look_at", MATH_BENCH_OUTPUT_MAT4, &bench_siren_mat4_look_at, &bench_glm_mat4_look_at, 12.0f },
+    { "mat4_translate", MATH_BENCH_OUTPUT_MAT4, &bench_siren_mat4_translate, &bench_glm_mat4_translate, 0.0f },
+    { "mat4_scale", MATH_BENCH_OUTPUT_MAT4, &bench_siren_mat4_scale, &bench_glm_mat4_scale, 0.0f },
+    { "mat4_rotate", MATH_BENCH_OUTPUT_MAT4, &bench_siren_mat4_rotate, &bench_glm_mat4_rotate, 12.0f },
+    { "quat_multiply", MATH_BENCH_OUTPUT_QUAT, &bench_siren_quat_multiply, &bench_glm_quat_multiply, 4.0f },
+    { "quat_to_mat4", MATH_BENCH_OUTPUT_MAT4, &bench_siren_quat_to_mat4, &bench_glm_quat_to_mat4, 2.0f },
+    { "quat_from_mat4", MATH_BENCH_OUTPUT_QUAT, &bench_siren_quat_from_mat4, &bench_glm_quat_from_mat4, 4.0f },
+    { "quat_slerp", MATH_BENCH_OUTPUT_QUAT, &bench_siren_quat_slerp, &bench_glm_quat_slerp, 8.0f },
+    { "quat_from_axis_angle", MATH_BENCH_OUTPUT_QUAT, &bench_siren_quat_from_axis_angle, &bench_glm_quat_from_axis_angle, 4.0f },
+    { "quat_from_euler", MATH_BENCH_OUTPUT_QUAT, &bench_siren_quat_from_euler, &bench_glm_quat_from_euler, 8.0f },
+    { "vec3_normalize", MATH_BENCH_OUTPUT_VEC3, &bench_siren_vec3_normalize, &bench_glm_vec3_normalize, 4.0f },
+    { "vec3_cross", MATH_BENCH_OUTPUT_VEC3, &bench_siren_vec3_cross, &bench_glm_vec3_cross, 2.0f },
+    { "vec4_normalize", MATH_BENCH_OUTPUT_VEC4, &bench_siren_vec4_normalize, &bench_glm_vec4_normalize, 4.0f },
+    { "transform_to_mat4", MATH_BENCH_OUTPUT_MAT4, &bench_siren_transform_to_mat4, &bench_glm_transform_to_mat4, 2.0f },
+    { "transform_batch_to_mat4", MATH_BENCH_OUTPUT_MAT4, &bench_siren_transform_batch_to_mat4, &bench_glm_transform_to_mat4, 2.0f },
+    { "transform_batch_to_affine3x4", MATH_BENCH_OUTPUT_AFFINE, &bench_siren_transform_batch_to_affine3x4, &bench_glm_transform_to_mat4, 2.0f }
+};
+static const uint32_t MATH_BENCH_OP_COUNT = sizeof(MATH_BENCH_OPS) / sizeof(MATH_BENCH_OPS[0]);
+
+/*
+ * The difference between two results in ULPs of the expected result's largest component. Measuring against each
+ * component's own ULP would blow up for components that should be zero but come out as rounding noise.
+ */
+float bench_ulp_error(const float* actual, const float* expected, uint32_t count) {
+    float magnitude = FLT_MIN;
+    float difference = 0.0f;
+    for (uint32_t index = 0; index < count; index++) {
+        if (std::isnan(actual[index]) != std::isnan(expected[index])) {
+            return INFINITY;
+        }
+        magnitude = std::max(magnitude, fabsf(expected[index]));
+        difference = std::max(difference, fabsf(actual[index] - expected[index]));
+    }
+    return difference / (nextafterf(magnitude, INFINITY) - magnitude);
+}
+
+float bench_result_error(MathBenchOutput output, uint32_t index) {
+    switch (output) {
+        case MATH_BENCH_OUTPUT_MAT4: {
+            const siren::mat4& actual = state.siren_mat4_results[index];
+            float actual_values[16];
+            float expected_values[16];
+            for (uint32_t element = 0; element < 16; element++) {
+                actual_values[element] = actual[element / 4][element % 4];
+                expected_values[element] = state.glm_mat4_results[index][element / 4][element % 4];
+            }
+            return bench_ulp_error(actual_values, expected_values, 16);
+        }
+        case MATH_BENCH_OUTPUT_AFFINE: {
+            const siren::affine3x4& actual = state.siren_affine_results[index];
+            float actual_values[12];
+            float expected_values[12];
+            for (uint32_t element = 0; element < 12; element++) {
+                actual_values[element] = actual[element / 4][element % 4];
+                expected_values[element] = state.glm_mat4_results[index][element % 4][element / 4];
+            }
+            return bench_ulp_error(actual_values, expected_values, 12);
+        }
+        case MATH_BENCH_OUTPUT_QUAT: {
+            const siren::quat& actual = state.siren_quat_results[index];
+            const glm::quat& expected = state.glm_quat_results[index];
+            float expected_values[4] = { expected.x, expected.y, expected.z, expected.w };
+            // A quaternion and its negation are the same rotation, so compare against whichever sign glm picked
+            float sign = (actual.x * expected.x) + (actual.y * expected.y) + (actual.z * expected.z) + (actual.w * expected.w) < 0.0f ? -1.0f : 1.0f;
+            float actual_values[4] = { actual.x * sign, actual.y * sign, actual.z * sign, actual.w * sign };
+            return bench_ulp_error(actual_values, expected_values, 4);
+        }
+        case MATH_BENCH_OUTPUT_VEC3: {
+            const siren::vec3& actual = state.siren_vec3_results[index];
+            const glm::vec3& expected = state.glm_vec3_results[index];
+            float expected_values[3] = { expected.x, expected.y, expected.z };
+            return bench_ulp_error(actual.elements, expected_values, 3);
+        }
+        case MATH_BENCH_OUTPUT_VEC4: {
+            const siren::vec4& actual = state.siren_vec4_results[index];
+            const glm::vec4& expected = state.glm_vec4_results[index];
+            float expected_values[4] = { expected.x, expected.y, expected.z, expected.w };
+            return bench_ulp_error(actual.elements, expected_values, 4);
+        }
+    }
+    return INFINITY;
+}
+
+// Fastest pass in nanoseconds per input
+double bench_time(void (*run)(), uint32_t passes) {
+    double best = INFINITY;
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+        run();
+        std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end_time - start_time).count());
+    }
+    return (best * MATH_BENCH_NANOSECONDS) / (double)state.count;
+}
+
+MathBenchResult bench_run_op(const MathBenchOp& op, uint32_t passes) {
+    MathBenchResult result = (MathBenchResult) {
+        .op = &op,
+        .baseline_ns = 0.0,
+        .is_regressed = false
+    };
+
+    // Warm the caches up with a pass each before timing, which also leaves both results in place to compare
+    op.run_siren();
+    op.run_glm();
+    result.max_ulps = 0.0f;
+    result.worst_index = 0;
+    double error_sum = 0.0;
+    for (uint32_t index = 0; index < state.count; index++) {
+        float error = bench_result_error(op.output, index);
+        error_sum += error;
+        if (error > result.max_ulps || std::isnan(error)) {
+            result.max_ulps = error;
+            result.worst_index = index;
+        }
+    }
+    result.mean_ulps = (float)(error_sum / (double)state.count);
+    result.is_accurate = result.max_ulps <= op.max_ulps;
+
+    result.siren_ns = bench_time(op.run_siren, passes);
+    result.glm_ns = bench_time(op.run_glm, passes);
+    return result;
+}
+
+// Flags ops whose siren time grew by more than the tolerance since the baseline run
+bool bench_compare_baseline(const MathBenchOptions& options, std::vector<MathBenchResult>* results) {
+    std::ifstream file(options.baseline_path);
+    if (!file.is_open()) {
+        printf("Unable to open baseline %s\n", options.baseline_path);
+        return false;
+    }
+    nlohmann::json baseline = nlohmann::json::parse(file, NULL, false);
+    if (baseline.is_discarded() || !baseline.contains("ops") || !baseline["ops"].is_array()) {
+        printf("Baseline %s is not a math-bench result file\n", options.baseline_path);
+        return false;
+    }
+
+    for (MathBenchResult& result : *results) {
+        for (const nlohmann::json& op : baseline["ops"]) {
+            if (!op.contains("name") || !op.contains("siren_ns") || op["name"] != result.op->name) {
+                continue;
+            }
+            result.baseline_ns = op["siren_ns"].get<double>();
+            result.is_regressed = result.siren_ns > result.baseline_ns * (1.0 + options.time_tolerance);
+        }
+    }
+    return true;
+}
+
+// JSON has no infinity or NaN, so either is written as a huge number instead
+double bench_json_number(double value) {
+    return std::isfinite(value) ? value : 1e30;
+}
+
+bool bench_write_results(const MathBenchOptions& options, const std::vector<MathBenchResult>& results, uint64_t kernel_hash, bool is_passed) {
+    FILE* file = fopen(options.output_path, "w");
+    if (file == NULL) {
+        printf("Unable to open results file %s\n", options.output_path);
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"count\": %u,\n", options.count);
+    fprintf(file, "  \"passes\": %u,\n", options.passes);
+    fprintf(file, "  \"seed\": %u,\n", options.seed);
+    fprintf(file, "  \"simd\": \"%s\",\n", bench_simd_path());
+    fprintf(file, "  \"kernel_hash\": \"%016llx\",\n", (unsigned long long)kernel_hash);
+    fprintf(file, "  \"kernel_hash_matches\": %s,\n", kernel_hash == MATH_BENCH_KERNEL_HASH ? "true" : "false");
+    fprintf(file, "  \"passed\": %s,\n", is_passed ? "true" : "false");
+    fprintf(file, "  \"ops\": [");
+    for (uint32_t index = 0; index < results.size(); index++) {
+        const MathBenchResult& result = results[index];
+        fprintf(file, "%s\n    { \"name\": \"%s\", \"siren_ns\": %.4f, \"glm_ns\": %.4f, \"speedup\": %.4f, \"max_ulps\": %.2f, \"mean_ulps\": %.4f, \"ulp_limit\": %.2f, \"worst_index\": %u, \"accurate\": %s",
+                index == 0 ? "" : ",", result.op->name, result.siren_ns, result.glm_ns, bench_json_number(result.glm_ns / result.siren_ns),
+                bench_json_number(result.max_ulps), bench_json_number(result.mean_ulps),
+                result.op->max_ulps, result.worst_index, result.is_accurate ? "true" : "false");
+        if (options.baseline_path != NULL) {
+            fprintf(file, ", \"baseline_ns\": %.4f, \"regressed\": %s", result.baseline_ns, result.is_regressed ? "true" : "false");
+        }
+        fprintf(file, " }");
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    MathBenchOptions options = (MathBenchOptions) {
+        .count = 4096,
+        .passes = 50,
+        .seed = 1,
+        .output_path = "math-bench.json",
+        .baseline_path = NULL,
+        .time_tolerance = 0.1,
+        .is_kernel_check_only = false
+    };
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--count") == 0 && arg + 1 < argc) {
+            options.count = (uint32_t)atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--passes") == 0 && arg + 1 < argc) {
+            options.passes = (uint32_t)atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--seed") == 0 && arg + 1 < argc) {
+            options.seed = (uint32_t)atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--out") == 0 && arg + 1 < argc) {
+            options.output_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--baseline") == 0 && arg + 1 < argc) {
+            options.baseline_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--tolerance") == 0 && arg + 1 < argc) {
+            options.time_tolerance = atof(argv[++arg]);
+        } else if (strcmp(argv[arg], "--check-kernels") == 0) {
+            options.is_kernel_check_only = true;
+        } else {
+            printf("Usage: math-bench [--count inputs_per_op] [--passes timed_passes] [--seed seed] [--out results.json] [--baseline earlier_results.json] [--tolerance allowed_slowdown_fraction] [--check-kernels]\n");
+            return -1;
+        }
+    }
+    if (options.count == 0 || options.passes == 0) {
+        printf("--count and --passes must be at least 1\n");
+        return -1;
+    }
+
+    uint64_t kernel_hash = bench_kernel_hash();
+    bool is_kernel_hash_matching = kernel_hash == MATH_BENCH_KERNEL_HASH;
+    printf("Kernel hash %016llx on the %s path, expected %016llx%s\n", (unsigned long long)kernel_hash, bench_simd_path(),
+            (unsigned long long)MATH_BENCH_KERNEL_HASH, is_kernel_hash_matching ? "" : " MISMATCH");
+    if (options.is_kernel_check_only) {
+        return is_kernel_hash_matching ? 0 : 1;
+    }
+
+    bench_generate_inputs(options.count, options.seed);
+    std::vector<MathBenchResult> results;
+    for (uint32_t index = 0; index < MATH_BENCH_OP_COUNT; index++) {
+        results.push_back(bench_run_op(MATH_BENCH_OPS[index], options.passes));
+    }
+    if (options.baseline_path != NULL && !bench_compare_baseline(options, &results)) {
+        return -1;
+    }
+
+    bool is_passed = is_kernel_hash_matching;
+    printf("%-30s %12s %12s %9s %12s %10s\n", "op", "siren ns", "glm ns", "speedup", "max ulps", "limit");
+    for (const MathBenchResult& result : results) {
+        const char* status = !result.is_accurate ? "INACCURATE" : result.is_regressed ? "REGRESSED" : "";
+        printf("%-30s %12.3f %12.3f %8.2fx %12.2f %10.2f %s\n", result.op->name, result.siren_ns, result.glm_ns, result.glm_ns / result.siren_ns, result.max_ulps, result.op->max_ulps, status);
+        is_passed = is_passed && result.is_accurate && !result.is_regressed;
+    }
+
+    if (!bench_write_results(options, results, kernel_hash, is_passed)) {
+        return -1;
+    }
+    printf("Results written to %s\n", options.output_path);
+
+    return is_passed ? 0 : 1;
+}
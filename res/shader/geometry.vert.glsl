@@ -9,15 +9,20 @@ out vec3 frag_normal;
 out vec3 frag_texture_coordinate;
 
 uniform mat4 projection;
-uniform mat4 view;
+// Per-frame camera data, shared by every draw that uses the same camera
+layout (std140) uniform FrameData {
+    mat4 view;
+    vec3 view_position;
+};
 uniform mat4 model;
+// The affine inverse of model, one row per column like the bone matrices. Its upper 3x3 is the inverse transpose that normals need.
+uniform mat3x4 inverse_model;
 
 void main() {
     vec4 total_position = vec4(vertex_position, 1.0);
     gl_Position = projection * view * model * total_position;
 
     frag_position = vec3(model * total_position);
-    // TODO pre-calc this before the shader
-    frag_normal = normalize(mat3(transpose(inverse(model))) * normal);
+    frag_normal = normalize(mat3(inverse_model) * normal);
     frag_texture_coordinate = texture_coordinate;
 }
\ No newline at end of file
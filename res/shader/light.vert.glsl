@@ -5,7 +5,11 @@ layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texture_coordinate;
 
 uniform mat4 projection;
-uniform mat4 view;
+// Per-frame camera data, shared by every draw that uses the same camera
+layout (std140) uniform FrameData {
+    mat4 view;
+    vec3 view_position;
+};
 uniform mat4 model;
 
 void main() {
@@ -6,7 +6,11 @@ in vec2 frag_texture_coordinate;
 
 out vec4 frag_color;
 
-uniform vec3 view_position;
+// Per-frame camera data, shared by every draw that uses the same camera
+layout (std140) uniform FrameData {
+    mat4 view;
+    vec3 view_position;
+};
 
 uniform vec3 light_positions[4];
 uniform vec3 light_colors[4];
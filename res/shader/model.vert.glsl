@@ -11,12 +11,19 @@ out vec3 frag_normal;
 out vec2 frag_texture_coordinate;
 
 uniform mat4 projection;
-uniform mat4 view;
+// Per-frame camera data, shared by every draw that uses the same camera
+layout (std140) uniform FrameData {
+    mat4 view;
+    vec3 view_position;
+};
 uniform mat4 model;
+// The affine inverse of model, one row per column like the bone matrices. Its upper 3x3 is the inverse transpose that normals need.
+uniform mat3x4 inverse_model;
 
 const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 bone_matrix[MAX_BONES];
+// Bones are affine, so only their top three rows are sent, one per mat3x4 column. A vec4 times one gives the moved vec3.
+uniform mat3x4 bone_matrix[MAX_BONES];
 
 void main() {
     vec4 total_position = vec4(0.0);
@@ -29,7 +36,7 @@ void main() {
                 break;
             }
 
-            vec4 local_position = bone_matrix[bone_ids[i]] * vec4(vertex_position, 1.0);
+            vec4 local_position = vec4(vec4(vertex_position, 1.0) * bone_matrix[bone_ids[i]], 1.0);
             total_position += local_position * bone_weights[i];
         }
     }
@@ -37,7 +44,6 @@ void main() {
     gl_Position = projection * view * model * total_position;
 
     frag_position = vec3(model * total_position);
-    // TODO pre-calc this before the shader
-    frag_normal = normalize(mat3(transpose(inverse(model))) * normal);
+    frag_normal = normalize(mat3(inverse_model) * normal);
     frag_texture_coordinate = texture_coordinate;
 }
\ No newline at end of file
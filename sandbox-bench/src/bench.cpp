@@ -0,0 +1,293 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_GAME
+
+#include "bench.h"
+
+#include <core/application.h>
+#include <core/logger.h>
+#include <core/profiler.h>
+#include <core/memory.h>
+#include <renderer/font.h>
+#include <renderer/renderer.h>
+#include <renderer/model.h>
+#include <scene/camera.h>
+#include <scene/scene.h>
+
+#include <SDL2/SDL.h>
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+using siren::ivec2;
+using siren::vec3;
+using siren::quat;
+
+static const uint32_t BENCH_MAX_ZONES = 64;
+
+// One point in the sweep: how many animated models, geometry cubes and lights are in the scene
+struct BenchPhase {
+    uint32_t model_count;
+    uint32_t cube_count;
+    uint32_t light_count;
+};
+
+static const BenchPhase BENCH_PHASES[] = {
+    // Model scaling
+    { .model_count = 1, .cube_count = 0, .light_count = 1 },
+    { .model_count = 16, .cube_count = 0, .light_count = 1 },
+    { .model_count = 64, .cube_count = 0, .light_count = 1 },
+    { .model_count = 256, .cube_count = 0, .light_count = 1 },
+    // Geometry scaling
+    { .model_count = 0, .cube_count = 64, .light_count = 1 },
+    { .model_count = 0, .cube_count = 256, .light_count = 1 },
+    { .model_count = 0, .cube_count = 1024, .light_count = 1 },
+    // Light scaling, up to the 4 lights the renderer shades. Any more would only add marker draws.
+    { .model_count = 16, .cube_count = 64, .light_count = 1 },
+    { .model_count = 16, .cube_count = 64, .light_count = 2 },
+    { .model_count = 16, .cube_count = 64, .light_count = 4 },
+    // Everything at once
+    { .model_count = 256, .cube_count = 1024, .light_count = 4 }
+};
+static const uint32_t BENCH_PHASE_COUNT = sizeof(BENCH_PHASES) / sizeof(BENCH_PHASES[0]);
+
+struct BenchPhaseResult {
+    BenchPhase phase;
+    siren::ProfilerFrameStats frame_stats;
+    siren::GpuTimings gpu_timings;
+    std::vector<siren::ProfilerZoneStats> zones;
+};
+
+struct BenchState {
+    BenchOptions options;
+
+    siren::FontHandle font;
+    siren::ModelHandle model;
+    siren::Camera camera;
+    std::vector<siren::ModelTransform> model_transforms;
+    std::vector<siren::Transform> cube_transforms;
+
+    double model_load_time;
+    double font_load_time;
+    std::vector<siren::ProfilerZoneStats> startup_zones;
+
+    uint32_t phase_index;
+    uint32_t phase_frame;
+    siren::GpuTimings gpu_timing_sum;
+    uint32_t gpu_timing_count;
+    std::vector<BenchPhaseResult> results;
+};
+static BenchState state;
+
+double bench_seconds_since(uint64_t start_time) {
+    return (double)(SDL_GetPerformanceCounter() - start_time) / (double)SDL_GetPerformanceFrequency();
+}
+
+std::vector<siren::ProfilerZoneStats> bench_get_zone_stats() {
+    siren::ProfilerZoneStats zones[BENCH_MAX_ZONES];
+    uint32_t zone_count = siren::profiler_get_zone_stats(zones, BENCH_MAX_ZONES);
+    if (zone_count > BENCH_MAX_ZONES) {
+        zone_count = BENCH_MAX_ZONES;
+    }
+    return std::vector<siren::ProfilerZoneStats>(zones, zones + zone_count);
+}
+
+// Lays the scene out in grids in front of the camera so that everything is on screen and the work is the same every run
+void bench_setup_phase(const BenchPhase& phase) {
+    state.model_transforms.clear();
+    uint32_t model_columns = (uint32_t)ceilf(sqrtf((float)phase.model_count));
+    for (uint32_t index = 0; index < phase.model_count; index++) {
+        siren::ModelTransform transform = siren::ModelTransform(state.model);
+        transform.root.position = vec3(((float)(index % model_columns) - ((float)model_columns * 0.5f)) * 0.6f, 0.0f, -((float)(index / model_columns)) * 0.6f);
+        transform.root.scale = vec3(0.1f);
+        transform.set_animation("fire1", true);
+        // Stagger the animations so that every instance samples different keyframes
+        transform.update_animation((float)index * 0.05f);
+        transform.store_previous_root();
+        state.model_transforms.push_back(transform);
+    }
+
+    state.cube_transforms.clear();
+    uint32_t cube_columns = (uint32_t)ceilf(sqrtf((float)phase.cube_count));
+    for (uint32_t index = 0; index < phase.cube_count; index++) {
+        state.cube_transforms.push_back((siren::Transform) {
+            .position = vec3(((float)(index % cube_columns) - ((float)cube_columns * 0.5f)) * 0.5f, -1.0f, -((float)(index / cube_columns)) * 0.5f),
+            .rotation = quat(),
+            .scale = vec3(0.2f)
+        });
+    }
+
+    std::vector<siren::Light> lights;
+    for (uint32_t index = 0; index < phase.light_count; index++) {
+        float angle = ((float)index / (float)phase.light_count) * 2.0f * 3.14159265f;
+        lights.push_back((siren::Light) {
+            .position = vec3(cosf(angle) * 3.0f, 2.0f, (sinf(angle) * 3.0f) - 2.0f),
+            .color = vec3(25.0f)
+        });
+    }
+    siren::renderer_set_lights(lights.data(), (uint32_t)lights.size());
+
+    state.phase_frame = 0;
+}
+
+void bench_write_zones(FILE* file, const std::vector<siren::ProfilerZoneStats>& zones, uint32_t frame_count) {
+    fprintf(file, "[");
+    for (uint32_t index = 0; index < zones.size(); index++) {
+        const siren::ProfilerZoneStats& zone = zones[index];
+        fprintf(file, "%s\n        { \"name\": \"%s\", \"calls\": %llu, \"total_ms\": %.4f", index == 0 ? "" : ",", zone.name, (unsigned long long)zone.call_count, zone.total_time);
+        if (frame_count != 0) {
+            fprintf(file, ", \"per_frame_ms\": %.4f", zone.total_time / (double)frame_count);
+        }
+        fprintf(file, " }");
+    }
+    fprintf(file, "\n      ]");
+}
+
+bool bench_write_results() {
+    FILE* file = fopen(state.options.output_path, "w");
+    if (file == NULL) {
+        SIREN_ERROR("Unable to open benchmark results file %s", state.options.output_path);
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"warmup_frames\": %u,\n", state.options.warmup_frames);
+    fprintf(file, "  \"measured_frames\": %u,\n", state.options.measured_frames);
+    fprintf(file, "  \"load\": {\n");
+    fprintf(file, "    \"model_ms\": %.4f,\n", state.model_load_time * 1000.0);
+    fprintf(file, "    \"font_ms\": %.4f,\n", state.font_load_time * 1000.0);
+    fprintf(file, "    \"zones\": ");
+    bench_write_zones(file, state.startup_zones, 0);
+    fprintf(file, "\n  },\n");
+
+    fprintf(file, "  \"phases\": [");
+    for (uint32_t index = 0; index < state.results.size(); index++) {
+        const BenchPhaseResult& result = state.results[index];
+        fprintf(file, "%s\n    {\n", index == 0 ? "" : ",");
+        fprintf(file, "      \"models\": %u, \"cubes\": %u, \"lights\": %u,\n", result.phase.model_count, result.phase.cube_count, result.phase.light_count);
+        fprintf(file, "      \"frame_ms\": { \"count\": %u, \"average\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+                result.frame_stats.frame_count, result.frame_stats.average, result.frame_stats.p50, result.frame_stats.p95, result.frame_stats.p99, result.frame_stats.max);
+        fprintf(file, "      \"gpu_ms\": { \"scene\": %.4f, \"models\": %.4f, \"geometry\": %.4f, \"text\": %.4f, \"resolve\": %.4f, \"screen\": %.4f, \"total\": %.4f },\n",
+                result.gpu_timings.scene, result.gpu_timings.models, result.gpu_timings.geometry, result.gpu_timings.text, result.gpu_timings.resolve, result.gpu_timings.screen, result.gpu_timings.total);
+        fprintf(file, "      \"cpu_zones\": ");
+        bench_write_zones(file, result.zones, result.frame_stats.frame_count);
+        fprintf(file, "\n    }");
+    }
+    fprintf(file, "\n  ],\n");
+
+    // Memory held once the whole sweep is loaded, in bytes
+    siren::MemoryReport memory = siren::memory_report();
+    fprintf(file, "  \"memory\": {");
+    for (uint32_t kind = 0; kind < siren::MEMORY_KIND_COUNT; kind++) {
+        fprintf(file, "%s \"%s\": %llu", kind == 0 ? "" : ",", siren::memory_kind_name((siren::MemoryKind)kind), (unsigned long long)memory.total_bytes[kind]);
+    }
+    fprintf(file, " }\n}\n");
+
+    fclose(file);
+    SIREN_INFO("Benchmark results written to %s", state.options.output_path);
+    return true;
+}
+
+void bench_set_options(BenchOptions options) {
+    state.options = options;
+}
+
+uint32_t bench_get_total_frames() {
+    // One extra frame to collect the results of the last phase
+    return (BENCH_PHASE_COUNT * (state.options.warmup_frames + state.options.measured_frames)) + 1;
+}
+
+bool bench_init() {
+    uint64_t start_time = SDL_GetPerformanceCounter();
+    state.font = siren::font_acquire("font/hack.ttf", 10);
+    state.font_load_time = bench_seconds_since(start_time);
+
+    start_time = SDL_GetPerformanceCounter();
+    state.model = siren::model_acquire("model/gun/gun.glb");
+    state.model_load_time = bench_seconds_since(start_time);
+    if (state.model == siren::MODEL_HANDLE_NULL) {
+        return false;
+    }
+
+    state.camera = siren::Camera();
+    state.camera.set_position(vec3(0.0f, 3.0f, 8.0f));
+    state.camera.apply_pitch(-20.0f);
+
+    state.phase_index = 0;
+    bench_setup_phase(BENCH_PHASES[0]);
+
+    return true;
+}
+
+bool bench_update(float delta) {
+    // Everything recorded so far comes from startup, so keep it as the load breakdown
+    if (state.phase_index == 0 && state.phase_frame == 0) {
+        state.startup_zones = bench_get_zone_stats();
+    }
+
+    if (state.phase_frame == state.options.warmup_frames) {
+        siren::profiler_reset_stats();
+        state.gpu_timing_sum = (siren::GpuTimings) { };
+        state.gpu_timing_count = 0;
+    } else if (state.phase_frame == state.options.warmup_frames + state.options.measured_frames) {
+        BenchPhaseResult result;
+        result.phase = BENCH_PHASES[state.phase_index];
+        result.frame_stats = siren::profiler_get_frame_stats();
+        result.zones = bench_get_zone_stats();
+        result.gpu_timings = state.gpu_timing_sum;
+        if (state.gpu_timing_count != 0) {
+            float scale = 1.0f / (float)state.gpu_timing_count;
+            result.gpu_timings.scene *= scale;
+            result.gpu_timings.models *= scale;
+            result.gpu_timings.geometry *= scale;
+            result.gpu_timings.text *= scale;
+            result.gpu_timings.resolve *= scale;
+            result.gpu_timings.screen *= scale;
+            result.gpu_timings.total *= scale;
+        }
+        state.results.push_back(result);
+        SIREN_INFO("Bench phase %u: models %u cubes %u lights %u, p50 %.2fms p99 %.2fms", state.phase_index, result.phase.model_count, result.phase.cube_count, result.phase.light_count, result.frame_stats.p50, result.frame_stats.p99);
+
+        state.phase_index++;
+        if (state.phase_index == BENCH_PHASE_COUNT) {
+            return bench_write_results();
+        }
+        bench_setup_phase(BENCH_PHASES[state.phase_index]);
+    }
+
+    for (siren::ModelTransform& transform : state.model_transforms) {
+        transform.update_animation(delta);
+    }
+
+    state.phase_frame++;
+    return true;
+}
+
+bool bench_render(float alpha) {
+    // Accumulate last frame's GPU timings while measuring, since they lag by a frame
+    if (state.phase_frame > state.options.warmup_frames + 1) {
+        siren::GpuTimings timings = siren::application_get_gpu_timings();
+        state.gpu_timing_sum.scene += timings.scene;
+        state.gpu_timing_sum.models += timings.models;
+        state.gpu_timing_sum.geometry += timings.geometry;
+        state.gpu_timing_sum.text += timings.text;
+        state.gpu_timing_sum.resolve += timings.resolve;
+        state.gpu_timing_sum.screen += timings.screen;
+        state.gpu_timing_sum.total += timings.total;
+        state.gpu_timing_count++;
+    }
+
+    siren::renderer_render_light(&state.camera);
+    for (siren::ModelTransform& transform : state.model_transforms) {
+        siren::renderer_render_model(&state.camera, state.model, transform, alpha);
+    }
+    for (const siren::Transform& transform : state.cube_transforms) {
+        siren::renderer_render_geometry(&state.camera, transform);
+    }
+
+    const BenchPhase& phase = BENCH_PHASES[state.phase_index < BENCH_PHASE_COUNT ? state.phase_index : BENCH_PHASE_COUNT - 1];
+    char phase_text[64];
+    snprintf(phase_text, sizeof(phase_text), "Phase %u: models %u cubes %u lights %u", state.phase_index, phase.model_count, phase.cube_count, phase.light_count);
+    siren::renderer_render_text(phase_text, state.font, ivec2(0, 0), vec3(1.0f));
+
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+struct BenchOptions {
+    // Frames rendered after each scene change before measuring starts
+    uint32_t warmup_frames;
+    // Frames measured for each phase of the sweep
+    uint32_t measured_frames;
+    const char* output_path;
+};
+
+void bench_set_options(BenchOptions options);
+// Number of frames needed to run the whole sweep
+uint32_t bench_get_total_frames();
+
+bool bench_init();
+bool bench_update(float delta);
+bool bench_render(float alpha);
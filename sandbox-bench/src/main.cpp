@@ -0,0 +1,76 @@
+#include "bench.h"
+
+#include <core/application.h>
+#include <math/math.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    BenchOptions options = (BenchOptions) {
+        .warmup_frames = 60,
+        .measured_frames = 600,
+        .output_path = "bench.json"
+    };
+    bool threaded_renderer = false;
+    const char* resource_archive = NULL;
+    const char* cache_path = NULL;
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--frames") == 0 && arg + 1 < argc) {
+            options.measured_frames = (uint32_t)atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--warmup") == 0 && arg + 1 < argc) {
+            options.warmup_frames = (uint32_t)atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "--out") == 0 && arg + 1 < argc) {
+            options.output_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--threaded") == 0) {
+            threaded_renderer = true;
+        } else if (strcmp(argv[arg], "--archive") == 0 && arg + 1 < argc) {
+            resource_archive = argv[++arg];
+        } else if (strcmp(argv[arg], "--cache") == 0 && arg + 1 < argc) {
+            cache_path = argv[++arg];
+        } else {
+            printf("Usage: sandbox-bench [--frames measured_frames_per_phase] [--warmup warmup_frames_per_phase] [--out results.json] [--threaded] [--archive resources.pak] [--cache cache_directory]\n");
+            return -1;
+        }
+    }
+    if (options.measured_frames == 0) {
+        printf("--frames must be at least 1\n");
+        return -1;
+    }
+    bench_set_options(options);
+
+    siren::ApplicationConfig config = (siren::ApplicationConfig) {
+        .name = "Siren Bench",
+        .screen_size = siren::ivec2(1280, 720),
+        .window_size = siren::ivec2(1280, 720),
+
+        .resource_path = "../res/",
+        .resource_archive = resource_archive,
+        .cache_path = cache_path,
+
+        .init = &bench_init,
+        .update = &bench_update,
+        .render = &bench_render,
+
+        .frame_pacing = siren::FRAME_PACING_UNCAPPED,
+
+        .threaded_renderer = threaded_renderer,
+
+        .headless = true,
+        .frame_limit = bench_get_total_frames(),
+        // Animations advance the same amount every frame no matter how fast the machine is
+        .fixed_delta = 1.0f / 60.0f
+    };
+    if (!siren::application_create(config)) {
+        printf("Application failed to create!\n");
+        return -1;
+    }
+
+    if (!siren::application_run()) {
+        printf("Application did not quit gracefully.\n");
+        return -2;
+    }
+
+    return 0;
+}
@@ -1,8 +1,11 @@
+#define SIREN_LOG_CATEGORY siren::LOG_CATEGORY_GAME
+
 #include "game.h"
 
 #include <core/application.h>
 #include <core/logger.h>
 #include <core/input.h>
+#include <core/profiler.h>
 #include <renderer/font.h>
 #include <renderer/renderer.h>
 #include <scene/camera.h>
@@ -14,8 +17,10 @@
 struct GameState {
     siren::FontHandle debug_font;
     siren::Camera camera;
+    siren::vec3 previous_camera_position;
     siren::ModelHandle test;
     siren::ModelTransform transform;
+    bool is_test_animated;
 };
 static GameState gamestate;
 
@@ -24,21 +29,29 @@ using siren::vec3;
 using siren::quat;
 
 bool game_init() {
-    gamestate.debug_font = siren::font_acquire("font/hack.ttf", 10);
+    // Both load in the background, the model starts animating once it's ready
+    gamestate.debug_font = siren::font_acquire_async("font/hack.ttf", 10);
     gamestate.camera = siren::Camera();
-    gamestate.test = siren::model_acquire("model/gun/gun.glb");
+    // Same sensitivity as the mouse look in game_update
+    gamestate.camera.set_late_latch(true, -0.1f, 0.1f);
+    gamestate.previous_camera_position = gamestate.camera.get_position();
+    gamestate.test = siren::model_acquire_async("model/gun/gun.glb");
     if (gamestate.test == siren::MODEL_HANDLE_NULL) {
+        SIREN_ERROR("Unable to load the test model.");
         return false;
     }
     gamestate.transform = siren::ModelTransform(gamestate.test);
     gamestate.transform.root.position = vec3(0.0f);
     gamestate.transform.root.scale = siren::vec3(0.1f);
-    gamestate.transform.set_animation("fire1", false);
+    gamestate.is_test_animated = false;
 
     return true;
 }
 
 bool game_update(float delta) {
+    gamestate.previous_camera_position = gamestate.camera.get_position();
+    gamestate.transform.store_previous_root();
+
     if (siren::application_get_mouse_mode() == siren::MOUSE_MODE_VISIBLE && siren::input_is_mouse_button_just_pressed(siren::MOUSE_BUTTON_LEFT)) { 
         siren::application_set_mouse_mode(siren::MOUSE_MODE_RELATIVE);
     } else if (siren::application_get_mouse_mode() == siren::MOUSE_MODE_RELATIVE && siren::input_is_key_just_pressed(siren::KEY_ESCAPE)) { 
@@ -77,19 +90,36 @@ bool game_update(float delta) {
         gamestate.camera.apply_yaw((float)mouse_rel.x * 0.1f);
     }
 
+    if (!gamestate.is_test_animated && siren::model_is_ready(gamestate.test)) {
+        gamestate.transform.set_animation("fire1", false);
+        gamestate.is_test_animated = true;
+    }
     gamestate.transform.update_animation(delta);
 
+    if (siren::input_is_key_just_pressed(siren::KEY_F1)) {
+        siren::profiler_write_chrome_trace("profile.json");
+    }
+
     return true;
 }
 
-bool game_render() {
-    siren::renderer_render_light(&gamestate.camera);
-    siren::renderer_render_model(&gamestate.camera, gamestate.test, gamestate.transform);
-    siren::renderer_render_geometry(&gamestate.camera);
+bool game_render(float alpha) {
+    // Blend the camera between the last two updates
+    siren::Camera camera = gamestate.camera;
+    camera.set_position(vec3::lerp(gamestate.previous_camera_position, gamestate.camera.get_position(), alpha));
+
+    siren::renderer_render_light(&camera);
+    siren::renderer_render_model(&camera, gamestate.test, gamestate.transform, alpha);
+    siren::renderer_render_geometry(&camera);
 
     char fps_text[16];
     sprintf(fps_text, "FPS: %u", siren::application_get_fps());
     siren::renderer_render_text(fps_text, gamestate.debug_font, ivec2(0, 0), siren::vec3(1.0f));
 
+    siren::GpuTimings gpu_timings = siren::application_get_gpu_timings();
+    char gpu_text[128];
+    sprintf(gpu_text, "GPU: %.2fms (models %.2f geometry %.2f text %.2f resolve %.2f)", gpu_timings.total, gpu_timings.models, gpu_timings.geometry, gpu_timings.text, gpu_timings.resolve);
+    siren::renderer_render_text(gpu_text, gamestate.debug_font, ivec2(0, 16), siren::vec3(1.0f));
+
     return true;
 }
\ No newline at end of file
@@ -2,4 +2,4 @@
 
 bool game_init();
 bool game_update(float delta);
-bool game_render();
\ No newline at end of file
+bool game_render(float alpha);
\ No newline at end of file
@@ -12,10 +12,23 @@ int main() {
         .window_size = siren::ivec2(1280, 720),
 
         .resource_path = "../res/",
+        .cache_path = "./cache/",
 
         .init = &game_init,
         .update = &game_update,
-        .render = &game_render
+        .render = &game_render,
+
+        .frame_pacing = siren::FRAME_PACING_FIXED,
+        .target_fps = 144,
+        .background_fps = 30,
+
+        .fixed_timestep = 1.0f / 60.0f,
+
+        .threaded_renderer = true,
+        .vram_budget_mb = 512,
+        .ram_budget_mb = 256,
+
+        .memory_report_interval = 30.0f
     };
     if (!siren::application_create(config)) {
         printf("Application failed to create!\n");
@@ -0,0 +1,148 @@
+#include <core/cook.h>
+#include <core/job.h>
+#include <renderer/model.h>
+#include <renderer/texture.h>
+#include <renderer/font.h>
+
+#include <filesystem>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+static const uint16_t COOK_DEFAULT_FONT_SIZE = 10;
+
+struct CookTask {
+    std::string path;
+    siren::CookAssetType type;
+    // Only used by fonts, which are cooked once per size
+    uint16_t font_size;
+    siren::CookResult result;
+};
+
+struct CookOptions {
+    const char* input_path;
+    const char* output_path;
+    uint32_t worker_count;
+    std::vector<uint16_t> font_sizes;
+};
+
+void cook_run_tasks(uint32_t start, uint32_t end, void* data) {
+    CookTask* tasks = (CookTask*)data;
+    for (uint32_t index = start; index < end; index++) {
+        CookTask& task = tasks[index];
+        switch (task.type) {
+            case siren::COOK_ASSET_MODEL:
+                task.result = siren::model_cook(task.path.c_str());
+                break;
+            case siren::COOK_ASSET_TEXTURE:
+                task.result = siren::texture_cook(task.path.c_str());
+                break;
+            case siren::COOK_ASSET_FONT:
+                task.result = siren::font_cook(task.path.c_str(), task.font_size);
+                break;
+            default:
+                task.result = siren::COOK_FAILED;
+                break;
+        }
+    }
+}
+
+bool cook_run(const CookOptions& options) {
+    std::error_code error;
+    std::filesystem::path input_path(options.input_path);
+    if (!std::filesystem::is_directory(input_path, error)) {
+        printf("%s is not a directory\n", options.input_path);
+        return false;
+    }
+
+    std::vector<std::string> paths;
+    for (const std::filesystem::directory_entry& directory_entry : std::filesystem::recursive_directory_iterator(input_path, error)) {
+        if (directory_entry.is_regular_file()) {
+            paths.push_back(directory_entry.path().lexically_relative(input_path).generic_string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<CookTask> tasks;
+    for (const std::string& path : paths) {
+        siren::CookAssetType type = siren::cook_get_asset_type(path.c_str());
+        if (type == siren::COOK_ASSET_NONE) {
+            continue;
+        }
+        if (type == siren::COOK_ASSET_FONT) {
+            for (uint16_t font_size : options.font_sizes) {
+                tasks.push_back((CookTask) { .path = path, .type = type, .font_size = font_size, .result = siren::COOK_FAILED });
+            }
+        } else {
+            tasks.push_back((CookTask) { .path = path, .type = type, .font_size = 0, .result = siren::COOK_FAILED });
+        }
+    }
+
+    if (!siren::cook_init(options.input_path, options.output_path, options.worker_count)) {
+        printf("Unable to start cooking into %s\n", options.output_path);
+        return false;
+    }
+    // Assets vary wildly in cost, so workers take them one at a time
+    siren::job_parallel_for((uint32_t)tasks.size(), 1, cook_run_tasks, tasks.data());
+    siren::cook_quit();
+
+    uint32_t written_count = 0;
+    uint32_t up_to_date_count = 0;
+    uint32_t failed_count = 0;
+    for (const CookTask& task : tasks) {
+        if (task.result == siren::COOK_WRITTEN) {
+            written_count++;
+            if (task.type == siren::COOK_ASSET_FONT) {
+                printf("cooked %s at size %u\n", task.path.c_str(), (uint32_t)task.font_size);
+            } else {
+                printf("cooked %s\n", task.path.c_str());
+            }
+        } else if (task.result == siren::COOK_UP_TO_DATE) {
+            up_to_date_count++;
+        } else {
+            failed_count++;
+            printf("FAILED %s\n", task.path.c_str());
+        }
+    }
+    printf("Cooked %u assets into %s, %u already up to date, %u failed\n", written_count, options.output_path, up_to_date_count, failed_count);
+
+    return failed_count == 0;
+}
+
+int main(int argc, char** argv) {
+    CookOptions options;
+    options.input_path = NULL;
+    options.output_path = NULL;
+    options.worker_count = 0;
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--font-size") == 0 && arg + 1 < argc) {
+            int font_size = atoi(argv[++arg]);
+            if (font_size <= 0 || font_size > UINT16_MAX) {
+                printf("Font sizes must be between 1 and %u\n", (uint32_t)UINT16_MAX);
+                return -1;
+            }
+            options.font_sizes.push_back((uint16_t)font_size);
+        } else if (strcmp(argv[arg], "--workers") == 0 && arg + 1 < argc) {
+            options.worker_count = (uint32_t)atoi(argv[++arg]);
+        } else if (argv[arg][0] != '-' && options.input_path == NULL) {
+            options.input_path = argv[arg];
+        } else if (argv[arg][0] != '-' && options.output_path == NULL) {
+            options.output_path = argv[arg];
+        } else {
+            options.input_path = NULL;
+            break;
+        }
+    }
+    if (options.input_path == NULL || options.output_path == NULL) {
+        printf("Usage: siren-cook resource_directory cache_directory [--font-size size]... [--workers count]\n");
+        return -1;
+    }
+    if (options.font_sizes.empty()) {
+        options.font_sizes.push_back(COOK_DEFAULT_FONT_SIZE);
+    }
+
+    return cook_run(options) ? 0 : -1;
+}
@@ -0,0 +1,193 @@
+#include <core/resource.h>
+#include <core/compression.h>
+
+#include <filesystem>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+// Entries are only stored compressed when that saves at least this fraction of their size
+static const double PACK_MIN_COMPRESSION_SAVING = 0.1;
+// Small files don't save enough to be worth decompressing
+static const size_t PACK_MIN_COMPRESSION_SIZE = 256;
+
+struct PackEntry {
+    std::string path;
+    siren::ResourceArchiveEntry entry;
+};
+
+struct PackOptions {
+    const char* input_path;
+    const char* output_path;
+    bool is_compression_enabled;
+};
+
+bool pack_read_file(const std::filesystem::path& path, std::vector<uint8_t>* data) {
+    FILE* file = fopen(path.string().c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data->resize((size_t)size);
+    bool success = size == 0 || fread(data->data(), 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+    return success;
+}
+
+void pack_write_padding(FILE* file, uint64_t* offset) {
+    static const uint8_t PADDING[siren::RESOURCE_ARCHIVE_ALIGNMENT] = { 0 };
+    uint64_t padding = (siren::RESOURCE_ARCHIVE_ALIGNMENT - (*offset % siren::RESOURCE_ARCHIVE_ALIGNMENT)) % siren::RESOURCE_ARCHIVE_ALIGNMENT;
+    fwrite(PADDING, 1, (size_t)padding, file);
+    *offset += padding;
+}
+
+bool pack_entry_compare(const PackEntry& a, const PackEntry& b) {
+    if (a.entry.path_hash != b.entry.path_hash) {
+        return a.entry.path_hash < b.entry.path_hash;
+    }
+    return a.path < b.path;
+}
+
+bool pack_run(const PackOptions& options) {
+    std::error_code error;
+    std::filesystem::path input_path(options.input_path);
+    std::filesystem::path output_path = std::filesystem::absolute(options.output_path, error);
+    if (!std::filesystem::is_directory(input_path, error)) {
+        printf("%s is not a directory\n", options.input_path);
+        return false;
+    }
+
+    std::vector<std::filesystem::path> files;
+    for (const std::filesystem::directory_entry& directory_entry : std::filesystem::recursive_directory_iterator(input_path, error)) {
+        if (!directory_entry.is_regular_file()) {
+            continue;
+        }
+        // Don't pack the archive into itself when it's written inside the input directory
+        if (std::filesystem::equivalent(directory_entry.path(), output_path, error)) {
+            continue;
+        }
+        files.push_back(directory_entry.path());
+    }
+    // Directory iteration order isn't stable across machines, but the archive should be
+    std::sort(files.begin(), files.end());
+
+    FILE* output = fopen(options.output_path, "wb");
+    if (output == NULL) {
+        printf("Unable to open %s for writing\n", options.output_path);
+        return false;
+    }
+
+    siren::ResourceArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    fwrite(&header, sizeof(header), 1, output);
+    uint64_t offset = sizeof(header);
+
+    std::vector<PackEntry> entries;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> compressed;
+    uint64_t total_size = 0;
+    uint64_t total_stored_size = 0;
+    for (const std::filesystem::path& file_path : files) {
+        PackEntry pack_entry;
+        pack_entry.path = file_path.lexically_relative(input_path).generic_string();
+        if (!pack_read_file(file_path, &data)) {
+            printf("Unable to read %s\n", file_path.string().c_str());
+            fclose(output);
+            return false;
+        }
+
+        const uint8_t* stored = data.data();
+        size_t stored_size = data.size();
+        uint32_t compression = siren::RESOURCE_COMPRESSION_NONE;
+        if (options.is_compression_enabled && data.size() >= PACK_MIN_COMPRESSION_SIZE) {
+            compressed.resize(siren::compression_lz4_bound(data.size()));
+            size_t compressed_size = siren::compression_lz4_compress(data.data(), data.size(), compressed.data(), compressed.size());
+            if (compressed_size != 0 && (double)compressed_size <= (double)data.size() * (1.0 - PACK_MIN_COMPRESSION_SAVING)) {
+                stored = compressed.data();
+                stored_size = compressed_size;
+                compression = siren::RESOURCE_COMPRESSION_LZ4;
+            }
+        }
+
+        pack_write_padding(output, &offset);
+        fwrite(stored, 1, stored_size, output);
+        pack_entry.entry = (siren::ResourceArchiveEntry) {
+            .path_hash = siren::resource_hash_path(pack_entry.path.c_str()),
+            .offset = offset,
+            .stored_size = stored_size,
+            .size = data.size(),
+            .path_offset = 0,
+            .compression = compression
+        };
+        offset += stored_size;
+        total_size += data.size();
+        total_stored_size += stored_size;
+
+        printf("%s %s %llu -> %llu\n", compression == siren::RESOURCE_COMPRESSION_LZ4 ? "lz4 " : "none", pack_entry.path.c_str(), (unsigned long long)data.size(), (unsigned long long)stored_size);
+        entries.push_back(pack_entry);
+    }
+
+    // Lookups binary search the table by hash
+    std::sort(entries.begin(), entries.end(), pack_entry_compare);
+    uint32_t path_offset = 0;
+    for (PackEntry& pack_entry : entries) {
+        pack_entry.entry.path_offset = path_offset;
+        path_offset += (uint32_t)pack_entry.path.size() + 1;
+    }
+
+    pack_write_padding(output, &offset);
+    header.entries_offset = offset;
+    for (const PackEntry& pack_entry : entries) {
+        fwrite(&pack_entry.entry, sizeof(pack_entry.entry), 1, output);
+    }
+    offset += entries.size() * sizeof(siren::ResourceArchiveEntry);
+
+    header.paths_offset = offset;
+    for (const PackEntry& pack_entry : entries) {
+        fwrite(pack_entry.path.c_str(), 1, pack_entry.path.size() + 1, output);
+    }
+    // An archive with no entries still needs its path table to end in a null
+    if (entries.empty()) {
+        fputc('\0', output);
+    }
+
+    memcpy(header.magic, siren::RESOURCE_ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = siren::RESOURCE_ARCHIVE_VERSION;
+    header.entry_count = (uint32_t)entries.size();
+    fseek(output, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, output);
+    fclose(output);
+
+    printf("Packed %u files into %s, %llu bytes stored from %llu\n", header.entry_count, options.output_path, (unsigned long long)total_stored_size, (unsigned long long)total_size);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    PackOptions options = (PackOptions) {
+        .input_path = NULL,
+        .output_path = NULL,
+        .is_compression_enabled = true
+    };
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--no-compress") == 0) {
+            options.is_compression_enabled = false;
+        } else if (argv[arg][0] != '-' && options.input_path == NULL) {
+            options.input_path = argv[arg];
+        } else if (argv[arg][0] != '-' && options.output_path == NULL) {
+            options.output_path = argv[arg];
+        } else {
+            options.input_path = NULL;
+            break;
+        }
+    }
+    if (options.input_path == NULL || options.output_path == NULL) {
+        printf("Usage: siren-pack resource_directory output.pak [--no-compress]\n");
+        return -1;
+    }
+
+    return pack_run(options) ? 0 : -1;
+}